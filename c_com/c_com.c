@@ -599,6 +599,39 @@ void      cComCloseFileHandle(SLONG *pHandle)
 }
 
 
+/*
+ *  Write downloaded bytes and add them to the digest of the file
+ */
+void      cComWriteDownload(FIL *pFile, UBYTE *pData, ULONG Bytes)
+{
+  if (write(pFile->File, pData, (size_t)Bytes) == (ssize_t)Bytes)
+  {
+    md5_process_bytes(pData, (size_t)Bytes, &(pFile->Md5));
+  }
+  else
+  {
+    pFile->Md5Valid  =  0;
+  }
+}
+
+
+/*
+ *  Close downloaded file and keep its digest for LIST_FILES
+ */
+void      cComCloseDownload(FIL *pFile)
+{
+  ULONG   Md5Sum[4];
+
+  if ((pFile->Md5Valid) && (pFile->File >= MIN_HANDLE))
+  {
+    md5_finish_ctx(&(pFile->Md5), Md5Sum);
+    cMd5CacheAdd(pFile->File, (unsigned char*)Md5Sum);
+  }
+  pFile->Md5Valid  =  0;
+  cComCloseFileHandle(&(pFile->File));
+}
+
+
 UBYTE     cComFreeHandle(DATA8 Handle)
 {
   UBYTE   RtnVal = FALSE;
@@ -995,7 +1028,10 @@ void      cComGetNameFromScandirList(struct  dirent *NameList, char *pBuffer, UL
       strcat(FileName,NameList->d_name);
 
       /* Get the MD5sum and put in the buffer */
-      // md5_file(FileName, 0, (unsigned char *)Md5Sum);
+      if (!cMd5CacheFile(FileName, (unsigned char *)Md5Sum))
+      {
+        memset(Md5Sum, 0, sizeof(Md5Sum));
+      }
       *pNameLen  = sprintf(pBuffer, "%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X ",
                           ((UBYTE*)Md5Sum)[0] , ((UBYTE*)Md5Sum)[1] , ((UBYTE*)Md5Sum)[2] , ((UBYTE*)Md5Sum)[3] ,
                           ((UBYTE*)Md5Sum)[4] , ((UBYTE*)Md5Sum)[5] , ((UBYTE*)Md5Sum)[6] , ((UBYTE*)Md5Sum)[7] ,
@@ -1023,8 +1059,10 @@ UBYTE     cComCheckForSpace(char *pFullName, ULONG Size)
   DATA32 TotalSize;
   DATA32 FreeSize;
   DATA8  Changed;
+  ULONG  Bytes;
 
   RtnVal = FAIL;
+  Bytes  = Size;
 
   //Make it KB and round up
   if (Size & (ULONG)(KB-1))
@@ -1061,8 +1099,9 @@ UBYTE     cComCheckForSpace(char *pFullName, ULONG Size)
     }
     else
     {
-      cMemoryGetUsage(&TotalSize, &FreeSize, 1);
-      if (FreeSize >= Size)
+      // Reserve the whole file up front so that the blocks that follow
+      // do not need to query the file system
+      if (OK == cMemoryReserveSpace((DATA32)Bytes))
       {
         RtnVal = OK;
       }
@@ -1153,6 +1192,9 @@ void      cComSystemCommand(RXBUF *pRxBuf, TXBUF *pTxBuf)
 
           if (pRxBuf->pFile->File >= 0)
           {
+            md5_init_ctx(&(pRxBuf->pFile->Md5));
+            pRxBuf->pFile->Md5Valid  =  1;
+
             MsgHeaderSize   =  (strlen((char*)pBeginDl->Path) + 1 + SIZEOF_BEGINDL); // +1 = zero termination
             pRxBuf->MsgLen  =  CmdSize + sizeof(CMDSIZE) - MsgHeaderSize;
 
@@ -1177,14 +1219,14 @@ void      cComSystemCommand(RXBUF *pRxBuf, TXBUF *pTxBuf)
               BytesToWrite      =  ComInstance.Files[FileHandle].Size;
             }
 
-            write(pRxBuf->pFile->File, &(pRxBuf->Buf[MsgHeaderSize]), (size_t)BytesToWrite);
+            cComWriteDownload(pRxBuf->pFile, &(pRxBuf->Buf[MsgHeaderSize]), BytesToWrite);
             ComInstance.Files[FileHandle].Length  +=  (ULONG)BytesToWrite;
             pRxBuf->RxBytes                        =  (ULONG)BytesToWrite;
             pRxBuf->pFile->Pointer                 =  (ULONG)BytesToWrite;
 
             if (pRxBuf->pFile->Pointer >= pRxBuf->pFile->Size)
             {
-              cComCloseFileHandle(&(pRxBuf->pFile->File));
+              cComCloseDownload(pRxBuf->pFile);
               chmod(ComInstance.Files[FileHandle].Name,FILEPERMISSIONS);
               cComFreeHandle(FileHandle);
 
@@ -1291,7 +1333,7 @@ void      cComSystemCommand(RXBUF *pRxBuf, TXBUF *pTxBuf)
             #endif
           }
 
-          write(ComInstance.Files[FileHandle].File, (pContiDl->PayLoad), (size_t)BytesToWrite);
+          cComWriteDownload(&(ComInstance.Files[FileHandle]), (pContiDl->PayLoad), BytesToWrite);
           pRxBuf->pFile->Pointer  +=  BytesToWrite;
           pRxBuf->RxBytes          =  BytesToWrite;
 
@@ -1305,7 +1347,7 @@ void      cComSystemCommand(RXBUF *pRxBuf, TXBUF *pTxBuf)
               printf("%s %lu bytes downloaded\n",ComInstance.Files[FileHandle].Name,(unsigned long)ComInstance.Files[FileHandle].Length);
             #endif
 
-            cComCloseFileHandle(&(ComInstance.Files[FileHandle].File));
+            cComCloseDownload(&(ComInstance.Files[FileHandle]));
             chmod(ComInstance.Files[FileHandle].Name,FILEPERMISSIONS);
             cComFreeHandle(FileHandle);
             pRplyContiDl->Status  =  END_OF_FILE;
@@ -2876,13 +2918,13 @@ void      cComUpdate(void)
             BytesToWrite  =  pRxBuf->BufSize;
           }
 
-          write(pRxBuf->pFile->File, pRxBuf->Buf, (size_t)BytesToWrite);
+          cComWriteDownload(pRxBuf->pFile, pRxBuf->Buf, (ULONG)BytesToWrite);
           pRxBuf->pFile->Pointer  +=  (ULONG)BytesToWrite;
           pRxBuf->RxBytes         +=  (ULONG)BytesToWrite;
 
           if (pRxBuf->pFile->Pointer >= pRxBuf->pFile->Size)
           {
-            cComCloseFileHandle(&(pRxBuf->pFile->File));
+            cComCloseDownload(pRxBuf->pFile);
             chmod(pRxBuf->pFile->Name, FILEPERMISSIONS);
             cComFreeHandle(pRxBuf->FileHandle);
           }
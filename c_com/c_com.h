@@ -27,6 +27,7 @@
 
 
 #include  "lms2012.h"
+#include  "c_md5.h"
 
 /*! \page communication Communication
 
@@ -1477,6 +1478,9 @@ typedef   struct
   ULONG   Length;                       //!< Total download length
   ULONG   Pointer;                      //!<
   UWORD   State;
+
+  struct  md5_ctx Md5;                  //!< Digest of bytes downloaded so far
+  UBYTE   Md5Valid;                     //!< All bytes went into file and digest
 }FIL;
 
 
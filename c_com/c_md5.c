@@ -32,21 +32,6 @@
 #include  <fcntl.h>
 
 
-typedef u_int32_t md5_uint32;
-
-/* Structure to save state of computation between the single steps.  */
-struct md5_ctx
-{
-  md5_uint32 A;
-  md5_uint32 B;
-  md5_uint32 C;
-  md5_uint32 D;
-
-  md5_uint32 total[2];
-  md5_uint32 buflen;
-  char buffer[128];
-};
-
 #define SWAP(n) (n)
 
 /* This array contains the bytes used to pad the buffer to the next
@@ -255,9 +240,22 @@ void md5_process_bytes(const void *buffer, size_t len, struct md5_ctx *ctx)
   /* Process available complete blocks.  */
   if (len > 64)
   {
-    md5_process_block(buffer, len & ~63, ctx);
-    buffer = (const char *) buffer + (len & ~63);
-    len   &= 63;
+    if (((size_t) buffer) % __alignof__ (md5_uint32) != 0)
+    {
+      /* Blocks are read as words - copy unaligned data first.  */
+      while (len > 64)
+      {
+        md5_process_block(memcpy(ctx->buffer, buffer, 64), 64, ctx);
+        buffer = (const char *) buffer + 64;
+        len   -= 64;
+      }
+    }
+    else
+    {
+      md5_process_block(buffer, len & ~63, ctx);
+      buffer = (const char *) buffer + (len & ~63);
+      len   &= 63;
+    }
   }
 
   /* Move remaining bytes in internal buffer.  */
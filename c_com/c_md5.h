@@ -25,6 +25,30 @@
 #define   MD5LEN                      32
 
 
+#include <sys/types.h>
+
+typedef u_int32_t md5_uint32;
+
+/* Structure to save state of computation between the single steps.  */
+struct md5_ctx
+{
+  md5_uint32 A;
+  md5_uint32 B;
+  md5_uint32 C;
+  md5_uint32 D;
+
+  md5_uint32 total[2];
+  md5_uint32 buflen;
+  char buffer[128];
+};
+
+
+void md5_init_ctx(struct md5_ctx *ctx);
+
+void md5_process_bytes(const void *buffer, size_t len, struct md5_ctx *ctx);
+
+void *md5_finish_ctx(struct md5_ctx *ctx, void *resbuf);
+
 int md5_file(char *filename, int binary, unsigned char *md5_result);
 
 
@@ -0,0 +1,273 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ *  NXT color sensor
+ *
+ *  The driver puts the raw values and the calibration read from the sensor
+ *  in shared memory (COLORSTRUCT). Calibration is fixed point (32 bit
+ *  multiply and shift) and the color is found with integer compares only.
+ *
+ *  Kept apart from c_input.c so the color can be checked against the old
+ *  floating point version on the host, see lmssrc/adk/colorcheck.
+ */
+
+
+#include  "c_color.h"
+
+#ifndef DISABLE_OLD_COLOR
+
+#define   FALSE                         0
+#define   TRUE                          1
+
+#define   SENSOR_RESOLUTION             1023L
+
+/* Remember this is ARM AD converter  - 3,3 VDC as max voltage      */
+/* When in color mode background value is substracted => min = 0!!! */
+#define   AD_MAX                        2703L
+#define   AD_FS                         3300L
+
+#define   COLORSENSORBGMIN              (214/(AD_FS/AD_MAX))
+#define   COLORSENSORMIN                (1L/(AD_FS/AD_MAX)) /* 1 inserted else div 0 (1L/(120/AD_MAX)) */
+#define   COLORSENSORMAX                ((AD_MAX * AD_FS)/3300)
+#define   COLORSENSORPCTDYN             (UBYTE)(((COLORSENSORMAX - COLORSENSORMIN) * 100L)/AD_MAX)
+#define   COLORSENSORBGPCTDYN           (UBYTE)(((COLORSENSORMAX - COLORSENSORBGMIN) * 100L)/AD_MAX)
+
+static void cColorCalcFullScale(UWORD *pRawVal, UWORD ZeroPointOffset,
+                                UBYTE PctFullScale, UBYTE InvStatus)
+{
+  if (*pRawVal >= ZeroPointOffset)
+  {
+    *pRawVal -= ZeroPointOffset;
+  }
+  else
+  {
+    *pRawVal = 0;
+  }
+
+  *pRawVal = (*pRawVal * 100)/PctFullScale;
+  if (*pRawVal > SENSOR_RESOLUTION)
+  {
+    *pRawVal = SENSOR_RESOLUTION;
+  }
+  if (TRUE == InvStatus)
+  {
+    *pRawVal = SENSOR_RESOLUTION - *pRawVal;
+  }
+}
+
+/*! \brief    Calibrate raw values from NXT color sensor
+ *
+ *  pC->ADRaw is calibrated with the calibration range picked by the
+ *  background value (BLANK) into pNewVals
+ */
+void      cColorCalibrate(COLORSTRUCT *pC, UWORD *pNewVals)
+{
+  UBYTE CalRange;
+
+  if ((pC->ADRaw[BLANK]) < pC->CalLimits[1])
+  {
+    CalRange = 2;
+  }
+  else
+  {
+    if ((pC->ADRaw[BLANK]) < pC->CalLimits[0])
+    {
+      CalRange = 1;
+    }
+    else
+    {
+      CalRange = 0;
+    }
+  }
+
+  pNewVals[RED] = 0;
+  if ((pC->ADRaw[RED]) > (pC->ADRaw[BLANK]))
+  {
+    pNewVals[RED] = (UWORD)(((ULONG)((pC->ADRaw[RED]) - (pC->ADRaw[BLANK])) * (pC->Calibration[CalRange][RED])) >> 16);
+  }
+
+  pNewVals[GREEN] = 0;
+  if ((pC->ADRaw[GREEN]) > (pC->ADRaw[BLANK]))
+  {
+     pNewVals[GREEN] = (UWORD)(((ULONG)((pC->ADRaw[GREEN]) - (pC->ADRaw[BLANK])) * (pC->Calibration[CalRange][GREEN])) >> 16);
+  }
+
+  pNewVals[BLUE] = 0;
+  if ((pC->ADRaw[BLUE]) > (pC->ADRaw[BLANK]))
+  {
+    pNewVals[BLUE] = (UWORD)(((ULONG)((pC->ADRaw[BLUE]) -(pC->ADRaw[BLANK])) * (pC->Calibration[CalRange][BLUE])) >> 16);
+  }
+
+  pNewVals[BLANK] = (pC->ADRaw[BLANK]);
+  cColorCalcFullScale(&(pNewVals[BLANK]), COLORSENSORBGMIN, COLORSENSORBGPCTDYN, FALSE);
+  (pNewVals[BLANK]) = (UWORD)(((ULONG)(pNewVals[BLANK]) * (pC->Calibration[CalRange][BLANK])) >> 16);
+}
+
+/*! \brief    Find color from calibrated NXT color sensor values
+ *
+ *  \return   Color from pC->SensorRaw (BLACKCOLOR..WHITECOLOR or DATA8_NAN)
+ */
+DATA8     cColorCalculate(COLORSTRUCT *pC)
+{
+  DATA8   Result ;
+
+
+  Result  =  DATA8_NAN;
+
+  // Color Sensor values has been calculated -
+  // now calculate the color and put it in Sensor value
+  if (((pC->SensorRaw[RED]) > (pC->SensorRaw[BLUE] )) &&
+      ((pC->SensorRaw[RED]) > (pC->SensorRaw[GREEN])))
+  {
+
+    // If all 3 colors are less than 65 OR (Less that 110 and bg less than 40)
+    if (((pC->SensorRaw[RED])   < 65) ||
+        (((pC->SensorRaw[BLANK]) < 40) && ((pC->SensorRaw[RED])  < 110)))
+    {
+      Result  =  BLACKCOLOR;
+    }
+    else
+    {
+      if (((((pC->SensorRaw[BLUE]) >> 2)  + ((pC->SensorRaw[BLUE]) >> 3) + (pC->SensorRaw[BLUE])) < (pC->SensorRaw[GREEN])) &&
+          ((((pC->SensorRaw[GREEN]) << 1)) > (pC->SensorRaw[RED])))
+      {
+        Result  =  YELLOWCOLOR;
+      }
+      else
+      {
+
+        if ((((pC->SensorRaw[GREEN]) << 1) - ((pC->SensorRaw[GREEN]) >> 2)) < (pC->SensorRaw[RED]))
+        {
+
+          Result  =  REDCOLOR;
+        }
+        else
+        {
+
+          if ((((pC->SensorRaw[BLUE]) < 70) ||
+              ((pC->SensorRaw[GREEN]) < 70)) ||
+             (((pC->SensorRaw[BLANK]) < 140) && ((pC->SensorRaw[RED]) < 140)))
+          {
+            Result  =  BLACKCOLOR;
+          }
+          else
+          {
+            Result  =  WHITECOLOR;
+          }
+        }
+      }
+    }
+  }
+  else
+  {
+
+    // Red is not the dominant color
+    if ((pC->SensorRaw[GREEN]) > (pC->SensorRaw[BLUE]))
+    {
+
+      // Green is the dominant color
+      // If all 3 colors are less than 40 OR (Less that 70 and bg less than 20)
+      if (((pC->SensorRaw[GREEN])  < 40) ||
+          (((pC->SensorRaw[BLANK]) < 30) && ((pC->SensorRaw[GREEN])  < 70)))
+      {
+        Result  =  BLACKCOLOR;
+      }
+      else
+      {
+        if ((((pC->SensorRaw[BLUE]) << 1)) < (pC->SensorRaw[RED]))
+        {
+          Result  =  YELLOWCOLOR;
+        }
+        else
+        {
+          if ((((pC->SensorRaw[RED]) + ((pC->SensorRaw[RED])>>2)) < (pC->SensorRaw[GREEN])) ||
+              (((pC->SensorRaw[BLUE]) + ((pC->SensorRaw[BLUE])>>2)) < (pC->SensorRaw[GREEN])))
+          {
+            Result  =  GREENCOLOR;
+          }
+          else
+          {
+            if ((((pC->SensorRaw[RED]) < 70) ||
+                ((pC->SensorRaw[BLUE]) < 70)) ||
+                (((pC->SensorRaw[BLANK]) < 140) && ((pC->SensorRaw[GREEN]) < 140)))
+            {
+              Result  =  BLACKCOLOR;
+            }
+            else
+            {
+              Result  =  WHITECOLOR;
+            }
+          }
+        }
+      }
+    }
+    else
+    {
+
+      // Blue is the most dominant color
+      // Colors can be blue, white or black
+      // If all 3 colors are less than 48 OR (Less that 85 and bg less than 25)
+      if (((pC->SensorRaw[BLUE])   < 48) ||
+          (((pC->SensorRaw[BLANK]) < 25) && ((pC->SensorRaw[BLUE])  < 85)))
+      {
+        Result  =  BLACKCOLOR;
+      }
+      else
+      {
+        if ((((((pC->SensorRaw[RED]) * 48) >> 5) < (pC->SensorRaw[BLUE])) &&
+            ((((pC->SensorRaw[GREEN]) * 48) >> 5) < (pC->SensorRaw[BLUE])))
+            ||
+            (((((pC->SensorRaw[RED])   * 58) >> 5) < (pC->SensorRaw[BLUE])) ||
+             ((((pC->SensorRaw[GREEN]) * 58) >> 5) < (pC->SensorRaw[BLUE]))))
+        {
+          Result  =  BLUECOLOR;
+        }
+        else
+        {
+
+          // Color is white or Black
+          if ((((pC->SensorRaw[RED])  < 60) ||
+              ((pC->SensorRaw[GREEN]) < 60)) ||
+             (((pC->SensorRaw[BLANK]) < 110) && ((pC->SensorRaw[BLUE]) < 120)))
+          {
+            Result  =  BLACKCOLOR;
+          }
+          else
+          {
+            if ((((pC->SensorRaw[RED])  + ((pC->SensorRaw[RED])   >> 3)) < (pC->SensorRaw[BLUE])) ||
+                (((pC->SensorRaw[GREEN]) + ((pC->SensorRaw[GREEN]) >> 3)) < (pC->SensorRaw[BLUE])))
+            {
+              Result  =  BLUECOLOR;
+            }
+            else
+            {
+              Result  =  WHITECOLOR;
+            }
+          }
+        }
+      }
+    }
+  }
+
+
+  return (Result);
+}
+
+#endif
@@ -98,6 +98,7 @@
 #include <math.h>
 #include "lms2012.h"
 #include "c_input.h"
+#include "c_color.h"
 #include "c_output.h"
 #include "c_ui.h"
 #include "c_com.h"
@@ -407,10 +408,99 @@ static RESULT cInputGetIicString(DATA8 Type, DATA8 Mode, IICSTR *IicStr)
   return (Result);
 }
 
+/*
+ *  "TypeData" lookup
+ *
+ *  Entries are found directly from type and mode through TypeFirst. Entries
+ *  with same type and mode (different connections) are chained through
+ *  TypeNext in table order so the first one found is the same as when
+ *  searching the table from the start. TypeLast is used if the mode is not
+ *  found.
+ */
+static void cInputIndexTypeData(UWORD Index, DATA8 Type, DATA8 Mode)
+{
+  UWORD   *pLink;
+
+  InputInstance.TypeNext[Index]  =  TYPE_INDEX_NONE;
+
+  if ((Type >= 0) && (Type < (MAX_DEVICE_TYPE + 1)))
+  { // Type valid
+
+    if ((Mode >= 0) && (Mode < MAX_DEVICE_MODES))
+    { // Mode valid - append to chain
+
+      pLink  =  &InputInstance.TypeFirst[Type][Mode];
+      while (*pLink != TYPE_INDEX_NONE)
+      {
+        pLink  =  &InputInstance.TypeNext[*pLink];
+      }
+      *pLink  =  Index;
+    }
+    InputInstance.TypeLast[Type]  =  Index;
+  }
+}
+
+static void cInputIndexAllTypeData(void)
+{
+  UWORD   Index;
+
+  memset(InputInstance.TypeFirst,0xFF,sizeof(InputInstance.TypeFirst));
+  memset(InputInstance.TypeLast,0xFF,sizeof(InputInstance.TypeLast));
+
+  for (Index = 0;Index < InputInstance.MaxDeviceTypes;Index++)
+  {
+    cInputIndexTypeData(Index,InputInstance.TypeData[Index].Type,InputInstance.TypeData[Index].Mode);
+  }
+}
+
+static UWORD cInputLookupTypeData(DATA8 Type, DATA8 Mode)
+{
+  UWORD   Index = TYPE_INDEX_NONE;
+
+  if ((Type >= 0) && (Type < (MAX_DEVICE_TYPE + 1)) && (Mode >= 0) && (Mode < MAX_DEVICE_MODES))
+  { // Type and mode valid
+
+    Index  =  InputInstance.TypeFirst[Type][Mode];
+  }
+
+  return (Index);
+}
+
+static RESULT cInputGrowTypeData(UWORD Entries)
+{
+  RESULT  Result = OK;
+  UWORD   Size;
+  void    *pTmp;
+
+  if (Entries > InputInstance.TypeDataSize)
+  { // Table full - allocate in whole chunks
+
+    Result  =  FAIL;
+    Size    =  ((Entries + TYPE_DATA_CHUNK - 1) / TYPE_DATA_CHUNK) * TYPE_DATA_CHUNK;
+    if (Size > MAX_DEVICE_TYPES)
+    {
+      Size  =  MAX_DEVICE_TYPES;
+    }
+    if (cMemoryRealloc((void*)InputInstance.TypeData,&pTmp,(DATA32)(sizeof(TYPES) * Size)) == OK)
+    {
+      InputInstance.TypeData  =  (TYPES*)pTmp;
+
+      if (cMemoryRealloc((void*)InputInstance.TypeNext,&pTmp,(DATA32)(sizeof(UWORD) * Size)) == OK)
+      {
+        InputInstance.TypeNext      =  (UWORD*)pTmp;
+        InputInstance.TypeDataSize  =  Size;
+        Result  =  OK;
+      }
+    }
+  }
+
+  return (Result);
+}
+
 static RESULT cInputChangeTypeData(DATA8 Type, DATA8 Mode, DATA8 NewType, DATA8 NewMode)
 {
   RESULT  Result    = FAIL;  // FAIL=Not found, OK=changed
-  UWORD   Index     = 0;
+  UWORD   Index;
 
   if ((Type >= 0) && (Type < (MAX_DEVICE_TYPE + 1)) && (Mode >= 0) && (Mode < MAX_DEVICE_MODES))
   { // Type and mode valid
@@ -418,18 +508,16 @@ static RESULT cInputChangeTypeData(DATA8 Type, DATA8 Mode, DATA8 NewType, DATA8
     if ((NewType >= 0) && (NewType < (MAX_DEVICE_TYPE + 1)) && (NewMode >= 0) && (NewMode < MAX_DEVICE_MODES))
     { // Type and mode valid
 
-      while ((Index < InputInstance.MaxDeviceTypes) && (Result != OK))
-      { // trying to find device type
-
-        if ((InputInstance.TypeData[Index].Type == Type) && (InputInstance.TypeData[Index].Mode == Mode))
-        { // match on type and mode
+      Index  =  cInputLookupTypeData(Type,Mode);
+      if (Index != TYPE_INDEX_NONE)
+      { // match on type and mode
 
-          InputInstance.TypeData[Index].Type  =  NewType;
-          InputInstance.TypeData[Index].Mode  =  NewMode;
+        InputInstance.TypeData[Index].Type  =  NewType;
+        InputInstance.TypeData[Index].Mode  =  NewMode;
+        cInputIndexAllTypeData();
+        InputInstance.ScaleVersion++;
 
-          Result    =  OK;
-        }
-        Index++;
+        Result    =  OK;
       }
     }
   }
@@ -441,23 +529,24 @@ static RESULT cInputGetNewTypeDataPointer(SBYTE *pName, DATA8 Type, DATA8 Mode,
                                           DATA8 Connection, TYPES **ppPlace)
 {
   RESULT  Result    = FAIL;  // FAIL=full, OK=new, BUSY=found
-  UWORD   Index     = 0;
+  UWORD   Index;
 
   *ppPlace  =  NULL;
 
   if ((Type >= 0) && (Type < (MAX_DEVICE_TYPE + 1)) && (Mode >= 0) && (Mode < MAX_DEVICE_MODES))
   { // Type and mode valid
 
-    while ((Index < InputInstance.MaxDeviceTypes) && (Result != BUSY))
+    Index  =  InputInstance.TypeFirst[Type][Mode];
+    while ((Index != TYPE_INDEX_NONE) && (Result != BUSY))
     { // trying to find device type
 
-      if ((InputInstance.TypeData[Index].Type == Type) && (InputInstance.TypeData[Index].Mode == Mode) && (InputInstance.TypeData[Index].Connection == Connection))
+      if (InputInstance.TypeData[Index].Connection == Connection)
       { // match on type, mode and connection
 
         *ppPlace  =  &InputInstance.TypeData[Index];
         Result    =  BUSY;
       }
-      Index++;
+      Index  =  InputInstance.TypeNext[Index];
     }
     if (Result != BUSY)
     { // device type not found
@@ -465,12 +554,12 @@ static RESULT cInputGetNewTypeDataPointer(SBYTE *pName, DATA8 Type, DATA8 Mode,
       if (InputInstance.MaxDeviceTypes < MAX_DEVICE_TYPES)
       { // Allocate room for a new type/mode
 
-        if (cMemoryRealloc((void*)InputInstance.TypeData,(void**)ppPlace,(DATA32)(sizeof(TYPES) * (InputInstance.MaxDeviceTypes + 1))) == OK)
+        if (cInputGrowTypeData(InputInstance.MaxDeviceTypes + 1) == OK)
         { // Success
 
-          InputInstance.TypeData  =  *ppPlace;
-
-          *ppPlace  =  &InputInstance.TypeData[InputInstance.MaxDeviceTypes];
+          Index     =  InputInstance.MaxDeviceTypes;
+          *ppPlace  =  &InputInstance.TypeData[Index];
+          cInputIndexTypeData(Index,Type,Mode);
           InputInstance.TypeModes[Type]++;
           InputInstance.MaxDeviceTypes++;
           Result    =  OK;
@@ -539,6 +628,7 @@ static RESULT cInputInsertTypeData(char *pTypeDataString, DATA8 Force)
     if ((Result == OK) || ((Force) && (Result == BUSY)))
     {
       (*pTypes)  =  Tmp;
+      InputInstance.ScaleVersion++;
 
       Count  =  0;
       while ((Name[Count]) && (Count < TYPE_NAME_LENGTH))
@@ -626,11 +716,166 @@ static RESULT cInputInsertTypeDataFile(char *pFilename)
   return (Result);
 }
 
+static void cInputTypeDataFilename(int Number, char *pFilename)
+{
+  if (Number == 0)
+  {
+    snprintf(pFilename,vmFILENAMESIZE,"%s/%s%s",vmSETTINGS_DIR,TYPEDATE_FILE_NAME,EXT_CONFIG);
+  }
+  else
+  {
+    snprintf(pFilename,vmFILENAMESIZE,"%s/%s%02d%s",vmSETTINGS_DIR,TYPEDATE_FILE_NAME,Number,EXT_CONFIG);
+  }
+}
+
+static DATA8 cInputStampTypeDbSource(int Number, TYPEDBSOURCE *pSource)
+{
+  char    Filename[vmFILENAMESIZE];
+  struct  stat Status;
+  DATA8   Found = 0;
+
+  cInputTypeDataFilename(Number,Filename);
+  if (stat(Filename,&Status) == 0)
+  {
+    memset(pSource,0,sizeof(TYPEDBSOURCE));
+    (*pSource).Number  =  (ULONG)Number;
+    (*pSource).Size    =  (ULONG)Status.st_size;
+    (*pSource).Time    =  (ULONG)Status.st_mtim.tv_sec;
+    (*pSource).TimeNs  =  (ULONG)Status.st_mtim.tv_nsec;
+    Found  =  1;
+  }
+
+  return (Found);
+}
+
+static DATA8 cInputGetTypeDbSources(TYPEDBSOURCE *pSource)
+{
+  DATA8   Sources;
+  int     Number;
+
+  Sources  =  cInputStampTypeDbSource(0,&pSource[0]);
+  for (Number = TYPE_THIRD_PARTY_START;Number <= TYPE_THIRD_PARTY_END;Number++)
+  {
+    Sources +=  cInputStampTypeDbSource(Number,&pSource[Sources]);
+  }
+
+  return (Sources);
+}
+
+static RESULT cInputLoadTypeDb(TYPEDBSOURCE *pSource, DATA8 Sources)
+{
+  RESULT  Result = FAIL;
+  char    Filename[vmFILENAMESIZE];
+  struct  stat Status;
+  int     hFile;
+  UBYTE   *pDb;
+  TYPEDBHEAD *pHead;
+  TYPES   *pTypes;
+  IICSTR  *pIic;
+  void    *pTmp;
+  UWORD   Index;
+
+  snprintf(Filename,vmFILENAMESIZE,"%s/%s",vmSETTINGS_DIR,TYPEDB_FILE_NAME);
+  hFile  =  open(Filename,O_RDONLY);
+  if (hFile >= MIN_HANDLE)
+  {
+    if ((fstat(hFile,&Status) == 0) && (Status.st_size >= (off_t)sizeof(TYPEDBHEAD)))
+    {
+      pDb  =  (UBYTE*)mmap(NULL,(size_t)Status.st_size,PROT_READ,MAP_PRIVATE,hFile,0);
+      if (pDb != MAP_FAILED)
+      {
+        pHead   =  (TYPEDBHEAD*)pDb;
+
+        if (((*pHead).Magic == TYPEDB_MAGIC) && ((*pHead).Version == TYPEDB_VERSION) && ((*pHead).TypeSize == sizeof(TYPES)) && ((*pHead).IicSize == sizeof(IICSTR)) && ((*pHead).Sources == (ULONG)Sources) && ((*pHead).Types >= InputInstance.MaxDeviceTypes) && ((*pHead).Types <= MAX_DEVICE_TYPES) && ((*pHead).IicTypes > 0) && ((*pHead).IicTypes <= MAX_DEVICE_TYPES))
+        { // Header valid
+
+          if ((Status.st_size == (off_t)(sizeof(TYPEDBHEAD) + (*pHead).Sources * sizeof(TYPEDBSOURCE) + (*pHead).Types * sizeof(TYPES) + (*pHead).IicTypes * sizeof(IICSTR))) && (memcmp(&pDb[sizeof(TYPEDBHEAD)],pSource,(size_t)Sources * sizeof(TYPEDBSOURCE)) == 0))
+          { // Built from the files there are now
+
+            pTypes  =  (TYPES*)&pDb[sizeof(TYPEDBHEAD) + (*pHead).Sources * sizeof(TYPEDBSOURCE)];
+            pIic    =  (IICSTR*)&pTypes[(*pHead).Types];
+
+            if ((cInputGrowTypeData((UWORD)(*pHead).Types) == OK) && (cMemoryRealloc((void*)InputInstance.IicString,&pTmp,(DATA32)(sizeof(IICSTR) * (*pHead).IicTypes)) == OK))
+            {
+              InputInstance.IicString  =  (IICSTR*)pTmp;
+
+              memcpy(InputInstance.TypeData,pTypes,(size_t)(*pHead).Types * sizeof(TYPES));
+              memcpy(InputInstance.IicString,pIic,(size_t)(*pHead).IicTypes * sizeof(IICSTR));
+              InputInstance.MaxDeviceTypes  =  (UWORD)(*pHead).Types;
+              InputInstance.IicDeviceTypes  =  (UWORD)(*pHead).IicTypes;
+
+              memset(InputInstance.TypeModes,0,sizeof(InputInstance.TypeModes));
+              for (Index = 0;Index < InputInstance.MaxDeviceTypes;Index++)
+              {
+                if ((InputInstance.TypeData[Index].Type >= 0) && (InputInstance.TypeData[Index].Type < (MAX_DEVICE_TYPE + 1)))
+                {
+                  InputInstance.TypeModes[InputInstance.TypeData[Index].Type]++;
+                }
+              }
+              cInputIndexAllTypeData();
+
+              Result  =  OK;
+            }
+          }
+        }
+        munmap(pDb,(size_t)Status.st_size);
+      }
+    }
+    close(hFile);
+  }
+
+  return (Result);
+}
+
+static void cInputSaveTypeDb(TYPEDBSOURCE *pSource, DATA8 Sources)
+{
+  char    Filename[vmFILENAMESIZE];
+  char    TmpName[vmFILENAMESIZE];
+  int     hFile;
+  TYPEDBHEAD Head;
+  RESULT  Result = FAIL;
+
+  snprintf(Filename,vmFILENAMESIZE,"%s/%s",vmSETTINGS_DIR,TYPEDB_FILE_NAME);
+  if (snprintf(TmpName,vmFILENAMESIZE,"%s.tmp",Filename) < vmFILENAMESIZE)
+  {
+    // Replace old database in one step so a crash never leaves half a file
+    hFile  =  open(TmpName,O_CREAT | O_WRONLY | O_TRUNC,FILEPERMISSIONS);
+    if (hFile >= MIN_HANDLE)
+    {
+      Head.Magic     =  TYPEDB_MAGIC;
+      Head.Version   =  TYPEDB_VERSION;
+      Head.TypeSize  =  sizeof(TYPES);
+      Head.IicSize   =  sizeof(IICSTR);
+      Head.Sources   =  (ULONG)Sources;
+      Head.Types     =  (ULONG)InputInstance.MaxDeviceTypes;
+      Head.IicTypes  =  (ULONG)InputInstance.IicDeviceTypes;
+
+      if ((write(hFile,&Head,sizeof(Head)) == sizeof(Head)) && (write(hFile,pSource,(size_t)Sources * sizeof(TYPEDBSOURCE)) == (ssize_t)(Sources * sizeof(TYPEDBSOURCE))))
+      {
+        if ((write(hFile,InputInstance.TypeData,(size_t)Head.Types * sizeof(TYPES)) == (ssize_t)(Head.Types * sizeof(TYPES))) && (write(hFile,InputInstance.IicString,(size_t)Head.IicTypes * sizeof(IICSTR)) == (ssize_t)(Head.IicTypes * sizeof(IICSTR))))
+        {
+          if (fsync(hFile) == 0)
+          {
+            Result  =  OK;
+          }
+        }
+      }
+      close(hFile);
+      if ((Result != OK) || (rename(TmpName,Filename) != 0))
+      {
+        remove(TmpName);
+      }
+    }
+  }
+}
+
 static void cInputTypeDataInit(void)
 {
   char    PrgNameBuf[255];
   UWORD   Index   = 0;
   UBYTE   TypeDataFound = 0;
+  TYPEDBSOURCE Source[TYPEDB_SOURCES];
+  DATA8   Sources;
 
   // Set TypeMode to mode = 0
   Index  =  0;
@@ -659,22 +904,34 @@ static void cInputTypeDataInit(void)
     InputInstance.TypeModes[InputInstance.TypeData[Index].Type]++;
     Index++;
   }
+  cInputIndexAllTypeData();
 
 //  printf("Search start\n");
-  snprintf(PrgNameBuf,vmFILENAMESIZE,"%s/%s%s",vmSETTINGS_DIR,TYPEDATE_FILE_NAME,EXT_CONFIG);
-
-  if (cInputInsertTypeDataFile(PrgNameBuf) == OK)
+  Sources  =  cInputGetTypeDbSources(Source);
+  if ((Sources > 0) && (cInputLoadTypeDb(Source,Sources) == OK))
   {
     TypeDataFound  =  1;
   }
-
-  for (Index = TYPE_THIRD_PARTY_START;Index <= TYPE_THIRD_PARTY_END;Index++)
+  else
   {
-    snprintf(PrgNameBuf,vmFILENAMESIZE,"%s/%s%02d%s",vmSETTINGS_DIR,TYPEDATE_FILE_NAME,Index,EXT_CONFIG);
+    cInputTypeDataFilename(0,PrgNameBuf);
     if (cInputInsertTypeDataFile(PrgNameBuf) == OK)
     {
       TypeDataFound  =  1;
     }
+
+    for (Index = TYPE_THIRD_PARTY_START;Index <= TYPE_THIRD_PARTY_END;Index++)
+    {
+      cInputTypeDataFilename(Index,PrgNameBuf);
+      if (cInputInsertTypeDataFile(PrgNameBuf) == OK)
+      {
+        TypeDataFound  =  1;
+      }
+    }
+    if (TypeDataFound)
+    {
+      cInputSaveTypeDb(Source,Sources);
+    }
   }
 //  printf("Done\n");
 
@@ -764,6 +1021,142 @@ static RESULT cInputSetupDevice(DATA8 Device, DATA8 Repeat, DATA16 Time, DATA8 W
 }
 
 
+static void cInputClearIicQueues(void)
+{
+  DATA8   Port;
+  DATA8   Slot;
+
+  memset(InputInstance.IicQueue,0,sizeof(InputInstance.IicQueue));
+  for (Port = 0;Port < INPUT_PORTS;Port++)
+  {
+    for (Slot = 0;Slot < IIC_QUEUE_SIZE;Slot++)
+    {
+      InputInstance.IicQueue[Port].Trans[Slot].Id  =  -1;
+    }
+  }
+}
+
+/*! \brief    Queue IIC transaction on device
+ *
+ *  A transaction equal to one still waiting for the bus is not queued again
+ *  - the id of the waiting one is returned so reads asked for by more than
+ *  one thread only run once.
+ *
+ *  \return   Transaction id (-1 = not an IIC device or queue full)
+ */
+static DATA16 cInputQueueIic(DATA8 Device, DATA8 WrLng, DATA8 *pWrData, DATA8 RdLng)
+{
+  DATA16  Id = -1;
+  IICQUEUE *pQueue;
+  IICTRANS *pTrans;
+  UWORD   Tmp;
+
+  if ((Device >= 0) && (Device < INPUT_PORTS) && (InputInstance.DeviceData[Device].Connection == CONN_NXT_IIC))
+  {
+    if (WrLng < 0)
+    {
+      WrLng  =  0;
+    }
+    if (WrLng > MAX_DEVICE_DATALENGTH)
+    {
+      WrLng  =  MAX_DEVICE_DATALENGTH;
+    }
+    if (RdLng > MAX_DEVICE_DATALENGTH)
+    {
+      RdLng  =  MAX_DEVICE_DATALENGTH;
+    }
+    if (RdLng < -MAX_DEVICE_DATALENGTH)
+    {
+      RdLng  =  -MAX_DEVICE_DATALENGTH;
+    }
+
+    pQueue  =  &InputInstance.IicQueue[Device];
+
+    for (Tmp = (*pQueue).Out;(Tmp != (*pQueue).In) && (Id < 0);Tmp = (Tmp + 1) & IIC_ID_MASK)
+    { // Look for same transaction waiting
+
+      pTrans  =  &(*pQueue).Trans[Tmp & (IIC_QUEUE_SIZE - 1)];
+      if ((!(*pTrans).Started) && ((*pTrans).WrLng == WrLng) && ((*pTrans).RdLng == RdLng) && (memcmp((*pTrans).WrData,pWrData,(size_t)WrLng) == 0))
+      {
+        Id  =  (*pTrans).Id;
+      }
+    }
+
+    if ((Id < 0) && (((*pQueue).In - (*pQueue).Out) & IIC_ID_MASK) < IIC_QUEUE_SIZE)
+    {
+      pTrans                =  &(*pQueue).Trans[(*pQueue).In & (IIC_QUEUE_SIZE - 1)];
+      (*pTrans).Id          =  (DATA16)(*pQueue).In;
+      (*pTrans).Result      =  BUSY;
+      (*pTrans).Started     =  0;
+      (*pTrans).WrLng       =  WrLng;
+      (*pTrans).RdLng       =  RdLng;
+      (*pTrans).Time        =  0;
+      Memcpy((*pTrans).WrData,pWrData,WrLng);
+
+      Id                    =  (*pTrans).Id;
+      (*pQueue).In          =  ((*pQueue).In + 1) & IIC_ID_MASK;
+    }
+  }
+
+  return (Id);
+}
+
+/*! \brief    Get queued IIC transaction
+ *
+ *  \return   Transaction (NULL = id unknown or transaction pushed out of queue)
+ */
+static IICTRANS* cInputGetIicTrans(DATA8 Device, DATA16 Id)
+{
+  IICTRANS *pTrans = NULL;
+
+  if ((Device >= 0) && (Device < INPUT_PORTS) && (Id >= 0))
+  {
+    pTrans  =  &InputInstance.IicQueue[Device].Trans[Id & (IIC_QUEUE_SIZE - 1)];
+    if ((*pTrans).Id != Id)
+    {
+      pTrans  =  NULL;
+    }
+  }
+
+  return (pTrans);
+}
+
+/*! \brief    Let IIC transaction queued on device progress
+ *
+ *  Called for all ports from the input update and for the port a thread
+ *  waits for when the thread is run
+ */
+static void cInputServiceIicQueue(DATA8 Device)
+{
+  IICQUEUE *pQueue;
+  IICTRANS *pTrans;
+  RESULT  Result;
+
+  pQueue  =  &InputInstance.IicQueue[Device];
+
+  if ((*pQueue).Out != (*pQueue).In)
+  {
+    pTrans             =  &(*pQueue).Trans[(*pQueue).Out & (IIC_QUEUE_SIZE - 1)];
+    (*pTrans).Started  =  1;
+    Result             =  BUSY;
+
+    cInputSetupDevice(Device,1,0,(*pTrans).WrLng,(*pTrans).WrData,(*pTrans).RdLng,(*pTrans).RdData,&Result);
+
+    if (Result != BUSY)
+    { // Transaction done - start next on next service
+
+      (*pTrans).Result  =  Result;
+      (*pTrans).Time    =  GetTimeMS();
+      (*pQueue).Out     =  ((*pQueue).Out + 1) & IIC_ID_MASK;
+
+#ifdef DEBUG_C_INPUT
+      printf("c_input   cInputServiceIicQueue: D=%-3d Id=%-5d R=%d\n",Device,(*pTrans).Id,Result);
+#endif
+    }
+  }
+}
+
+
 #ifndef DISABLE_DAISYCHAIN
 /* Daisy chain interface
 
@@ -883,29 +1276,53 @@ static RESULT cInputFindDumbOutputDevice(DATA8 Device, DATA8 Type, DATA8 Mode,
 static RESULT cInputFindDevice(DATA8 Type, DATA8 Mode, UWORD *pTypeIndex)
 {
   RESULT  Result = FAIL;
-  UWORD   Index = 0;
+  UWORD   Index;
 
-  while ((Index < InputInstance.MaxDeviceTypes) && (Result != OK))
+  Index  =  cInputLookupTypeData(Type,Mode);
+  if (Index != TYPE_INDEX_NONE)
+  { // type and mode match
+
+    // "type data" entry found
+    *pTypeIndex  =  Index;
+
+    Result  =  OK;
+  }
+  else
   {
-    if (Type == InputInstance.TypeData[Index].Type)
+    if ((Type >= 0) && (Type < (MAX_DEVICE_TYPE + 1)) && (InputInstance.TypeLast[Type] != TYPE_INDEX_NONE))
     { // type match
 
-      *pTypeIndex  =  Index;
+      *pTypeIndex  =  InputInstance.TypeLast[Type];
+    }
+  }
+
+  return (Result);
+}
 
-      if (Mode == InputInstance.TypeData[Index].Mode)
-      { // mode match
+/*! \brief    Let connection manager service device on next update
+ */
+static void cInputDcmNotify(DATA8 Device)
+{
+  if ((Device >= 0) && (Device < DEVICES))
+  {
+    InputInstance.DcmPending[Device / 32] |=  (ULONG)1 << (Device % 32);
+  }
+}
 
-        // "type data" entry found
-        *pTypeIndex  =  Index;
+/*! \brief    Drop samples in filters of device (values change meaning with type or mode)
+ */
+static void cInputResetFilters(DATA8 Device)
+{
+  DATA8   DataSet;
 
-        // skip looping
-        Result  =  OK;
-      }
+  if ((Device >= 0) && (Device < INPUT_PORTS))
+  {
+    for (DataSet = 0;DataSet < MAX_DEVICE_DATASETS;DataSet++)
+    {
+      InputInstance.Filter[Device][DataSet].Samples  =  0;
+      InputInstance.Filter[Device][DataSet].Next     =  0;
     }
-    Index++;
   }
-
-  return (Result);
 }
 
 static void cInputResetDevice(DATA8 Device, UWORD TypeIndex)
@@ -917,6 +1334,8 @@ static void cInputResetDevice(DATA8 Device, UWORD TypeIndex)
 
   InputInstance.DeviceData[Device].InvalidTime  =  InputInstance.TypeData[TypeIndex].InvalidTime;
   InputInstance.DeviceData[Device].DevStatus    =  BUSY;
+  cInputDcmNotify(Device);
+  cInputResetFilters(Device);
 
   // save new type
   InputInstance.DeviceData[Device].TypeIndex    =  TypeIndex;
@@ -1193,249 +1612,48 @@ static void cInputCalDataExit(void)
 
 #ifndef DISABLE_OLD_COLOR
 
-#define   FALSE                         0
-#define   TRUE                          1
-
-#define   SENSOR_RESOLUTION             1023L
+/*! \brief    Calibrate values from NXT color sensor and find color
+ *
+ *  Every data set read calls this so the calibrated values and the color
+ *  are only calculated again when the driver has new raw values or the
+ *  sensor calibration (points, limits or CRC) has changed - the driver
+ *  may write a new calibration without changing the CRC
+ */
+static void cInputUpdateColor(DATA8 Device)
+{
+  COLORSTRUCT *pC;
 
-/* Remember this is ARM AD converter  - 3,3 VDC as max voltage      */
-/* When in color mode background value is substracted => min = 0!!! */
-#define   AD_MAX                        2703L
-#define   AD_FS                         3300L
+  pC  =  &(*InputInstance.pAnalog).NxtCol[Device];
 
-#define   COLORSENSORBGMIN              (214/(AD_FS/AD_MAX))
-#define   COLORSENSORMIN                (1L/(AD_FS/AD_MAX)) /* 1 inserted else div 0 (1L/(120/AD_MAX)) */
-#define   COLORSENSORMAX                ((AD_MAX * AD_FS)/3300)
-#define   COLORSENSORPCTDYN             (UBYTE)(((COLORSENSORMAX - COLORSENSORMIN) * 100L)/AD_MAX)
-#define   COLORSENSORBGPCTDYN           (UBYTE)(((COLORSENSORMAX - COLORSENSORBGMIN) * 100L)/AD_MAX)
+  if ((!InputInstance.ColorValid[Device]) || (InputInstance.ColorCrc[Device] != pC->Crc) || (memcmp(InputInstance.ColorADRaw[Device],pC->ADRaw,sizeof(InputInstance.ColorADRaw[Device])) != 0) || (memcmp(InputInstance.ColorCalibration[Device],pC->Calibration,sizeof(InputInstance.ColorCalibration[Device])) != 0) || (memcmp(InputInstance.ColorCalLimits[Device],pC->CalLimits,sizeof(InputInstance.ColorCalLimits[Device])) != 0))
+  { // Copied first so values changed by the driver meanwhile are caught next time
 
-static void cInputCalcFullScale(UWORD *pRawVal, UWORD ZeroPointOffset,
-                                UBYTE PctFullScale, UBYTE InvStatus)
-{
-  if (*pRawVal >= ZeroPointOffset)
-  {
-    *pRawVal -= ZeroPointOffset;
-  }
-  else
-  {
-    *pRawVal = 0;
-  }
+    memcpy(InputInstance.ColorADRaw[Device],pC->ADRaw,sizeof(InputInstance.ColorADRaw[Device]));
+    memcpy(InputInstance.ColorCalibration[Device],pC->Calibration,sizeof(InputInstance.ColorCalibration[Device]));
+    memcpy(InputInstance.ColorCalLimits[Device],pC->CalLimits,sizeof(InputInstance.ColorCalLimits[Device]));
+    InputInstance.ColorCrc[Device]    =  pC->Crc;
+    InputInstance.ColorValid[Device]  =  1;
 
-  *pRawVal = (*pRawVal * 100)/PctFullScale;
-  if (*pRawVal > SENSOR_RESOLUTION)
-  {
-    *pRawVal = SENSOR_RESOLUTION;
-  }
-  if (TRUE == InvStatus)
-  {
-    *pRawVal = SENSOR_RESOLUTION - *pRawVal;
+    cColorCalibrate(pC,pC->SensorRaw);
+    InputInstance.Color[Device]       =  cColorCalculate(pC);
   }
 }
 
-static void cInputCalibrateColor(COLORSTRUCT *pC, UWORD *pNewVals)
+
+#ifndef DISABLE_DAISYCHAIN
+
+static RESULT cInputGetColor(DATA8 Device, DATA8 *pData)
 {
-  UBYTE CalRange;
+  RESULT  Result = FAIL;
 
-  if ((pC->ADRaw[BLANK]) < pC->CalLimits[1])
-  {
-    CalRange = 2;
-  }
-  else
-  {
-    if ((pC->ADRaw[BLANK]) < pC->CalLimits[0])
-    {
-      CalRange = 1;
-    }
-    else
-    {
-      CalRange = 0;
-    }
-  }
-
-  pNewVals[RED] = 0;
-  if ((pC->ADRaw[RED]) > (pC->ADRaw[BLANK]))
-  {
-    pNewVals[RED] = (UWORD)(((ULONG)((pC->ADRaw[RED]) - (pC->ADRaw[BLANK])) * (pC->Calibration[CalRange][RED])) >> 16);
-  }
-
-  pNewVals[GREEN] = 0;
-  if ((pC->ADRaw[GREEN]) > (pC->ADRaw[BLANK]))
-  {
-     pNewVals[GREEN] = (UWORD)(((ULONG)((pC->ADRaw[GREEN]) - (pC->ADRaw[BLANK])) * (pC->Calibration[CalRange][GREEN])) >> 16);
-  }
-
-  pNewVals[BLUE] = 0;
-  if ((pC->ADRaw[BLUE]) > (pC->ADRaw[BLANK]))
-  {
-    pNewVals[BLUE] = (UWORD)(((ULONG)((pC->ADRaw[BLUE]) -(pC->ADRaw[BLANK])) * (pC->Calibration[CalRange][BLUE])) >> 16);
-  }
-
-  pNewVals[BLANK] = (pC->ADRaw[BLANK]);
-  cInputCalcFullScale(&(pNewVals[BLANK]), COLORSENSORBGMIN, COLORSENSORBGPCTDYN, FALSE);
-  (pNewVals[BLANK]) = (UWORD)(((ULONG)(pNewVals[BLANK]) * (pC->Calibration[CalRange][BLANK])) >> 16);
-}
-
-static DATAF cInputCalculateColor(COLORSTRUCT *pC)
-{
-  DATAF   Result ;
-
-
-  Result  =  DATAF_NAN;
-
-  // Color Sensor values has been calculated -
-  // now calculate the color and put it in Sensor value
-  if (((pC->SensorRaw[RED]) > (pC->SensorRaw[BLUE] )) &&
-      ((pC->SensorRaw[RED]) > (pC->SensorRaw[GREEN])))
-  {
-
-    // If all 3 colors are less than 65 OR (Less that 110 and bg less than 40)
-    if (((pC->SensorRaw[RED])   < 65) ||
-        (((pC->SensorRaw[BLANK]) < 40) && ((pC->SensorRaw[RED])  < 110)))
-    {
-      Result  =  (DATAF)BLACKCOLOR;
-    }
-    else
-    {
-      if (((((pC->SensorRaw[BLUE]) >> 2)  + ((pC->SensorRaw[BLUE]) >> 3) + (pC->SensorRaw[BLUE])) < (pC->SensorRaw[GREEN])) &&
-          ((((pC->SensorRaw[GREEN]) << 1)) > (pC->SensorRaw[RED])))
-      {
-        Result  =  (DATAF)YELLOWCOLOR;
-      }
-      else
-      {
-
-        if ((((pC->SensorRaw[GREEN]) << 1) - ((pC->SensorRaw[GREEN]) >> 2)) < (pC->SensorRaw[RED]))
-        {
-
-          Result  =  (DATAF)REDCOLOR;
-        }
-        else
-        {
-
-          if ((((pC->SensorRaw[BLUE]) < 70) ||
-              ((pC->SensorRaw[GREEN]) < 70)) ||
-             (((pC->SensorRaw[BLANK]) < 140) && ((pC->SensorRaw[RED]) < 140)))
-          {
-            Result  =  (DATAF)BLACKCOLOR;
-          }
-          else
-          {
-            Result  =  (DATAF)WHITECOLOR;
-          }
-        }
-      }
-    }
-  }
-  else
-  {
-
-    // Red is not the dominant color
-    if ((pC->SensorRaw[GREEN]) > (pC->SensorRaw[BLUE]))
-    {
-
-      // Green is the dominant color
-      // If all 3 colors are less than 40 OR (Less that 70 and bg less than 20)
-      if (((pC->SensorRaw[GREEN])  < 40) ||
-          (((pC->SensorRaw[BLANK]) < 30) && ((pC->SensorRaw[GREEN])  < 70)))
-      {
-        Result  =  (DATAF)BLACKCOLOR;
-      }
-      else
-      {
-        if ((((pC->SensorRaw[BLUE]) << 1)) < (pC->SensorRaw[RED]))
-        {
-          Result  =  (DATAF)YELLOWCOLOR;
-        }
-        else
-        {
-          if ((((pC->SensorRaw[RED]) + ((pC->SensorRaw[RED])>>2)) < (pC->SensorRaw[GREEN])) ||
-              (((pC->SensorRaw[BLUE]) + ((pC->SensorRaw[BLUE])>>2)) < (pC->SensorRaw[GREEN])))
-          {
-            Result  =  (DATAF)GREENCOLOR;
-          }
-          else
-          {
-            if ((((pC->SensorRaw[RED]) < 70) ||
-                ((pC->SensorRaw[BLUE]) < 70)) ||
-                (((pC->SensorRaw[BLANK]) < 140) && ((pC->SensorRaw[GREEN]) < 140)))
-            {
-              Result  =  (DATAF)BLACKCOLOR;
-            }
-            else
-            {
-              Result  =  (DATAF)WHITECOLOR;
-            }
-          }
-        }
-      }
-    }
-    else
-    {
-
-      // Blue is the most dominant color
-      // Colors can be blue, white or black
-      // If all 3 colors are less than 48 OR (Less that 85 and bg less than 25)
-      if (((pC->SensorRaw[BLUE])   < 48) ||
-          (((pC->SensorRaw[BLANK]) < 25) && ((pC->SensorRaw[BLUE])  < 85)))
-      {
-        Result  =  (DATAF)BLACKCOLOR;
-      }
-      else
-      {
-        if ((((((pC->SensorRaw[RED]) * 48) >> 5) < (pC->SensorRaw[BLUE])) &&
-            ((((pC->SensorRaw[GREEN]) * 48) >> 5) < (pC->SensorRaw[BLUE])))
-            ||
-            (((((pC->SensorRaw[RED])   * 58) >> 5) < (pC->SensorRaw[BLUE])) ||
-             ((((pC->SensorRaw[GREEN]) * 58) >> 5) < (pC->SensorRaw[BLUE]))))
-        {
-          Result  =  (DATAF)BLUECOLOR;
-        }
-        else
-        {
-
-          // Color is white or Black
-          if ((((pC->SensorRaw[RED])  < 60) ||
-              ((pC->SensorRaw[GREEN]) < 60)) ||
-             (((pC->SensorRaw[BLANK]) < 110) && ((pC->SensorRaw[BLUE]) < 120)))
-          {
-            Result  =  (DATAF)BLACKCOLOR;
-          }
-          else
-          {
-            if ((((pC->SensorRaw[RED])  + ((pC->SensorRaw[RED])   >> 3)) < (pC->SensorRaw[BLUE])) ||
-                (((pC->SensorRaw[GREEN]) + ((pC->SensorRaw[GREEN]) >> 3)) < (pC->SensorRaw[BLUE])))
-            {
-              Result  =  (DATAF)BLUECOLOR;
-            }
-            else
-            {
-              Result  =  (DATAF)WHITECOLOR;
-            }
-          }
-        }
-      }
-    }
-  }
-
-
-  return (Result);
-}
-
-
-#ifndef DISABLE_DAISYCHAIN
-
-static RESULT cInputGetColor(DATA8 Device, DATA8 *pData)
-{
-  RESULT  Result = FAIL;
-
-  cInputCalibrateColor(&(*InputInstance.pAnalog).NxtCol[Device],(*InputInstance.pAnalog).NxtCol[Device].SensorRaw);
-
-  switch (InputInstance.DeviceMode[Device])
+  cInputUpdateColor(Device);
+
+  switch (InputInstance.DeviceMode[Device])
   {
     case 2 :
     { // NXT-COL-COL
 
-      pData[0]  =  cInputCalculateColor(&(*InputInstance.pAnalog).NxtCol[Device]);
+      pData[0]  =  InputInstance.Color[Device];
       Result  =  OK;
     }
     break;
@@ -1492,14 +1710,14 @@ static DATAF cInputGetColor(DATA8 Device, DATA8 Index)
 
   Result  =  DATAF_NAN;
 
-  cInputCalibrateColor(&(*InputInstance.pAnalog).NxtCol[Device],(*InputInstance.pAnalog).NxtCol[Device].SensorRaw);
+  cInputUpdateColor(Device);
 
   switch (InputInstance.DeviceMode[Device])
   {
     case 2 :
     { // NXT-COL-COL
 
-      Result  =  cInputCalculateColor(&(*InputInstance.pAnalog).NxtCol[Device]);
+      Result  =  (DATAF)InputInstance.Color[Device];
     }
     break;
 
@@ -2289,6 +2507,76 @@ static RESULT cInputGetData(DATA8 Layer, DATA8 Port, DATA16 Time, DATA16 *pInit,
   return (Result);
 }
 
+static void cInputConvertDeviceRaw(DATA8 Device, DATA8 Type, DATA8 Mode, UBYTE *pData,
+                                   DATA8 First, DATA8 Last)
+{
+  DATAF   *pRaw;
+  DATA8   DataSets;
+  DATA8   Index;
+
+  pRaw      =  InputInstance.DeviceData[Device].Raw;
+  DataSets  =  InputInstance.TypeData[InputInstance.DeviceData[Device].TypeIndex].DataSets;
+  if (Last > DataSets)
+  {
+    Last  =  DataSets;
+  }
+
+  switch (InputInstance.TypeData[InputInstance.DeviceData[Device].TypeIndex].Format & 0x0F)
+  {
+    case DATA_8 :
+    {
+      for (Index = First;Index < Last;Index++)
+      {
+        if (((DATA8*)pData)[Index] != DATA8_NAN)
+        {
+          pRaw[Index]   =  (DATAF)((DATA8*)pData)[Index];
+        }
+      }
+    }
+    break;
+
+    case DATA_16 :
+    {
+      for (Index = First;Index < Last;Index++)
+      {
+        if (((DATA16*)pData)[Index] != DATA16_NAN)
+        {
+          pRaw[Index]   =  (DATAF)((DATA16*)pData)[Index];
+
+//!<  \todo EMETER hack
+          if ((Type == 99) && (Mode == 7) && (Index == 4))
+          {
+            pRaw[Index] *=  (DATAF)1000.0;
+          }
+        }
+      }
+    }
+    break;
+
+    case DATA_32 :
+    {
+      for (Index = First;Index < Last;Index++)
+      {
+        if (((DATA32*)pData)[Index] != DATA32_NAN)
+        {
+          pRaw[Index]   =  (DATAF)((DATA32*)pData)[Index];
+        }
+      }
+    }
+    break;
+
+    case DATA_F :
+    {
+      for (Index = First;Index < Last;Index++)
+      {
+        pRaw[Index]   =  (DATAF)((DATAF*)pData)[Index];
+      }
+    }
+    break;
+
+  }
+}
+
 static DATAF cInputReadDeviceRaw(DATA8 Device, DATA8 Index, DATA16 Time, DATA16 *pInit)
 {
   DATAF   Result = (DATAF)0;
@@ -2297,7 +2585,6 @@ static DATAF cInputReadDeviceRaw(DATA8 Device, DATA8 Index, DATA16 Time, DATA16
   DATA8   Output;
   DATA8   Type;
   DATA8   Mode;
-  DATA8   DataSets;
   UBYTE   *pData;
 
 
@@ -2315,59 +2602,45 @@ static DATAF cInputReadDeviceRaw(DATA8 Device, DATA8 Index, DATA16 Time, DATA16
 
     if (cInputGetData(Layer,Port,Time,pInit,MAX_DEVICE_DATALENGTH,&Type,&Mode,(DATA8*)pData) == OK)
     {
+      cInputConvertDeviceRaw(Device,Type,Mode,pData,Index,Index + 1);
 
-      DataSets  =  InputInstance.TypeData[InputInstance.DeviceData[Device].TypeIndex].DataSets;
-      if (Index < DataSets)
-      {
-        switch (InputInstance.TypeData[InputInstance.DeviceData[Device].TypeIndex].Format & 0x0F)
-        {
-          case DATA_8 :
-          {
-            if (((DATA8*)pData)[Index] != DATA8_NAN)
-            {
-              InputInstance.DeviceData[Device].Raw[Index]   =  (DATAF)((DATA8*)pData)[Index];
-            }
-          }
-          break;
+      Result  =  InputInstance.DeviceData[Device].Raw[Index];
+    }
+  }
 
-          case DATA_16 :
-          {
-            if (((DATA16*)pData)[Index] != DATA16_NAN)
-            {
-              InputInstance.DeviceData[Device].Raw[Index]   =  (DATAF)((DATA16*)pData)[Index];
+  return (Result);
+}
 
-//!<  \todo EMETER hack
-              if ((Type == 99) && (Mode == 7) && (Index == 4))
-              {
-                InputInstance.DeviceData[Device].Raw[Index] *=  (DATAF)1000.0;
-              }
-            }
-          }
-          break;
+/*! \brief    Read all data sets of a device
+ *
+ *  Device data is fetched once and data sets 0 to Values - 1 are converted
+ *  into DeviceData[Device].Raw (DATAF_NAN if not available)
+ */
+static void cInputReadDeviceRawAll(DATA8 Device, DATA8 Values, DATA16 Time, DATA16 *pInit)
+{
+  DATA8   Layer;
+  DATA8   Port;
+  DATA8   Output;
+  DATA8   Type;
+  DATA8   Mode;
+  DATA8   Index;
+  UBYTE   *pData;
 
-          case DATA_32 :
-          {
-            if (((DATA32*)pData)[Index] != DATA32_NAN)
-            {
-              InputInstance.DeviceData[Device].Raw[Index]   =  (DATAF)((DATA32*)pData)[Index];
-            }
-          }
-          break;
+  for (Index = 0;Index < Values;Index++)
+  {
+    InputInstance.DeviceData[Device].Raw[Index]       =  DATAF_NAN;
+  }
 
-          case DATA_F :
-          {
-            InputInstance.DeviceData[Device].Raw[Index]   =  (DATAF)((DATAF*)pData)[Index];
-          }
-          break;
+  if (cInputExpandDevice(Device,&Layer,&Port,&Output) == OK)
+  { // Device valid
 
-        }
-      }
+    pData  =  InputInstance.Data;
 
-      Result  =  InputInstance.DeviceData[Device].Raw[Index];
+    if (cInputGetData(Layer,Port,Time,pInit,MAX_DEVICE_DATALENGTH,&Type,&Mode,(DATA8*)pData) == OK)
+    {
+      cInputConvertDeviceRaw(Device,Type,Mode,pData,0,Values);
     }
   }
-
-  return (Result);
 }
 
 
@@ -2525,6 +2798,17 @@ static DATAF cInputReadDeviceRaw(DATA8 Device, DATA8 Index, DATA16 Time, DATA16
 
   return (Result);
 }
+
+static void cInputReadDeviceRawAll(DATA8 Device, DATA8 Values, DATA16 Time, DATA16 *pInit)
+{
+  DATA8   Index;
+
+  for (Index = 0;Index < Values;Index++)
+  {
+    InputInstance.DeviceData[Device].Raw[Index]  =  DATAF_NAN;
+    cInputReadDeviceRaw(Device,Index,Time,pInit);
+  }
+}
 #endif
 
 static void cInputWriteDeviceRaw(DATA8 Device, DATA8 Connection, DATA8 Type, DATAF DataF)
@@ -2632,84 +2916,76 @@ static void cInputWriteDeviceRaw(DATA8 Device, DATA8 Connection, DATA8 Type, DAT
   }
 }
 
-static DATA8 cInputReadDevicePct(DATA8 Device, DATA8 Index, DATA16 Time, DATA16 *pInit)
+static void cInputGetRawRange(UWORD TypeIndex, DATAF *pMin, DATAF *pMax)
 {
-  DATA8   Result  =  DATA8_NAN;
-  UWORD   TypeIndex;
-  DATAF   Raw;
   DATA8   Type;
   DATA8   Mode;
-  DATAF   Min;
-  DATAF   Max;
-  DATAF   Pct;
 
-  Raw         =  cInputReadDeviceRaw(Device,Index,Time,pInit);
+  Type        =  InputInstance.TypeData[TypeIndex].Type;
+  Mode        =  InputInstance.TypeData[TypeIndex].Mode;
+  *pMin       =  InputInstance.TypeData[TypeIndex].RawMin;
+  *pMax       =  InputInstance.TypeData[TypeIndex].RawMax;
 
-  if (!(isnan(Raw)))
+  if ((Type > 0) && (Type < (MAX_DEVICE_TYPE + 1)) && (Mode >= 0) && (Mode < MAX_DEVICE_MODES))
   {
-    TypeIndex   =  InputInstance.DeviceData[Device].TypeIndex;
-
-    Type        =  InputInstance.TypeData[TypeIndex].Type;
-    Mode        =  InputInstance.TypeData[TypeIndex].Mode;
-    Min         =  InputInstance.TypeData[TypeIndex].RawMin;
-    Max         =  InputInstance.TypeData[TypeIndex].RawMax;
-
-    if ((Type > 0) && (Type < (MAX_DEVICE_TYPE + 1)) && (Mode >= 0) && (Mode < MAX_DEVICE_MODES))
-    {
-      if (InputInstance.Calib[Type][Mode].InUse)
-      {
-        Min     =  InputInstance.Calib[Type][Mode].Min;
-        Max     =  InputInstance.Calib[Type][Mode].Max;
-      }
-    }
-
-    Pct    =  (((Raw - Min) * (InputInstance.TypeData[TypeIndex].PctMax - InputInstance.TypeData[TypeIndex].PctMin)) / (Max - Min) + InputInstance.TypeData[TypeIndex].PctMin);
-
-    if (Pct > InputInstance.TypeData[TypeIndex].PctMax)
-    {
-      Pct  =  InputInstance.TypeData[TypeIndex].PctMax;
-    }
-    if (Pct < InputInstance.TypeData[TypeIndex].PctMin)
+    if (InputInstance.Calib[Type][Mode].InUse)
     {
-      Pct  =  InputInstance.TypeData[TypeIndex].PctMin;
+      *pMin   =  InputInstance.Calib[Type][Mode].Min;
+      *pMax   =  InputInstance.Calib[Type][Mode].Max;
     }
-    Result  =  (DATA8)Pct;
   }
-
-  return (Result);
 }
 
-static DATAF cInputReadDeviceSi(DATA8 Device, DATA8 Index, DATA16 Time, DATA16 *pInit)
+/*! \brief    Get conversion of device raw values
+ *
+ *  Percent and SI values are linear in raw value so the conversion is only
+ *  set up again when the device gets another "TypeData" entry or
+ *  ScaleVersion is changed (calibration or type data changed)
+ */
+static UWORD cInputUpdateScale(DATA8 Device)
 {
-  UWORD   TypeIndex;
-  DATAF   Raw;
-  DATA8   Type;
-  DATA8   Mode;
-  DATA8   Connection;
+  DEVICE  *pDevice;
+  TYPES   *pType;
   DATAF   Min;
   DATAF   Max;
 
-  Raw           =  cInputReadDeviceRaw(Device,Index,Time,pInit);
-
-  if (!(isnan(Raw)))
+  pDevice  =  &InputInstance.DeviceData[Device];
+  if (((*pDevice).ScaleTypeIndex != (*pDevice).TypeIndex) || ((*pDevice).ScaleVersion != InputInstance.ScaleVersion))
   {
-    TypeIndex   =  InputInstance.DeviceData[Device].TypeIndex;
-
-    Type        =  InputInstance.TypeData[TypeIndex].Type;
-    Mode        =  InputInstance.TypeData[TypeIndex].Mode;
-    Min         =  InputInstance.TypeData[TypeIndex].RawMin;
-    Max         =  InputInstance.TypeData[TypeIndex].RawMax;
+    pType  =  &InputInstance.TypeData[(*pDevice).TypeIndex];
+    cInputGetRawRange((*pDevice).TypeIndex,&Min,&Max);
 
-    if ((Type > 0) && (Type < (MAX_DEVICE_TYPE + 1)) && (Mode >= 0) && (Mode < MAX_DEVICE_MODES))
-    {
-      if (InputInstance.Calib[Type][Mode].InUse)
-      {
-        Min     =  InputInstance.Calib[Type][Mode].Min;
-        Max     =  InputInstance.Calib[Type][Mode].Max;
-      }
-    }
+    cScaleSetup(&(*pDevice).Scale,Min,Max,(*pType).PctMin,(*pType).PctMax,(*pType).SiMin,(*pType).SiMax);
+    (*pDevice).ScaleTypeIndex  =  (*pDevice).TypeIndex;
+    (*pDevice).ScaleVersion    =  InputInstance.ScaleVersion;
+  }
 
-    Raw         =  (((Raw - Min) * (InputInstance.TypeData[TypeIndex].SiMax - InputInstance.TypeData[TypeIndex].SiMin)) / (Max - Min) + InputInstance.TypeData[TypeIndex].SiMin);
+  return ((*pDevice).TypeIndex);
+}
+
+static DATA8 cInputScalePct(DATA8 Device, DATAF Raw)
+{
+  DATA8   Result  =  DATA8_NAN;
+
+  if (!(isnan(Raw)))
+  {
+    cInputUpdateScale(Device);
+    Result  =  cScalePct(&InputInstance.DeviceData[Device].Scale,Raw);
+  }
+
+  return (Result);
+}
+
+static DATAF cInputScaleSi(DATA8 Device, DATAF Raw)
+{
+  UWORD   TypeIndex;
+  DATA8   Connection;
+
+  if (!(isnan(Raw)))
+  {
+    TypeIndex   =  cInputUpdateScale(Device);
+
+    Raw         =  cScaleSi(&InputInstance.DeviceData[Device].Scale,Raw);
 
     // Limit values on dumb connections if "pct" or "_"
     Connection  =  InputInstance.TypeData[TypeIndex].Connection;
@@ -2727,12 +3003,211 @@ static DATAF cInputReadDeviceSi(DATA8 Device, DATA8 Index, DATA16 Time, DATA16 *
         }
       }
     }
+  }
 
+  return (Raw);
+}
+
+/*! \brief    Set up filter on data set of device on the brick
+ *
+ *  Samples collected so far are dropped. FILTER_NONE removes the filter.
+ */
+static RESULT cInputSetupFilter(DATA8 Device, DATA8 DataSet, DATA8 Type, DATA8 Window)
+{
+  RESULT  Result = FAIL;
+  FILTER  *pFilter;
+
+  if ((Device >= 0) && (Device < INPUT_PORTS) && (DataSet >= 0) && (DataSet < MAX_DEVICE_DATASETS) && (Type >= FILTER_NONE) && (Type < FILTERS))
+  {
+    if (Window < 1)
+    {
+      Window  =  1;
+    }
+    if (Window > FILTER_WINDOW_SIZE)
+    {
+      Window  =  FILTER_WINDOW_SIZE;
+    }
+
+    pFilter               =  &InputInstance.Filter[Device][DataSet];
+    (*pFilter).Type       =  Type;
+    (*pFilter).Window     =  Window;
+    (*pFilter).Samples    =  0;
+    (*pFilter).Next       =  0;
+    (*pFilter).Weight     =  (DATAF)2 / (DATAF)(Window + 1);
+    (*pFilter).Output     =  DATAF_NAN;
+    Result                =  OK;
+  }
+
+  return (Result);
+}
+
+static void cInputFilterSample(FILTER *pFilter, DATAF Raw)
+{
+  DATAF   Sorted[FILTER_WINDOW_SIZE];
+  DATAF   Value;
+  DATA8   Index;
+  DATA8   Tmp;
+
+  if ((*pFilter).Type == FILTER_EXPONENTIAL)
+  {
+    if ((*pFilter).Samples == 0)
+    {
+      (*pFilter).Output   =  Raw;
+      (*pFilter).Samples  =  1;
+    }
+    else
+    {
+      (*pFilter).Output  +=  (Raw - (*pFilter).Output) * (*pFilter).Weight;
+    }
+  }
+  else
+  {
+    (*pFilter).Sample[(*pFilter).Next]  =  Raw;
+    if (++(*pFilter).Next >= (*pFilter).Window)
+    {
+      (*pFilter).Next  =  0;
+    }
+    if ((*pFilter).Samples < (*pFilter).Window)
+    {
+      (*pFilter).Samples++;
+    }
+
+    if ((*pFilter).Type == FILTER_MEDIAN)
+    { // Insertion sort - window is small
+
+      for (Index = 0;Index < (*pFilter).Samples;Index++)
+      {
+        Value  =  (*pFilter).Sample[Index];
+        for (Tmp = Index;(Tmp > 0) && (Sorted[Tmp - 1] > Value);Tmp--)
+        {
+          Sorted[Tmp]  =  Sorted[Tmp - 1];
+        }
+        Sorted[Tmp]  =  Value;
+      }
+      Index  =  (*pFilter).Samples / 2;
+      if ((*pFilter).Samples & 1)
+      {
+        (*pFilter).Output  =  Sorted[Index];
+      }
+      else
+      {
+        (*pFilter).Output  =  (Sorted[Index - 1] + Sorted[Index]) / (DATAF)2;
+      }
+    }
+    else
+    { // Sum again every time so rounding errors do not add up
+
+      Value  =  (DATAF)0;
+      for (Index = 0;Index < (*pFilter).Samples;Index++)
+      {
+        Value +=  (*pFilter).Sample[Index];
+      }
+      (*pFilter).Output  =  Value / (DATAF)(*pFilter).Samples;
+    }
+  }
+}
+
+/*! \brief    Feed new raw values of devices on the brick to their filters
+ *
+ *  Called every input update so the filters see the same sample rate
+ *  regardless of how often the program reads the values
+ */
+static void cInputFilterUpdate(void)
+{
+  FILTER  *pFilter;
+  DATAF   Raw;
+  DATA8   Device;
+  DATA8   DataSet;
+
+  for (Device = 0;Device < INPUT_PORTS;Device++)
+  {
+    if (InputInstance.DeviceData[Device].DevStatus == OK)
+    {
+      for (DataSet = 0;DataSet < MAX_DEVICE_DATASETS;DataSet++)
+      {
+        pFilter  =  &InputInstance.Filter[Device][DataSet];
+        if ((*pFilter).Type != FILTER_NONE)
+        {
+          Raw  =  cInputReadDeviceRaw(Device,DataSet,0,NULL);
+          if (!(isnan(Raw)))
+          {
+            cInputFilterSample(pFilter,Raw);
+          }
+        }
+      }
+    }
+  }
+}
+
+/*! \brief    Get filtered raw value if data set has a filter
+ */
+static DATAF cInputFilterRaw(DATA8 Device, DATA8 DataSet, DATAF Raw)
+{
+  FILTER  *pFilter;
+
+  if ((Device >= 0) && (Device < INPUT_PORTS) && (DataSet >= 0) && (DataSet < MAX_DEVICE_DATASETS) && (!(isnan(Raw))))
+  {
+    pFilter  =  &InputInstance.Filter[Device][DataSet];
+    if (((*pFilter).Type != FILTER_NONE) && ((*pFilter).Samples > 0))
+    {
+      Raw  =  (*pFilter).Output;
+    }
   }
 
   return (Raw);
 }
 
+static DATA8 cInputReadDevicePct(DATA8 Device, DATA8 Index, DATA16 Time, DATA16 *pInit)
+{
+  return (cInputScalePct(Device,cInputFilterRaw(Device,Index,cInputReadDeviceRaw(Device,Index,Time,pInit))));
+}
+
+static DATAF cInputReadDeviceSi(DATA8 Device, DATA8 Index, DATA16 Time, DATA16 *pInit)
+{
+  return (cInputScaleSi(Device,cInputFilterRaw(Device,Index,cInputReadDeviceRaw(Device,Index,Time,pInit))));
+}
+
+/*! \brief    Read several data sets of a device in one go
+ *
+ *  Device data is fetched once and all values are converted in one pass -
+ *  used when more than one value is returned by a byte code
+ *
+ *  \param    Format    DATA_PCT, DATA_RAW or DATA_SI
+ *  \param    Values    Number of data sets [1..MAX_DEVICE_DATASETS]
+ *  \param    pValues   Values (DATA_PCT as DATA8 value and DATA8_NAN, others DATAF_NAN if not available)
+ */
+static void cInputReadDeviceValues(DATA8 Device, DATA8 Format, DATA8 Values, DATAF *pValues)
+{
+  DATA8   Index;
+
+  cInputReadDeviceRawAll(Device,Values,0,NULL);
+
+  for (Index = 0;Index < Values;Index++)
+  {
+    switch (Format)
+    {
+      case DATA_PCT :
+      {
+        pValues[Index]  =  (DATAF)cInputScalePct(Device,cInputFilterRaw(Device,Index,InputInstance.DeviceData[Device].Raw[Index]));
+      }
+      break;
+
+      case DATA_SI :
+      {
+        pValues[Index]  =  cInputScaleSi(Device,cInputFilterRaw(Device,Index,InputInstance.DeviceData[Device].Raw[Index]));
+      }
+      break;
+
+      default :
+      {
+        pValues[Index]  =  InputInstance.DeviceData[Device].Raw[Index];
+      }
+      break;
+
+    }
+  }
+}
+
 static RESULT cInputCheckUartInfo(UBYTE Port)
 {
   RESULT  Result = BUSY;
@@ -2886,151 +3361,268 @@ static RESULT cInputCheckIicInfo(UBYTE Port)
  *            Called when the VM read the device list
  *
  */
-static void cInputDcmUpdate(UWORD Time)
+/*! \brief    Find local ports changed by the drivers
+ *
+ *  The drivers publish connection, device type and status of the ports on
+ *  the brick in shared memory so a change there is what tells that a port
+ *  needs the connection manager
+ */
+static void cInputDcmCheckPorts(void)
+{
+  DCMSTATE  State;
+  ULONG     Time;
+  DATA8     Port;
+  DATA8     Device;
+
+  for (Port = 0;Port < (INPUT_PORTS + OUTPUT_PORTS);Port++)
+  {
+    memset(&State,0,sizeof(State));
+    if (Port < INPUT_PORTS)
+    {
+      Device            =  Port;
+      State.Conn        =  (*InputInstance.pAnalog).InConn[Port];
+      State.Dcm         =  (*InputInstance.pAnalog).InDcm[Port];
+      State.Updated     =  (*InputInstance.pAnalog).Updated[Port];
+      State.UartStatus  =  (*InputInstance.pUart).Status[Port];
+      State.IicStatus   =  (*InputInstance.pIic).Status[Port];
+      State.IicChanged  =  (*InputInstance.pIic).Changed[Port];
+    }
+    else
+    {
+      Device            =  INPUT_DEVICES + Port - INPUT_PORTS;
+      State.Conn        =  (*InputInstance.pAnalog).OutConn[Port - INPUT_PORTS];
+      State.Dcm         =  (*InputInstance.pAnalog).OutDcm[Port - INPUT_PORTS];
+    }
+
+    if (memcmp(&State,&InputInstance.DcmState[Port],sizeof(State)) != 0)
+    {
+      if ((State.Conn != InputInstance.DcmState[Port].Conn) && (InputInstance.DcmChangeTime[Device] == 0))
+      { // Connection changed - measure time until device is ready (0 = not measuring)
+
+        Time  =  GetTimeMS();
+        InputInstance.DcmChangeTime[Device]  =  (Time != 0) ? Time : 1;
+      }
+      InputInstance.DcmState[Port]  =  State;
+      cInputDcmNotify(Device);
+    }
+  }
+}
+
+/*! \brief    Service device in connection manager
+ *
+ *  \return   OK if nothing is waiting to happen (device ready or port empty)
+ */
+static RESULT cInputDcmService(DATA8 Device, UWORD Time)
 {
   RESULT  Result = BUSY;
-  DATA8   Device;
   DATA8   Port;
 #ifndef DISABLE_DAISYCHAIN
   TYPES   Tmp;
-  TYPES   *pTmp;
-  DATA16  Index;
   DATA8   Layer;
   DATA8   Output;
   DATA8   Type;
   DATA8   Mode;
 #endif
 
-  if (InputInstance.DCMUpdate)
-  {
-    for (Device = 0;Device < DEVICES;Device++)
-    {
-
-      if ((Device >= 0) && (Device < INPUTS))
-      { // Device is local input port
+  if ((Device >= 0) && (Device < INPUTS))
+  { // Device is local input port
 
-        Port  =  Device;
+    Port  =  Device;
 
-        if (InputInstance.DeviceData[Device].Connection !=  (*InputInstance.pAnalog).InConn[Port])
-        { // Connection type has changed
+    if (InputInstance.DeviceData[Device].Connection !=  (*InputInstance.pAnalog).InConn[Port])
+    { // Connection type has changed
 
-          InputInstance.DeviceData[Device].Connection   =  (*InputInstance.pAnalog).InConn[Port];
-          cInputSetDeviceType(Device,(*InputInstance.pAnalog).InDcm[Port],0,__LINE__);
-          InputInstance.DeviceMode[Device]              =  0;
-          InputInstance.TmpMode[Device]                 =  MAX_DEVICE_MODES;
-          InputInstance.DeviceData[Device].DevStatus    =  BUSY;
-        }
+      InputInstance.DeviceData[Device].Connection   =  (*InputInstance.pAnalog).InConn[Port];
+      cInputSetDeviceType(Device,(*InputInstance.pAnalog).InDcm[Port],0,__LINE__);
+      InputInstance.DeviceMode[Device]              =  0;
+      InputInstance.TmpMode[Device]                 =  MAX_DEVICE_MODES;
+      InputInstance.DeviceData[Device].DevStatus    =  BUSY;
+    }
 
-        if (InputInstance.DeviceData[Device].Connection == CONN_INPUT_UART)
-        { // UART device
+    if (InputInstance.DeviceData[Device].Connection == CONN_INPUT_UART)
+    { // UART device
 
-          Result  =  cInputCheckUartInfo(Port);
+      Result  =  cInputCheckUartInfo(Port);
 
-        }
-        else
-        {
-          if (InputInstance.DeviceData[Device].Connection == CONN_NXT_IIC)
-          { // IIC device
+    }
+    else
+    {
+      if (InputInstance.DeviceData[Device].Connection == CONN_NXT_IIC)
+      { // IIC device
 
-            Result  =  cInputCheckIicInfo(Port);
-          }
-          else
-          { // Analogue device
+        Result  =  cInputCheckIicInfo(Port);
+      }
+      else
+      { // Analogue device
 
-            if ((*InputInstance.pAnalog).Updated[Device])
-            {
-              Result  =  OK;
-            }
-          }
+        if ((*InputInstance.pAnalog).Updated[Device])
+        {
+          Result  =  OK;
         }
       }
-      else
-      {
-        if ((Device >= INPUT_DEVICES) && (Device < (INPUT_DEVICES + OUTPUTS)))
-        { // Device is local output port
+    }
+  }
+  else
+  {
+    if ((Device >= INPUT_DEVICES) && (Device < (INPUT_DEVICES + OUTPUTS)))
+    { // Device is local output port
 
-          Port  =  Device - INPUT_DEVICES;
+      Port  =  Device - INPUT_DEVICES;
 
-          if (InputInstance.DeviceData[Device].Connection !=  (*InputInstance.pAnalog).OutConn[Port])
-          { // Connection type has changed
+      if (InputInstance.DeviceData[Device].Connection !=  (*InputInstance.pAnalog).OutConn[Port])
+      { // Connection type has changed
 
-            InputInstance.DeviceData[Device].Connection   =  (*InputInstance.pAnalog).OutConn[Port];
-            cInputSetDeviceType(Device,(*InputInstance.pAnalog).OutDcm[Port],0,__LINE__);
-          }
+        InputInstance.DeviceData[Device].Connection   =  (*InputInstance.pAnalog).OutConn[Port];
+        cInputSetDeviceType(Device,(*InputInstance.pAnalog).OutDcm[Port],0,__LINE__);
+      }
 
-          Result  =  OK;
+      Result  =  OK;
 
-        }
-        else
-        { // Device is from daisy chain
+    }
+    else
+    { // Device is from daisy chain
 
 #ifndef DISABLE_DAISYCHAIN
 
-          cInputExpandDevice(Device,&Layer,&Port,&Output);
+      cInputExpandDevice(Device,&Layer,&Port,&Output);
 
-          Result  =  cInputComGetDeviceType(Layer,Port,MAX_DEVICE_DATALENGTH,&Type,&Mode,(DATA8*)&Tmp);
+      Result  =  cInputComGetDeviceType(Layer,Port,MAX_DEVICE_DATALENGTH,&Type,&Mode,(DATA8*)&Tmp);
 
-          if ((Type > 0) && (Type <= MAX_VALID_TYPE) && (Result != FAIL))
-          {
-            InputInstance.DeviceData[Device].Connection  =  CONN_DAISYCHAIN;
-          }
-          else
-          {
-            Type  =  TYPE_NONE;
-            InputInstance.DeviceData[Device].Connection  =  CONN_NONE;
-          }
+      if ((Type > 0) && (Type <= MAX_VALID_TYPE) && (Result != FAIL))
+      {
+        InputInstance.DeviceData[Device].Connection  =  CONN_DAISYCHAIN;
+      }
+      else
+      {
+        Type  =  TYPE_NONE;
+        InputInstance.DeviceData[Device].Connection  =  CONN_NONE;
+      }
 
-          if (InputInstance.DeviceType[Device] != Type)
-          {
-            cInputSetDeviceType(Device,Type,0,__LINE__);
-          }
+      if (InputInstance.DeviceType[Device] != Type)
+      {
+        cInputSetDeviceType(Device,Type,0,__LINE__);
+      }
 #else
 
-          InputInstance.DeviceData[Device].Connection  =  CONN_NONE;
+      InputInstance.DeviceData[Device].Connection  =  CONN_NONE;
 
 #endif
 
-        }
-      }
+    }
+  }
 
-      if ((InputInstance.DeviceData[Device].Connection == CONN_NONE) || (InputInstance.DeviceData[Device].Connection == CONN_ERROR))
-      {
-        InputInstance.DeviceData[Device].DevStatus  =  BUSY;
-      }
-      else
+  if ((InputInstance.DeviceData[Device].Connection == CONN_NONE) || (InputInstance.DeviceData[Device].Connection == CONN_ERROR))
+  {
+    InputInstance.DeviceData[Device].DevStatus  =  BUSY;
+  }
+  else
+  {
+    if (InputInstance.DeviceData[Device].InvalidTime >= Time)
+    {
+      InputInstance.DeviceData[Device].InvalidTime -=  Time;
+      InputInstance.DeviceData[Device].DevStatus  =  BUSY;
+    }
+    else
+    {
+      InputInstance.DeviceData[Device].InvalidTime  =  0;
+      if (Result == OK)
       {
-        if (InputInstance.DeviceData[Device].InvalidTime >= Time)
-        {
-          InputInstance.DeviceData[Device].InvalidTime -=  Time;
-          InputInstance.DeviceData[Device].DevStatus  =  BUSY;
-        }
-        else
-        {
-          InputInstance.DeviceData[Device].InvalidTime  =  0;
-          if (Result == OK)
-          {
-            InputInstance.DeviceData[Device].DevStatus    =  OK;
+        InputInstance.DeviceData[Device].DevStatus    =  OK;
 
 #ifdef BUFPRINTSIZE
-            BufPrint('p',"D=%-2d M=%d OK\r\n",(int)Device,InputInstance.DeviceMode[Device]);
+        BufPrint('p',"D=%-2d M=%d OK\r\n",(int)Device,InputInstance.DeviceMode[Device]);
 #endif
-          }
-          else
-          {
-            InputInstance.DeviceData[Device].DevStatus  =  BUSY;
-          }
-        }
       }
-      if (InputInstance.DeviceData[Device].TimeoutTimer >= Time)
+      else
       {
-        InputInstance.DeviceData[Device].TimeoutTimer -=  Time;
+        InputInstance.DeviceData[Device].DevStatus  =  BUSY;
       }
-      else
+    }
+  }
+  if (InputInstance.DeviceData[Device].TimeoutTimer >= Time)
+  {
+    InputInstance.DeviceData[Device].TimeoutTimer -=  Time;
+  }
+  else
+  {
+    InputInstance.DeviceData[Device].TimeoutTimer  =  0;
+  }
+
+  if ((InputInstance.DeviceData[Device].Connection == CONN_NONE) || (InputInstance.DeviceData[Device].Connection == CONN_ERROR))
+  {
+    Result  =  OK;
+  }
+  else
+  {
+    Result  =  InputInstance.DeviceData[Device].DevStatus;
+  }
+  if (InputInstance.DeviceData[Device].TimeoutTimer)
+  {
+    Result  =  BUSY;
+  }
+
+  return (Result);
+}
+
+static void cInputDcmUpdate(UWORD Time)
+{
+  DATA8   Device;
+  DATA8   Word;
+  ULONG   Pending;
+#ifndef DISABLE_DAISYCHAIN
+  RESULT  Result;
+  TYPES   Tmp;
+  TYPES   *pTmp;
+  DATA16  Index;
+#endif
+
+  if (InputInstance.DCMUpdate)
+  {
+    cInputDcmCheckPorts();
+
+    InputInstance.DcmScanTimer +=  Time;
+    if (InputInstance.DcmScanTimer >= DCM_SCAN_TIME)
+    { // Slow scan of all devices (daisy chained devices are only found here)
+
+      InputInstance.DcmScanTimer  =  0;
+      for (Device = 0;Device < DEVICES;Device++)
       {
-        InputInstance.DeviceData[Device].TimeoutTimer  =  0;
+        cInputDcmNotify(Device);
       }
+    }
+
+    for (Word = 0;Word < DCM_PENDING_WORDS;Word++)
+    {
+      Pending                             =  InputInstance.DcmPending[Word];
+      InputInstance.DcmPending[Word]      =  0;
+
+      while (Pending)
+      {
+        Device    =  (DATA8)((Word * 32) + __builtin_ctz(Pending));
+        Pending  &=  Pending - 1;
 
+        if (cInputDcmService(Device,Time) == OK)
+        {
+          if (InputInstance.DcmChangeTime[Device])
+          { // Connection change handled
 
+            InputInstance.DcmLatency  =  GetTimeMS() - InputInstance.DcmChangeTime[Device];
+            if (InputInstance.DcmLatency > InputInstance.DcmLatencyMax)
+            {
+              InputInstance.DcmLatencyMax  =  InputInstance.DcmLatency;
+            }
+            InputInstance.DcmChangeTime[Device]  =  0;
+#ifdef DEBUG_C_INPUT
+            printf("c_input   cInputDcmUpdate: D=%-3d C=%-3d ready after %lu mS (max %lu mS)\n",Device,InputInstance.DeviceData[Device].Connection,(unsigned long)InputInstance.DcmLatency,(unsigned long)InputInstance.DcmLatencyMax);
+#endif
+          }
+        }
+        else
+        { // Still waiting - service again on next update
+
+          cInputDcmNotify(Device);
+        }
+      }
     }
   }
 
@@ -3138,13 +3730,19 @@ RESULT cInputStartTypeDataUpload(void)
 
 void cInputUpdate(UWORD Time)
 {
-#ifndef DISABLE_BUMPED
   DATA8   Device;
+#ifndef DISABLE_BUMPED
   DATAF   Value = 0.0;
   DATAF   Diff;
 #endif
 
   cInputDcmUpdate(Time);
+  cInputFilterUpdate();
+
+  for (Device = 0;Device < INPUT_PORTS;Device++)
+  {
+    cInputServiceIicQueue(Device);
+  }
 
 #ifndef DISABLE_BUMPED
   for (Device = 0;Device < INPUT_PORTS;Device++)
@@ -3195,14 +3793,21 @@ RESULT cInputInit(void)
   UWORD   Set;
 
   InputInstance.TypeDataIndex   =  DATA16_MAX;
+  InputInstance.ScaleVersion    =  1;
 
   InputInstance.MaxDeviceTypes  =  3;
+  InputInstance.TypeDataSize    =  TYPE_DATA_CHUNK;
 
-  cMemoryRealloc(NULL,(void*)&InputInstance.TypeData,(DATA32)(sizeof(TYPES) * InputInstance.MaxDeviceTypes));
+  cMemoryRealloc(NULL,(void*)&InputInstance.TypeData,(DATA32)(sizeof(TYPES) * InputInstance.TypeDataSize));
+  cMemoryRealloc(NULL,(void*)&InputInstance.TypeNext,(DATA32)(sizeof(UWORD) * InputInstance.TypeDataSize));
 
   InputInstance.IicDeviceTypes  =  1;
 
   cMemoryRealloc(NULL,(void*)&InputInstance.IicString,(DATA32)(sizeof(IICSTR) * InputInstance.IicDeviceTypes));
+  if (InputInstance.IicString != NULL)
+  {
+    memset(InputInstance.IicString,0,sizeof(IICSTR) * InputInstance.IicDeviceTypes);
+  }
 
   InputInstance.pAnalog     =  &InputInstance.Analog;
 
@@ -3215,6 +3820,8 @@ RESULT cInputInit(void)
   InputInstance.DcmFile     =  open(DCM_DEVICE_NAME,O_RDWR | O_SYNC);
   InputInstance.IicFile     =  open(IIC_DEVICE_NAME,O_RDWR | O_SYNC);
   InputInstance.DCMUpdate   =  1;
+  InputInstance.DcmScanTimer  =  DCM_SCAN_TIME;
+  cInputClearIicQueues();
 
   if (InputInstance.AdcFile >= MIN_HANDLE)
   {
@@ -3322,6 +3929,9 @@ RESULT cInputInit(void)
   for (Tmp = 0;Tmp < INPUT_PORTS;Tmp++)
   {
     InputInstance.TmpMode[Tmp]  =  MAX_DEVICE_MODES;
+#ifndef DISABLE_FAST_DATALOG_BUFFER
+    InputInstance.AnalogLogOut[Tmp]  =  DEVICE_LOGBUF_SIZE;
+#endif
   }
 
   for (TmpPrgId = 0;TmpPrgId < MAX_PROGRAMS;TmpPrgId++)
@@ -3329,100 +3939,407 @@ RESULT cInputInit(void)
     InputInstance.ConfigurationChanged[TmpPrgId]  =  0;
   }
 
+  InputInstance.pSampler  =  NULL;
+
   return (Result);
 }
 
 RESULT cInputOpen(void)
 {
   RESULT  Result = FAIL;
+#ifndef DISABLE_FAST_DATALOG_BUFFER
+  DATA8   Port;
+
+  for (Port = 0;Port < INPUT_PORTS;Port++)
+  {
+    InputInstance.AnalogLogOut[Port]  =  DEVICE_LOGBUF_SIZE;
+  }
+#endif
+
+  Result  =  OK;
+
+  return (Result);
+}
+
+RESULT cInputClose(void)
+{
+  RESULT  Result = FAIL;
+
+  if (InputInstance.pSampler != NULL)
+  {
+    cSamplerStop(InputInstance.pSampler);
+  }
+  memset(InputInstance.Filter,0,sizeof(InputInstance.Filter));
+  cInputClearIicQueues();
 
   Result  =  OK;
 
   return (Result);
 }
 
-RESULT cInputClose(void)
+RESULT cInputExit(void)
+{
+  RESULT  Result = FAIL;
+
+  if (InputInstance.pSampler != NULL)
+  {
+    cSamplerClose(InputInstance.pSampler);
+    InputInstance.pSampler  =  NULL;
+  }
+
+  cInputCalDataExit();
+
+  if (InputInstance.AdcFile >= MIN_HANDLE)
+  {
+    munmap(InputInstance.pAnalog,sizeof(ANALOG));
+    close(InputInstance.AdcFile);
+  }
+
+  if (InputInstance.UartFile >= MIN_HANDLE)
+  {
+    munmap(InputInstance.pUart,sizeof(UART));
+    close(InputInstance.UartFile);
+  }
+
+  if (InputInstance.IicFile >= MIN_HANDLE)
+  {
+    munmap(InputInstance.pIic,sizeof(IIC));
+    close(InputInstance.IicFile);
+  }
+
+  if (InputInstance.DcmFile >= MIN_HANDLE)
+  {
+    close(InputInstance.DcmFile);
+  }
+
+  if (InputInstance.IicString != NULL)
+  {
+    cMemoryFree((void*)InputInstance.IicString);
+  }
+  if (InputInstance.TypeData != NULL)
+  {
+    cMemoryFree((void*)InputInstance.TypeData);
+  }
+  if (InputInstance.TypeNext != NULL)
+  {
+    cMemoryFree((void*)InputInstance.TypeNext);
+  }
+
+  Result  =  OK;
+
+  return (Result);
+}
+
+DATA8 cInputGetDevice(void)
+{
+  DATA8   Layer;
+  DATA8   No;
+
+  Layer  =  *(DATA8*)PrimParPointer();
+  No     =  *(DATA8*)PrimParPointer();
+
+  return (No + (Layer * INPUT_PORTS));
+}
+
+static void cInputSetType(DATA8 Device, DATA8 Type, DATA8 Mode, int Line)
+{
+  if (InputInstance.DeviceData[Device].DevStatus == OK)
+  {
+    if (Type == TYPE_KEEP)
+    {
+      Type  =  InputInstance.DeviceType[Device];
+    }
+    if (Mode == MODE_KEEP)
+    { // Get actual mode
+
+      Mode  =  InputInstance.DeviceMode[Device];
+    }
+    if ((InputInstance.DeviceType[Device] != Type) || (InputInstance.DeviceMode[Device] != Mode))
+    {
+      cInputSetDeviceType(Device,Type,Mode,Line);
+    }
+  }
+}
+
+/*! \brief    Let background sampler channel sample data set of device
+ *
+ *  The sampler thread reads the value straight from the shared memory of
+ *  the device driver so only devices with raw values there can be sampled.
+ *  Device < 0 disables the channel.
+ */
+static RESULT cInputSetupSampler(DATA8 Channel, DATA8 Device, DATA8 DataSet)
+{
+  RESULT  Result = FAIL;
+  SAMPLER *pSampler;
+  TYPES   *pType;
+  DATA8   Format;
+  DATA32  Size;
+
+  if (InputInstance.pSampler == NULL)
+  {
+    InputInstance.pSampler  =  cSamplerOpen();
+  }
+  pSampler  =  InputInstance.pSampler;
+
+  if ((pSampler != NULL) && (Channel >= 0) && (Channel < SAMPLER_CHANNELS))
+  {
+    if (Device < 0)
+    {
+      Result  =  cSamplerSetup(pSampler,Channel,NULL,NULL,0,0,DATA_F);
+    }
+    else
+    {
+      if (Device < INPUTS)
+      { // Device is local input port
+
+        pType   =  &InputInstance.TypeData[InputInstance.DeviceData[Device].TypeIndex];
+        Format  =  (*pType).Format & 0x0F;
+        Size    =  (Format == DATA_8) ? 1 : ((Format == DATA_16) ? 2 : 4);
+
+        switch (InputInstance.DeviceData[Device].Connection)
+        {
+          case CONN_INPUT_UART :
+          {
+            if ((DataSet >= 0) && (DataSet < (*pType).DataSets))
+            {
+#ifndef DISABLE_FAST_DATALOG_BUFFER
+              Result  =  cSamplerSetup(pSampler,Channel,(*InputInstance.pUart).Raw[Device],&(*InputInstance.pUart).Actual[Device],UART_DATA_LENGTH,DataSet * Size,Format);
+#else
+              Result  =  cSamplerSetup(pSampler,Channel,(*InputInstance.pUart).Raw[Device],NULL,0,DataSet * Size,Format);
+#endif
+            }
+          }
+          break;
+
+          case CONN_NXT_IIC :
+          {
+            if ((DataSet >= 0) && (DataSet < (*pType).DataSets))
+            {
+#ifndef DISABLE_FAST_DATALOG_BUFFER
+              Result  =  cSamplerSetup(pSampler,Channel,(*InputInstance.pIic).Raw[Device],&(*InputInstance.pIic).Actual[Device],IIC_DATA_LENGTH,DataSet * Size,Format);
+#else
+              Result  =  cSamplerSetup(pSampler,Channel,(*InputInstance.pIic).Raw[Device],NULL,0,DataSet * Size,Format);
+#endif
+            }
+          }
+          break;
+
+          case CONN_INPUT_DUMB :
+          {
+            Result  =  cSamplerSetup(pSampler,Channel,&(*InputInstance.pAnalog).InPin6[Device],NULL,0,0,DATA_16);
+          }
+          break;
+
+          case CONN_NXT_DUMB :
+          {
+            Result  =  cSamplerSetup(pSampler,Channel,&(*InputInstance.pAnalog).InPin1[Device],NULL,0,0,DATA_16);
+          }
+          break;
+
+        }
+      }
+      if ((Device >= INPUT_DEVICES) && (Device < (INPUT_DEVICES + OUTPUTS)))
+      { // Device is connected on output port
+
+        if ((InputInstance.DeviceData[Device].Connection != CONN_NONE) && (InputInstance.DeviceData[Device].Connection != CONN_ERROR))
+        {
+          if (InputInstance.DeviceMode[Device] == 2)
+          {
+            Result  =  cSamplerSetup(pSampler,Channel,&OutputInstance.pMotor[Device - INPUT_DEVICES].Speed,NULL,0,0,DATA_8);
+          }
+          else
+          {
+            Result  =  cSamplerSetup(pSampler,Channel,&OutputInstance.pMotor[Device - INPUT_DEVICES].TachoSensor,NULL,0,0,DATA_32);
+          }
+        }
+      }
+    }
+    if (Result == OK)
+    {
+      InputInstance.SamplerDevice[Channel]  =  Device;
+    }
+  }
+
+  return (Result);
+}
+
+/*! \brief    Get array (handle) resized to Elements if it holds elements of Type
+ */
+static void* cInputGetSamplerArray(HANDLER Handle, DATA8 Type, DATA32 Elements)
 {
-  RESULT  Result = FAIL;
+  void    *pArray = NULL;
+  PRGID   TmpPrgId;
 
-  Result  =  OK;
+  TmpPrgId  =  CurrentProgramId();
+  if (cMemoryGetPointer(TmpPrgId,Handle,&pArray) == OK)
+  {
+    if ((*(DESCR*)pArray).Type == Type)
+    {
+      pArray  =  cMemoryResize(TmpPrgId,Handle,Elements);
+    }
+    else
+    {
+      pArray  =  NULL;
+    }
+  }
 
-  return (Result);
+  return (pArray);
 }
 
-RESULT cInputExit(void)
+#ifndef DISABLE_FAST_DATALOG_BUFFER
+/*! \brief    Read new samples from the analog driver log buffers
+ *
+ *  The analog driver logs pin values of all input ports every
+ *  DEVICE_UPDATE_TIME in rings of DEVICE_LOGBUF_SIZE entries. This copies
+ *  the entries logged since last read straight from the shared memory into
+ *  the array (handle) - DATA16 array gets raw values and DATAF array gets
+ *  SI values. Device < 0 reads all ports (interleaved port by port). The
+ *  first read after program start returns all entries in the buffer.
+ *
+ *  Pin 6 is read for CONN_INPUT_DUMB and pin 1 for CONN_NXT_DUMB. Other
+ *  ports have no analog log - reading one fails and reading all ports
+ *  gives 0 (raw) or DATAF_NAN (SI) for them.
+ *
+ *  The driver has no read index for us so an overrun (entries overwritten
+ *  before read) is detected from the driver index at last read: entries
+ *  logged since then plus entries left unread must fit in the buffer. The
+ *  index does not show whole laps so a read later than the time to log
+ *  those entries plus a full buffer is an overrun too.
+ *
+ *  \return   Samples read per port (*pStatus: 0 = ok, 1 = values lost, -1 = no analog log on port)
+ */
+static DATA32 cInputReadAnalogLog(DATA8 Device, HANDLER Handle, DATA8 *pStatus)
 {
-  RESULT  Result = FAIL;
+  DATA32  Count = DEVICE_LOGBUF_SIZE;
+  UWORD   Out[INPUT_PORTS];
+  UWORD   In;
+  UWORD   LastIn;
+  UWORD   Unread;
+  UWORD   Logged;
+  UWORD   New;
+  ULONG   Time;
+  DATA8   First;
+  DATA8   Ports;
+  DATA8   Port;
+  DATA8   Type;
+  DATA16  *pPin;
+  DATA32  Index;
+  void    *pArray = NULL;
 
-  cInputCalDataExit();
+  *pStatus  =  0;
 
-  if (InputInstance.AdcFile >= MIN_HANDLE)
+  if (Device < 0)
   {
-    munmap(InputInstance.pAnalog,sizeof(ANALOG));
-    close(InputInstance.AdcFile);
+    First  =  0;
+    Ports  =  INPUT_PORTS;
   }
-
-  if (InputInstance.UartFile >= MIN_HANDLE)
+  else
   {
-    munmap(InputInstance.pUart,sizeof(UART));
-    close(InputInstance.UartFile);
+    if ((Device >= INPUT_PORTS) || ((InputInstance.DeviceData[Device].Connection != CONN_INPUT_DUMB) && (InputInstance.DeviceData[Device].Connection != CONN_NXT_DUMB)))
+    {
+      *pStatus  =  -1;
+      return (0);
+    }
+    First  =  Device;
+    Ports  =  1;
   }
 
-  if (InputInstance.IicFile >= MIN_HANDLE)
-  {
-    munmap(InputInstance.pIic,sizeof(IIC));
-    close(InputInstance.IicFile);
-  }
+  Time  =  GetTimeUS();
 
-  if (InputInstance.DcmFile >= MIN_HANDLE)
+  for (Port = First;Port < (First + Ports);Port++)
   {
-    close(InputInstance.DcmFile);
+    In          =  (*InputInstance.pAnalog).LogIn[Port] % DEVICE_LOGBUF_SIZE;
+    Out[Port]   =  InputInstance.AnalogLogOut[Port];
+    if (Out[Port] >= DEVICE_LOGBUF_SIZE)
+    { // Not read before
+
+      Out[Port]   =  (In + 1) % DEVICE_LOGBUF_SIZE;
+    }
+    else
+    {
+      LastIn    =  InputInstance.AnalogLogIn[Port];
+      Unread    =  (LastIn + DEVICE_LOGBUF_SIZE - Out[Port]) % DEVICE_LOGBUF_SIZE;
+      Logged    =  (In + DEVICE_LOGBUF_SIZE - LastIn) % DEVICE_LOGBUF_SIZE;
+      if (((Unread + Logged) >= DEVICE_LOGBUF_SIZE) || ((Time - InputInstance.AnalogLogTime[Port]) >= ((ULONG)(Logged + DEVICE_LOGBUF_SIZE) * ANALOG_LOG_ENTRY_TIME)))
+      { // The driver has written over entries not read
+
+        *pStatus    =  1;
+        Out[Port]   =  (In + 1) % DEVICE_LOGBUF_SIZE;
+      }
+    }
+    New         =  (In + DEVICE_LOGBUF_SIZE - Out[Port]) % DEVICE_LOGBUF_SIZE;
+    if (New < Count)
+    {
+      Count     =  New;
+    }
+    InputInstance.AnalogLogIn[Port]    =  In;
+    InputInstance.AnalogLogOut[Port]   =  Out[Port];
+    InputInstance.AnalogLogTime[Port]  =  Time;
   }
 
-  if (InputInstance.IicString != NULL)
+  Type  =  DATA_8;
+  if (cMemoryGetPointer(CurrentProgramId(),Handle,&pArray) == OK)
   {
-    cMemoryFree((void*)InputInstance.IicString);
+    Type  =  (*(DESCR*)pArray).Type;
   }
-  if (InputInstance.TypeData != NULL)
+  pArray  =  NULL;
+  if ((Type == DATA_16) || (Type == DATA_F))
   {
-    cMemoryFree((void*)InputInstance.TypeData);
+    pArray  =  cMemoryResize(CurrentProgramId(),Handle,Count * Ports);
   }
 
-  Result  =  OK;
-
-  return (Result);
-}
+  if (pArray != NULL)
+  {
+    for (Port = First;Port < (First + Ports);Port++)
+    {
+      switch (InputInstance.DeviceData[Port].Connection)
+      {
+        case CONN_INPUT_DUMB :
+        {
+          pPin  =  (*InputInstance.pAnalog).Pin6[Port];
+        }
+        break;
 
-DATA8 cInputGetDevice(void)
-{
-  DATA8   Layer;
-  DATA8   No;
+        case CONN_NXT_DUMB :
+        {
+          pPin  =  (*InputInstance.pAnalog).Pin1[Port];
+        }
+        break;
 
-  Layer  =  *(DATA8*)PrimParPointer();
-  No     =  *(DATA8*)PrimParPointer();
+        default :
+        {
+          pPin  =  NULL;
+        }
+        break;
 
-  return (No + (Layer * INPUT_PORTS));
-}
+      }
 
-static void cInputSetType(DATA8 Device, DATA8 Type, DATA8 Mode, int Line)
-{
-  if (InputInstance.DeviceData[Device].DevStatus == OK)
-  {
-    if (Type == TYPE_KEEP)
-    {
-      Type  =  InputInstance.DeviceType[Device];
-    }
-    if (Mode == MODE_KEEP)
-    { // Get actual mode
+      if (Type == DATA_16)
+      {
+        for (Index = 0;Index < Count;Index++)
+        {
+          ((DATA16*)pArray)[(Index * Ports) + (Port - First)]  =  (pPin != NULL) ? pPin[(Out[Port] + Index) % DEVICE_LOGBUF_SIZE] : 0;
+        }
+      }
+      else
+      {
+        for (Index = 0;Index < Count;Index++)
+        {
+          ((DATAF*)pArray)[(Index * Ports) + (Port - First)]   =  (pPin != NULL) ? cInputScaleSi(Port,(DATAF)pPin[(Out[Port] + Index) % DEVICE_LOGBUF_SIZE]) : DATAF_NAN;
+        }
+      }
 
-      Mode  =  InputInstance.DeviceMode[Device];
-    }
-    if ((InputInstance.DeviceType[Device] != Type) || (InputInstance.DeviceMode[Device] != Mode))
-    {
-      cInputSetDeviceType(Device,Type,Mode,Line);
+      InputInstance.AnalogLogOut[Port]   =  (Out[Port] + Count) % DEVICE_LOGBUF_SIZE;
     }
   }
+  else
+  {
+    Count  =  0;
+  }
+
+  return (Count);
 }
+#endif
 
 //******* BYTE CODE SNIPPETS **************************************************
 
@@ -3682,6 +4599,89 @@ void cInputDeviceList(void)
  *    -  \return (DATA8)   ERROR        - Error if not Third Party type (0 = no error, 1 = error or known)\n
  *
  *\n
+ *\anchor opINPUT_DEVICE_SETUP_SAMPLER
+ *  - CMD = SETUP_SAMPLER
+ *\n  Set up background sampler channel to sample a data set of a device (sampler must be stopped)\n
+ *\n  Analog, UART and IIC sensors on the brick and motors can be sampled (not NXT color or daisy chained)\n
+ *    -  \param  (DATA8)   LAYER        - Chain layer number [0..3]
+ *    -  \param  (DATA8)   NO           - Port number (-1 = channel not used)
+ *    -  \param  (DATA8) \ref types "TYPE" - Device type (0 = don't change type)
+ *    -  \param  (DATA8)   MODE         - Device mode [0..7] (-1 = don't change mode)
+ *    -  \param  (DATA8)   DATASET      - Data set to sample
+ *    -  \param  (DATA8)   CHANNEL      - Sampler channel [0..SAMPLER_CHANNELS - 1]
+ *    -  \return (DATA8)   ERROR        - Channel not set up (0 = no error, 1 = no such channel or device can not be sampled or sampler running)
+ *
+ *\n
+ *\anchor opINPUT_DEVICE_START_SAMPLER
+ *  - CMD = START_SAMPLER
+ *\n  Empty all channels and start sampling on a thread of its own at a fixed period\n
+ *    -  \param  (DATA32)  PERIOD       - Sample period [uS] (min MIN_SAMPLER_PERIOD)
+ *    -  \return (DATA8)   ERROR        - Sampler not started (0 = no error, 1 = period too short or no thread)
+ *
+ *\n
+ *  - CMD = STOP_SAMPLER
+ *\n  Stop background sampler (samples not read yet are kept)\n
+ *
+ *\n
+ *\anchor opINPUT_DEVICE_READ_SAMPLER
+ *  - CMD = READ_SAMPLER
+ *\n  Take samples (oldest first) from background sampler channel\n
+ *    -  \param  (DATA8)   CHANNEL      - Sampler channel [0..SAMPLER_CHANNELS - 1]
+ *    -  \param  (DATA32)  ELEMENTS     - Max number of samples to take
+ *    -  \param  (DATA16)  VALUES       - DATAF array  (handle) - resized to samples taken - SI values
+ *    -  \param  (DATA16)  TIMES        - DATA32 array (handle) - resized to samples taken - time from start [mS] (-1 = not used)
+ *    -  \return (DATA32)  SAMPLES      - Samples taken
+ *    -  \return (DATA32)  DROPPED      - Samples dropped since last read (ring was full)
+ *
+ *\n
+ *\anchor opINPUT_DEVICE_READ_ANALOG_LOG
+ *  - CMD = READ_ANALOG_LOG
+ *\n  Read the analog values logged by the driver (every DEVICE_UPDATE_TIME) since last read\n
+ *\n  First read after program start gets all values in the driver buffer (DEVICE_LOGBUF_SIZE - 1)\n
+ *\n  Pin 6 is logged for EV3 analog sensors (CONN_INPUT_DUMB) and pin 1 for NXT analog sensors (CONN_NXT_DUMB) - reading all ports gives 0 (raw) or NaN (SI) for other ports\n
+ *    -  \param  (DATA8)   LAYER        - Chain layer number [0]
+ *    -  \param  (DATA8)   NO           - Port number (-1 = all ports - values interleaved port by port)
+ *    -  \param  (DATA16)  VALUES       - DATA16 array (handle) for raw values or DATAF array (handle) for SI values - resized to values read
+ *    -  \return (DATA32)  SAMPLES      - Samples read per port
+ *    -  \return (DATA8)   STATUS       - 0 = ok, 1 = values were lost since last read, -1 = port has no analog log (NO >= 0 only)
+ *
+ *\n
+ *\anchor opINPUT_DEVICE_SET_FILTER
+ *  - CMD = SET_FILTER
+ *\n  Filter data set of device on the brick in every input update - READ_SI, READY_PCT, READY_SI and opINPUT_READ return the filtered value\n
+ *\n  Filter is removed when program ends. Samples are dropped when type or mode changes\n
+ *    -  \param  (DATA8)   LAYER        - Chain layer number [0]
+ *    -  \param  (DATA8)   NO           - Port number
+ *    -  \param  (DATA8)   DATASET      - Data set [0..MAX_DEVICE_DATASETS - 1]
+ *    -  \param  (DATA8)   FILTER       - Filter (0 = none, 1 = moving average, 2 = median, 3 = exponential)
+ *    -  \param  (DATA8)   WINDOW       - Samples [1..FILTER_WINDOW_SIZE] (exponential: weight of new sample is 2 / (WINDOW + 1))
+ *
+ *\n
+ *\anchor opINPUT_DEVICE_QUEUE_IIC
+ *  - CMD = QUEUE_IIC
+ *\n  Queue IIC transaction without waiting - transactions on different ports run at the same time\n
+ *\n  A transaction equal to one still waiting on the port is not queued again (the same id is returned)\n
+ *\n  Do not use with READY_IIC or SETUP on the same port\n
+ *    -  \param  (DATA8)   LAYER        - Chain layer number [0]
+ *    -  \param  (DATA8)   NO           - Port number
+ *    -  \param  (DATA8)   WRLNG        - No of bytes to write
+ *    -  \param  (DATA8)   WRDATA       - DATA8 array  (handle) of data to write\n
+ *    -  \param  (DATA8)   RDLNG        - No of bytes to read
+ *    -  \return (DATA16)  ID           - Transaction id (-1 = not an IIC device or IIC_QUEUE_SIZE transactions waiting)
+ *
+ *\n
+ *\anchor opINPUT_DEVICE_RESULT_IIC
+ *  - CMD = RESULT_IIC
+ *\n  Get result of queued IIC transaction (kept until IIC_QUEUE_SIZE newer transactions are queued on the port)\n
+ *    -  \param  (DATA8)   LAYER        - Chain layer number [0]
+ *    -  \param  (DATA8)   NO           - Port number
+ *    -  \param  (DATA16)  ID           - Transaction id from QUEUE_IIC
+ *    -  \param  (DATA8)   WAIT         - Wait for transaction to be done (0 = no, 1 = yes)
+ *    -  \return (DATA8)   RDDATA       - DATA8 array  (handle) to read into\n
+ *    -  \return (DATA32)  TIME         - Time transaction was done [mS] (same time base as opTIMER_READ)
+ *    -  \return (DATA8)   RESULT       - OK, BUSY or FAIL (FAIL if id is unknown)
+ *
+ *\n
  *
  */
 /*! \brief  opINPUT_DEVICE byte code
@@ -3710,6 +4710,7 @@ void cInputDevice(void)
   OBJID   Owner;
   DATA8   Busy;
   DATAF   DataF = (DATAF)0;
+  DATAF   ValueBuf[MAX_DEVICE_DATASETS];
   DATAF   Min = (DATAF)0;
   DATAF   Max = (DATAF)0;
   DATA8   Tmp;
@@ -3727,11 +4728,19 @@ void cInputDevice(void)
   unsigned int IntType;
   RESULT  Result;
   DATA8   *pResult;
+  HANDLER hValues;
+  HANDLER hTimes;
+  DATAF   *pValues;
+  DATA32  *pTimes;
+  DATA32  Samples;
+  DATA32  Dropped;
+  DATA16  Id;
+  IICTRANS *pTrans;
 
 
   TmpIp   =  GetObjectIp();
   Cmd     =  *(DATA8*)PrimParPointer();
-  if ((Cmd != scCAL_MINMAX) && (Cmd != scCAL_MIN) && (Cmd != scCAL_MAX) && (Cmd != scCAL_DEFAULT) && (Cmd != scINSERT_TYPE) && (Cmd != scSET_TYPEMODE) && (Cmd != scCLR_ALL) && (Cmd != scSTOP_ALL))
+  if ((Cmd != scCAL_MINMAX) && (Cmd != scCAL_MIN) && (Cmd != scCAL_MAX) && (Cmd != scCAL_DEFAULT) && (Cmd != scINSERT_TYPE) && (Cmd != scSET_TYPEMODE) && (Cmd != scCLR_ALL) && (Cmd != scSTOP_ALL) && (Cmd != scSETUP_SAMPLER) && (Cmd != scSTART_SAMPLER) && (Cmd != scSTOP_SAMPLER) && (Cmd != scREAD_SAMPLER))
   {
     Device  =  cInputGetDevice();
   }
@@ -3750,6 +4759,7 @@ void cInputDevice(void)
       {
         InputInstance.Calib[Type][Mode].Min       =  Min;
         InputInstance.Calib[Type][Mode].Max       =  Max;
+        InputInstance.ScaleVersion++;
       }
     }
     break;
@@ -3774,6 +4784,7 @@ void cInputDevice(void)
             Min     =  InputInstance.Calib[Type][Mode].Min + (((Min - InputInstance.TypeData[TypeIndex].SiMin) * (InputInstance.Calib[Type][Mode].Max - InputInstance.Calib[Type][Mode].Min)) / (InputInstance.TypeData[TypeIndex].SiMax - InputInstance.TypeData[TypeIndex].SiMin));
           }
           InputInstance.Calib[Type][Mode].Min       =  Min;
+          InputInstance.ScaleVersion++;
         }
       }
     }
@@ -3799,6 +4810,7 @@ void cInputDevice(void)
             Max     =  InputInstance.Calib[Type][Mode].Min + (((Max - InputInstance.TypeData[TypeIndex].SiMin) * (InputInstance.Calib[Type][Mode].Max - InputInstance.Calib[Type][Mode].Min)) / (InputInstance.TypeData[TypeIndex].SiMax - InputInstance.TypeData[TypeIndex].SiMin));
           }
           InputInstance.Calib[Type][Mode].Max       =  Max;
+          InputInstance.ScaleVersion++;
         }
       }
     }
@@ -3812,6 +4824,7 @@ void cInputDevice(void)
       if ((Type > 0) && (Type < (MAX_DEVICE_TYPE + 1)) && (Mode >= 0) && (Mode < MAX_DEVICE_MODES))
       {
         InputInstance.Calib[Type][Mode].InUse   =  0;
+        InputInstance.ScaleVersion++;
       }
     }
     break;
@@ -4048,46 +5061,37 @@ void cInputDevice(void)
         if ((Type >= 0) && (Type < (MAX_DEVICE_TYPE + 1)))
         {
           // try to find device type
-          Index =  0;
-          while (Index < InputInstance.MaxDeviceTypes)
-          {
-            if (InputInstance.TypeData[Index].Type == Type)
-            { // match on type
+          Index  =  cInputLookupTypeData(Type,Mode);
+          if (Index != TYPE_INDEX_NONE)
+          { // match on type and mode
 
-              if (InputInstance.TypeData[Index].Mode == Mode)
-              { // match on mode
+            TmpName  =  InputInstance.TypeData[Index].Name;
 
-                TmpName  =  InputInstance.TypeData[Index].Name;
-
-                if (VMInstance.Handle >= 0)
-                {
-                  Tmp  =  (DATA8)strlen((char*)TmpName) + 1;
+            if (VMInstance.Handle >= 0)
+            {
+              Tmp  =  (DATA8)strlen((char*)TmpName) + 1;
 
-                  if (Length == -1)
-                  {
-                    Length  =  Tmp;
-                  }
-                  pDestination  =  (DATA8*)VmMemoryResize(VMInstance.Handle,(DATA32)Length);
-                }
-                if (pDestination != NULL)
-                {
-                  while ((Count < (Length - 1)) && (TmpName[Count]))
-                  {
-                    pDestination[Count]  =  TmpName[Count];
+              if (Length == -1)
+              {
+                Length  =  Tmp;
+              }
+              pDestination  =  (DATA8*)VmMemoryResize(VMInstance.Handle,(DATA32)Length);
+            }
+            if (pDestination != NULL)
+            {
+              while ((Count < (Length - 1)) && (TmpName[Count]))
+              {
+                pDestination[Count]  =  TmpName[Count];
 
-                    Count++;
-                  }
-                  while (Count < (Length - 1))
-                  {
-                    pDestination[Count]  =  ' ';
+                Count++;
+              }
+              while (Count < (Length - 1))
+              {
+                pDestination[Count]  =  ' ';
 
-                    Count++;
-                  }
-                }
-                Index        =  InputInstance.MaxDeviceTypes;
+                Count++;
               }
             }
-            Index++;
           }
         }
       }
@@ -4197,6 +5201,7 @@ void cInputDevice(void)
                 InputInstance.DeviceData[Device].Owner  =  Owner;
                 cInputSetDeviceType(Device,Type,Mode,__LINE__);
                 InputInstance.DeviceData[Device].TimeoutTimer  =  MAX_DEVICE_BUSY_TIME;
+                cInputDcmNotify(Device);
                 InputInstance.DeviceData[Device].Busy   =  0;
 #ifdef ENABLE_STATUS_TEST
                 if (Device == TESTDEVICE)
@@ -4230,6 +5235,7 @@ void cInputDevice(void)
               if (InputInstance.DeviceData[Device].Busy == 0)
               {
                 InputInstance.DeviceData[Device].TimeoutTimer  =  MAX_DEVICE_BUSY_TIME;
+                cInputDcmNotify(Device);
                 InputInstance.DeviceData[Device].Busy  =  1;
               }
               else
@@ -4247,19 +5253,24 @@ void cInputDevice(void)
             }
             else
             {
+              if (Values > 0)
+              { // Fetch all values at once
+
+                cInputReadDeviceValues(Device,(Cmd == scREADY_PCT) ? DATA_PCT : ((Cmd == scREADY_RAW) ? DATA_RAW : DATA_SI),(Values < MAX_DEVICE_DATASETS) ? Values : MAX_DEVICE_DATASETS,ValueBuf);
+              }
               while ((Value < Values) && (Value < MAX_DEVICE_DATASETS))
               {
                 switch (Cmd)
                 {
                   case scREADY_PCT:
                   {
-                    *(DATA8*)PrimParPointer()     =  (DATA8)cInputReadDevicePct(Device,Value,0,NULL);
+                    *(DATA8*)PrimParPointer()     =  (DATA8)ValueBuf[Value];
                   }
                   break;
 
                   case scREADY_RAW:
                   {
-                    DataF  =  cInputReadDeviceRaw(Device,Value,0,NULL);
+                    DataF  =  ValueBuf[Value];
                     if (isnan(DataF))
                     {
                       *(DATA32*)PrimParPointer()  =  DATA32_NAN;
@@ -4273,7 +5284,7 @@ void cInputDevice(void)
 
                   case scREADY_SI:
                   {
-                    DataF                       =  (DATAF)cInputReadDeviceSi(Device,Value,0,NULL);
+                    DataF                       =  ValueBuf[Value];
                     *(DATAF*)PrimParPointer()   =  DataF;
 
                   }
@@ -4559,6 +5570,174 @@ void cInputDevice(void)
     }
     break;
 
+    case scSETUP_SAMPLER :
+    {
+      Layer   =  *(DATA8*)PrimParPointer();
+      Data8   =  *(DATA8*)PrimParPointer();
+      Type    =  *(DATA8*)PrimParPointer();
+      Mode    =  *(DATA8*)PrimParPointer();
+      Value   =  *(DATA8*)PrimParPointer();
+      Tmp     =  *(DATA8*)PrimParPointer();
+
+      // NO = -1 disables the channel whatever the layer is
+      Device  =  -1;
+      if (Data8 >= 0)
+      {
+        Device  =  DEVICES;
+        if ((Layer >= 0) && (Layer < CHAIN_DEPT) && ((Data8 + (Layer * INPUT_PORTS)) < DEVICES))
+        {
+          Device  =  Data8 + (Layer * INPUT_PORTS);
+          cInputSetType(Device,Type,Mode,__LINE__);
+        }
+      }
+      *(DATA8*)PrimParPointer()  =  (cInputSetupSampler(Tmp,Device,Value) == OK) ? 0 : 1;
+    }
+    break;
+
+    case scSTART_SAMPLER :
+    {
+      Data32  =  *(DATA32*)PrimParPointer();
+      Result  =  FAIL;
+
+      if (InputInstance.pSampler == NULL)
+      {
+        InputInstance.pSampler  =  cSamplerOpen();
+      }
+      if ((InputInstance.pSampler != NULL) && (Data32 > 0))
+      {
+        Result  =  cSamplerStart(InputInstance.pSampler,(ULONG)Data32);
+      }
+      *(DATA8*)PrimParPointer()  =  (Result == OK) ? 0 : 1;
+    }
+    break;
+
+    case scSTOP_SAMPLER :
+    {
+      if (InputInstance.pSampler != NULL)
+      {
+        cSamplerStop(InputInstance.pSampler);
+      }
+    }
+    break;
+
+    case scREAD_SAMPLER :
+    {
+      Tmp       =  *(DATA8*)PrimParPointer();
+      Data32    =  *(DATA32*)PrimParPointer();
+      hValues   =  *(HANDLER*)PrimParPointer();
+      hTimes    =  *(HANDLER*)PrimParPointer();
+      Samples   =  0;
+      Dropped   =  0;
+
+      if ((InputInstance.pSampler != NULL) && (Tmp >= 0) && (Tmp < SAMPLER_CHANNELS) && (Data32 > 0))
+      {
+        pValues =  (DATAF*)cInputGetSamplerArray(hValues,DATA_F,Data32);
+        pTimes  =  NULL;
+        if (hTimes >= 0)
+        {
+          pTimes  =  (DATA32*)cInputGetSamplerArray(hTimes,DATA_32,Data32);
+        }
+        if ((pValues != NULL) && ((hTimes < 0) || (pTimes != NULL)))
+        {
+          Samples  =  cSamplerRead(InputInstance.pSampler,Tmp,Data32,pValues,pTimes,&Dropped);
+
+          Device   =  InputInstance.SamplerDevice[Tmp];
+          for (Data32 = 0;Data32 < Samples;Data32++)
+          {
+            pValues[Data32]  =  cInputScaleSi(Device,pValues[Data32]);
+          }
+        }
+        cInputGetSamplerArray(hValues,DATA_F,Samples);
+        if (hTimes >= 0)
+        {
+          cInputGetSamplerArray(hTimes,DATA_32,Samples);
+        }
+      }
+      *(DATA32*)PrimParPointer()  =  Samples;
+      *(DATA32*)PrimParPointer()  =  Dropped;
+    }
+    break;
+
+    case scREAD_ANALOG_LOG :
+    {
+      hValues   =  *(HANDLER*)PrimParPointer();
+      Samples   =  0;
+      Tmp       =  0;
+
+#ifndef DISABLE_FAST_DATALOG_BUFFER
+      Samples   =  cInputReadAnalogLog(Device,hValues,&Tmp);
+#endif
+
+      *(DATA32*)PrimParPointer()  =  Samples;
+      *(DATA8*)PrimParPointer()   =  Tmp;
+    }
+    break;
+
+    case scSET_FILTER :
+    {
+      Value   =  *(DATA8*)PrimParPointer();
+      Type    =  *(DATA8*)PrimParPointer();
+      Tmp     =  *(DATA8*)PrimParPointer();
+
+      cInputSetupFilter(Device,Value,Type,Tmp);
+    }
+    break;
+
+    case scQUEUE_IIC:
+    { // INPUT_DEVICE(QUEUE_IIC,LAYER,NO,WRLNG,WRDATA,RDLNG,ID)
+
+      WrLng         =  *(DATA8*)PrimParPointer();
+      pWrData       =  (DATA8*)PrimParPointer();
+      RdLng         =  *(DATA8*)PrimParPointer();
+
+      *(DATA16*)PrimParPointer()  =  cInputQueueIic(Device,WrLng,pWrData,RdLng);
+    }
+    break;
+
+    case scRESULT_IIC:
+    { // INPUT_DEVICE(RESULT_IIC,LAYER,NO,ID,WAIT,RDDATA,TIME,RESULT)
+
+      Id            =  *(DATA16*)PrimParPointer();
+      Tmp           =  *(DATA8*)PrimParPointer();
+      pRdData       =  (DATA8*)PrimParPointer();
+      Result        =  FAIL;
+      Data32        =  0;
+
+      pTrans        =  cInputGetIicTrans(Device,Id);
+      if (pTrans != NULL)
+      {
+        cInputServiceIicQueue(Device);
+        Result      =  (*pTrans).Result;
+      }
+      if (Result == OK)
+      {
+        Length      =  (*pTrans).RdLng;
+        if (Length < 0)
+        {
+          Length    =  0 - Length;
+        }
+        if (VMInstance.Handle >= 0)
+        {
+          pRdData   =  (DATA8*)VmMemoryResize(VMInstance.Handle,(DATA32)Length);
+        }
+        if (pRdData != NULL)
+        {
+          Memcpy(pRdData,(*pTrans).RdData,Length);
+        }
+        Data32      =  (DATA32)((*pTrans).Time - VMInstance.Program[CurrentProgramId()].StartTime);
+      }
+      if ((Result == BUSY) && (Tmp))
+      { // Busy -> block VMThread
+
+        SetObjectIp(TmpIp - 1);
+        SetDispatchStatus(BUSYBREAK);
+      }
+
+      *(DATA32*)PrimParPointer()  =  Data32;
+      *(DATA8*)PrimParPointer()   =  (DATA8)Result;
+    }
+    break;
+
   }
 }
 
@@ -4743,6 +5922,7 @@ void cInputWrite(void)
           else
           {
             InputInstance.DeviceData[Device].DevStatus  =  BUSY;
+            cInputDcmNotify(Device);
 
             (*InputInstance.pUart).Status[Device]      &= ~UART_DATA_READY;
 
@@ -4805,6 +5985,7 @@ void cInputWrite(void)
 void cInputReadExt(void)
 {
   DATAF   Raw;
+  DATAF   ValueBuf[MAX_DEVICE_DATASETS];
   DATA8   Type;
   DATA8   Mode;
   DATA8   Format;
@@ -4823,19 +6004,24 @@ void cInputReadExt(void)
   {
     cInputSetType(Device,Type,Mode,__LINE__);
 
-    while ((Value < Values) && (Value < MAX_DEVICE_MODES))
+    if ((Values > 0) && ((Format == DATA_PCT) || (Format == DATA_RAW) || (Format == DATA_SI)))
+    { // Fetch all values at once
+
+      cInputReadDeviceValues(Device,Format,(Values < MAX_DEVICE_DATASETS) ? Values : MAX_DEVICE_DATASETS,ValueBuf);
+    }
+    while ((Value < Values) && (Value < MAX_DEVICE_DATASETS))
     {
       switch (Format)
       {
         case DATA_PCT :
         {
-          *(DATA8*)PrimParPointer()     =  (DATA8)cInputReadDevicePct(Device,Value,0,NULL);
+          *(DATA8*)PrimParPointer()     =  (DATA8)ValueBuf[Value];
         }
         break;
 
         case DATA_RAW :
         {
-          Raw  =  cInputReadDeviceRaw(Device,Value,0,NULL);
+          Raw  =  ValueBuf[Value];
           if (isnan(Raw))
           {
             *(DATA32*)PrimParPointer()  =  DATA32_NAN;
@@ -4849,7 +6035,7 @@ void cInputReadExt(void)
 
         case DATA_SI :
         {
-          *(DATAF*)PrimParPointer()     =  (DATAF)cInputReadDeviceSi(Device,Value,0,NULL);
+          *(DATAF*)PrimParPointer()     =  ValueBuf[Value];
         }
         break;
 
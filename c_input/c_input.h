@@ -23,6 +23,8 @@
 #define C_INPUT_H_
 
 #include  "lms2012.h"
+#include  "c_sampler.h"
+#include  "c_scale.h"
 
 #define   INPUT_PORTS                   INPUTS
 #define   INPUT_DEVICES                 (INPUT_PORTS * CHAIN_DEPT)
@@ -37,6 +39,14 @@
 #define   INPUT_BUFFER_SIZE             (INPUT_VALUES * INPUT_VALUE_SIZE)
 #define   INPUT_SIZE                    (INPUT_VALUES * 2)
 
+#define   ANALOG_LOG_ENTRY_TIME         ((ULONG)DEVICE_UPDATE_TIME / 1000) //!< [uS] Time between analog log buffer entries
+
+#define   DCM_SCAN_TIME                 100   //!< [mS] Time between scans of all devices (catches changes not seen in driver shared memory)
+#define   DCM_PENDING_WORDS             ((DEVICES + 31) / 32)
+
+#define   TYPE_DATA_CHUNK               32      //!< Number of "TypeData" entries allocated at a time
+#define   TYPE_INDEX_NONE               0xFFFF  //!< No "TypeData" entry
+
 RESULT    cInputInit(void);
 RESULT    cInputOpen(void);
 RESULT    cInputClose(void);
@@ -71,6 +81,9 @@ typedef   struct
   RESULT  DevStatus;
   DATA8   Busy;
   DATAF   Raw[MAX_DEVICE_DATASETS];           //!< Raw value (only updated when "cInputReadDeviceRaw" function is called)
+  UWORD   ScaleTypeIndex;                     //!< "TypeData" entry the scale below is calculated from
+  UWORD   ScaleVersion;                       //!< ScaleVersion the scale below is calculated at
+  SCALE   Scale;                              //!< Raw to percent and SI conversion
 #ifndef DISABLE_BUMPED
   DATAF   OldRaw;
   DATA32  Changes;
@@ -80,6 +93,18 @@ typedef   struct
 DEVICE;
 
 
+typedef   struct
+{
+  DATA8   Conn;                               //!< Connection type (from DCM)
+  DATA8   Dcm;                                //!< Device type (from DCM)
+  DATA8   Updated;                            //!< Analog values updated
+  DATA8   UartStatus;
+  DATA8   IicStatus;
+  DATA8   IicChanged;
+}
+DCMSTATE;
+
+
 typedef   struct
 {
   DATA8   InUse;
@@ -89,6 +114,108 @@ typedef   struct
 CALIB;
 
 
+// Input filters (opINPUT_DEVICE SET_FILTER)
+
+enum
+{
+  FILTER_NONE             = 0,                  //!< Value not filtered
+  FILTER_AVERAGE          = 1,                  //!< Mean of last WINDOW samples
+  FILTER_MEDIAN           = 2,                  //!< Median of last WINDOW samples
+  FILTER_EXPONENTIAL      = 3,                  //!< Exponential smoothing (weight of new sample 2 / (WINDOW + 1))
+
+  FILTERS
+};
+
+typedef   struct
+{
+  DATA8   Type;                               //!< FILTER_xxx
+  DATA8   Window;                             //!< Samples in window [1..FILTER_WINDOW_SIZE]
+  DATA8   Samples;                            //!< Samples in window now (0 = no output yet)
+  DATA8   Next;                               //!< Next sample in window to overwrite
+  DATAF   Weight;                             //!< Weight of new sample (FILTER_EXPONENTIAL)
+  DATAF   Output;                             //!< Filtered raw value
+  DATAF   Sample[FILTER_WINDOW_SIZE];
+}
+FILTER;
+
+
+/*
+ *  IIC transaction queue
+ *
+ *  Transactions are queued per port and run one at a time on the port by
+ *  the input update (all ports at the same time). A transaction is
+ *  identified by a running id - it stays in the queue until IIC_QUEUE_SIZE
+ *  newer transactions have been queued on the port.
+ */
+
+#define   IIC_ID_MASK                   0x7FFF  //!< Transaction ids run from 0 to IIC_ID_MASK
+
+#if (IIC_QUEUE_SIZE & (IIC_QUEUE_SIZE - 1))
+#error "IIC_QUEUE_SIZE must be a power of 2"
+#endif
+
+typedef   struct
+{
+  DATA16  Id;                                 //!< Transaction id (-1 = not used)
+  RESULT  Result;                             //!< BUSY until transaction is done
+  DATA8   Started;                            //!< Transaction handed to driver
+  DATA8   WrLng;
+  DATA8   WrData[IIC_DATA_LENGTH];
+  DATA8   RdLng;                              //!< Bytes to read (negative = reverse byte order)
+  DATA8   RdData[IIC_DATA_LENGTH];
+  ULONG   Time;                               //!< Time transaction was done [mS]
+}
+IICTRANS;
+
+typedef   struct
+{
+  UWORD   In;                                 //!< Id of next transaction queued
+  UWORD   Out;                                //!< Id of transaction running (Out = In if none)
+  IICTRANS Trans[IIC_QUEUE_SIZE];
+}
+IICQUEUE;
+
+
+/*
+ *  Type database
+ *
+ *  The type data files are compiled into one binary file in the settings
+ *  folder. It is loaded in one go instead of parsing the files as long as
+ *  the same files exist with the same size and modification time.
+ *
+ *  Database file   TYPEDBHEAD
+ *                  Sources * TYPEDBSOURCE
+ *                  Types * TYPES
+ *                  IicTypes * IICSTR
+ */
+
+#define   TYPEDB_MAGIC                  0x31424454  //!< "TDB1"
+#define   TYPEDB_VERSION                1           //!< Change when content of tables changes meaning
+#define   TYPEDB_FILE_NAME              "typedata.rdb"  //!< Database file name in settings folder
+#define   TYPEDB_SOURCES                (TYPE_THIRD_PARTY_END - TYPE_THIRD_PARTY_START + 2) //!< "typedata.rcf" and "typedataNN.rcf"
+
+typedef   struct
+{
+  ULONG   Magic;
+  ULONG   Version;
+  ULONG   TypeSize;                           //!< sizeof(TYPES) when written
+  ULONG   IicSize;                            //!< sizeof(IICSTR) when written
+  ULONG   Sources;                            //!< Number of source files
+  ULONG   Types;                              //!< Number of "TypeData" entries
+  ULONG   IicTypes;                           //!< Number of "IicString" entries
+}
+TYPEDBHEAD;
+
+typedef   struct
+{
+  ULONG   Number;                             //!< Source file number (0 = "typedata.rcf")
+  ULONG   Size;
+  ULONG   Time;                               //!< Modification time [S]
+  ULONG   TimeNs;                             //!< Modification time [nS]
+}
+TYPEDBSOURCE;
+
+
 typedef struct
 {
   //*****************************************************************************
@@ -130,11 +257,22 @@ typedef struct
   UWORD     NoneIndex;
   UWORD     UnknownIndex;
   DATA8     DCMUpdate;
+  DCMSTATE  DcmState[INPUT_PORTS + OUTPUT_PORTS]; //!< Driver state of local ports last seen by the connection manager
+  ULONG     DcmPending[DCM_PENDING_WORDS];    //!< Devices the connection manager must service (bit per device)
+  UWORD     DcmScanTimer;                     //!< mS since all devices were serviced
+  ULONG     DcmChangeTime[DEVICES];           //!< Time connection change was seen [mS] (0 = no change waiting)
+  ULONG     DcmLatency;                       //!< mS from last connection change until device was ready
+  ULONG     DcmLatencyMax;                    //!< Max of DcmLatency
 
   DATA8     TypeModes[MAX_DEVICE_TYPE + 1];   //!< No of modes for specific type
+  UWORD     ScaleVersion;                     //!< Changed when calibration or type data changes
 
   UWORD     MaxDeviceTypes;                   //!< Number of device type/mode entries in table
+  UWORD     TypeDataSize;                     //!< Number of entries allocated for table
   TYPES     *TypeData;                        //!< Type specific data
+  UWORD     *TypeNext;                        //!< Next entry with same type and mode (one for each entry in table)
+  UWORD     TypeFirst[MAX_DEVICE_TYPE + 1][MAX_DEVICE_MODES]; //!< First entry with type and mode
+  UWORD     TypeLast[MAX_DEVICE_TYPE + 1];    //!< Last entry with type (any mode)
   UWORD     IicDeviceTypes;                   //!< Number of IIC device type/mode entries in table
   IICSTR    *IicString;
   IICSTR    IicStr;
@@ -144,6 +282,27 @@ typedef struct
 
 
   CALIB     Calib[MAX_DEVICE_TYPE][MAX_DEVICE_MODES];
+
+#ifndef DISABLE_FAST_DATALOG_BUFFER
+  UWORD     AnalogLogOut[INPUT_PORTS];        //!< Next analog log buffer entry to read (DEVICE_LOGBUF_SIZE = not read yet)
+  UWORD     AnalogLogIn[INPUT_PORTS];         //!< Driver log buffer index at last read
+  ULONG     AnalogLogTime[INPUT_PORTS];       //!< Time of last analog log buffer read [uS]
+#endif
+
+#ifndef DISABLE_OLD_COLOR
+  UWORD     ColorADRaw[INPUT_PORTS][COLORS];  //!< NXT color sensor raw values last calibrated
+  ULONG     ColorCalibration[INPUT_PORTS][CALPOINTS][COLORS]; //!< NXT color sensor calibration last used
+  UWORD     ColorCalLimits[INPUT_PORTS][CALPOINTS - 1];       //!< NXT color sensor calibration limits last used
+  UWORD     ColorCrc[INPUT_PORTS];            //!< NXT color sensor calibration CRC last used
+  DATA8     ColorValid[INPUT_PORTS];          //!< Calibrated values and color below are calculated
+  DATA8     Color[INPUT_PORTS];               //!< NXT color sensor color
+#endif
+
+  IICQUEUE  IicQueue[INPUT_PORTS];            //!< Queued IIC transactions
+  FILTER    Filter[INPUT_PORTS][MAX_DEVICE_DATASETS]; //!< Filters on data sets of devices on the brick (updated every cInputUpdate)
+
+  SAMPLER   *pSampler;                        //!< Background sampler (NULL until first used)
+  DATA8     SamplerDevice[SAMPLER_CHANNELS];  //!< Device sampled by channel (scaled to SI when read)
 } INPUT_GLOBALS;
 
 extern INPUT_GLOBALS InputInstance;
@@ -0,0 +1,360 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ *  Background input sampler
+ *
+ *  opINPUT_SAMPLE reads the devices when the byte code is executed so the
+ *  sample rate depends on how busy the VM is. The sampler reads up to
+ *  SAMPLER_CHANNELS values directly from the device shared memory on its own
+ *  thread at a fixed period and stores them with a time stamp in a ring per
+ *  channel. The VM drains the rings in bulk whenever it gets to it.
+ *
+ *  Every ring has one writer (the sampler thread) and one reader (the VM) so
+ *  no locks are needed: the sampler thread only moves "Head" and the VM only
+ *  moves "Tail". If the VM does not drain a ring in time new samples are
+ *  dropped and counted.
+ *
+ *  The sampler thread sleeps until an absolute time so the period does not
+ *  drift. It waits on a condition variable so stopping does not have to wait
+ *  for a long period to end. If a period is missed (the thread was not scheduled in time) it is
+ *  skipped and counted instead of sampling in a burst to catch up. The thread
+ *  asks for real time scheduling and just runs at normal priority if that is
+ *  not allowed.
+ *
+ *  Channels are set up while the sampler is stopped so the sampler thread
+ *  can read the channel set up without locking.
+ */
+
+
+#include  "lms2012.h"
+#include  "c_sampler.h"
+
+#include  <sched.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+
+
+static void cSamplerAddTime(struct timespec *pTime,ULONG Time)
+{
+  (*pTime).tv_nsec +=  (long)(Time % 1000000) * 1000L;
+  (*pTime).tv_sec  +=  (time_t)(Time / 1000000);
+  if ((*pTime).tv_nsec >= 1000000000L)
+  {
+    (*pTime).tv_nsec -=  1000000000L;
+    (*pTime).tv_sec++;
+  }
+}
+
+
+static ULONG cSamplerGetTime(struct timespec *pStart,struct timespec *pNow)
+{
+  return ((ULONG)((*pNow).tv_sec - (*pStart).tv_sec) * 1000 + (ULONG)(((*pNow).tv_nsec - (*pStart).tv_nsec) / 1000000L));
+}
+
+
+static DATAF cSamplerGetValue(SAMPLERCHANNEL *pChannel)
+{
+  DATAF   Value = DATAF_NAN;
+  const volatile UBYTE *pValue;
+  DATA8   Data8;
+  DATA16  Data16;
+  DATA32  Data32;
+
+  pValue  =  (*pChannel).pSource + (*pChannel).Offset;
+  if ((*pChannel).pActual != NULL)
+  {
+    pValue +=  (DATA32)*(*pChannel).pActual * (*pChannel).Stride;
+  }
+
+  // Values in shared memory are not always aligned
+
+  switch ((*pChannel).Format)
+  {
+    case DATA_8 :
+    {
+      Data8  =  *(const volatile DATA8*)pValue;
+      if (Data8 != DATA8_NAN)
+      {
+        Value  =  (DATAF)Data8;
+      }
+    }
+    break;
+
+    case DATA_16 :
+    {
+      memcpy((void*)&Data16,(const void*)pValue,sizeof(Data16));
+      if (Data16 != DATA16_NAN)
+      {
+        Value  =  (DATAF)Data16;
+      }
+    }
+    break;
+
+    case DATA_32 :
+    {
+      memcpy((void*)&Data32,(const void*)pValue,sizeof(Data32));
+      if (Data32 != DATA32_NAN)
+      {
+        Value  =  (DATAF)Data32;
+      }
+    }
+    break;
+
+    case DATA_F :
+    {
+      memcpy((void*)&Value,(const void*)pValue,sizeof(Value));
+    }
+    break;
+
+  }
+
+  return (Value);
+}
+
+
+static void *cSamplerThread(void *pArg)
+{
+  SAMPLER *pSampler = (SAMPLER*)pArg;
+  SAMPLERCHANNEL *pChannel;
+  struct  sched_param Param;
+  struct  timespec Start;
+  struct  timespec Next;
+  struct  timespec Now;
+  ULONG   Time;
+  ULONG   Head;
+  long    Late;
+  DATA8   Channel;
+
+  Param.sched_priority  =  sched_get_priority_max(SCHED_FIFO) / 2;
+  pthread_setschedparam(pthread_self(),SCHED_FIFO,&Param);
+
+  clock_gettime(CLOCK_MONOTONIC,&Start);
+  Next  =  Start;
+
+  pthread_mutex_lock(&(*pSampler).Lock);
+  while (!(*pSampler).Stop)
+  {
+    pthread_mutex_unlock(&(*pSampler).Lock);
+
+    clock_gettime(CLOCK_MONOTONIC,&Now);
+    Time  =  cSamplerGetTime(&Start,&Now);
+
+    for (Channel = 0;Channel < SAMPLER_CHANNELS;Channel++)
+    {
+      pChannel  =  &(*pSampler).Channel[Channel];
+      if ((*pChannel).pSource != NULL)
+      {
+        Head  =  (*pChannel).Head;
+        if ((Head - __atomic_load_n(&(*pChannel).Tail,__ATOMIC_ACQUIRE)) < SAMPLER_RING_SIZE)
+        {
+          (*pChannel).Ring[Head & (SAMPLER_RING_SIZE - 1)].Time   =  Time;
+          (*pChannel).Ring[Head & (SAMPLER_RING_SIZE - 1)].Value  =  cSamplerGetValue(pChannel);
+          __atomic_store_n(&(*pChannel).Head,Head + 1,__ATOMIC_RELEASE);
+        }
+        else
+        {
+          __atomic_add_fetch(&(*pChannel).Dropped,1,__ATOMIC_RELAXED);
+        }
+      }
+    }
+
+    cSamplerAddTime(&Next,(*pSampler).Period);
+
+    clock_gettime(CLOCK_MONOTONIC,&Now);
+    Late  =  (long)(Now.tv_sec - Next.tv_sec) * 1000000L + (Now.tv_nsec - Next.tv_nsec) / 1000L;
+    if (Late > 0)
+    { // Next period already started - skip the periods missed
+
+      Late  =  Late / (long)(*pSampler).Period + 1;
+      __atomic_add_fetch(&(*pSampler).Overruns,(DATA32)Late,__ATOMIC_RELAXED);
+      cSamplerAddTime(&Next,(ULONG)Late * (*pSampler).Period);
+    }
+
+    // Wait for next period - cSamplerStop wakes us up at once
+
+    pthread_mutex_lock(&(*pSampler).Lock);
+    while ((!(*pSampler).Stop) && (pthread_cond_timedwait(&(*pSampler).Wake,&(*pSampler).Lock,&Next) == 0))
+    { // Woken up early (stop or spurious)
+
+    }
+  }
+  pthread_mutex_unlock(&(*pSampler).Lock);
+
+  return (NULL);
+}
+
+
+SAMPLER*  cSamplerOpen(void)
+{
+  SAMPLER *pSampler;
+  pthread_condattr_t Attr;
+
+  pSampler  =  (SAMPLER*)calloc(1,sizeof(SAMPLER));
+  if (pSampler != NULL)
+  {
+    if ((pthread_condattr_init(&Attr) == 0) && (pthread_condattr_setclock(&Attr,CLOCK_MONOTONIC) == 0) && (pthread_cond_init(&(*pSampler).Wake,&Attr) == 0))
+    {
+      pthread_condattr_destroy(&Attr);
+      pthread_mutex_init(&(*pSampler).Lock,NULL);
+    }
+    else
+    {
+      free(pSampler);
+      pSampler  =  NULL;
+    }
+  }
+
+  return (pSampler);
+}
+
+
+/*! \brief    Set up sampler channel
+ *
+ *  Channel is emptied. pSource = NULL disables the channel.
+ *  Fails if the sampler is running.
+ */
+RESULT    cSamplerSetup(SAMPLER *pSampler,DATA8 Channel,const volatile void *pSource,const volatile UWORD *pActual,DATA32 Stride,DATA32 Offset,DATA8 Format)
+{
+  RESULT  Result = FAIL;
+  SAMPLERCHANNEL *pChannel;
+
+  if ((!(*pSampler).Running) && (Channel >= 0) && (Channel < SAMPLER_CHANNELS))
+  {
+    pChannel               =  &(*pSampler).Channel[Channel];
+    (*pChannel).pSource    =  (const volatile UBYTE*)pSource;
+    (*pChannel).pActual    =  pActual;
+    (*pChannel).Stride     =  Stride;
+    (*pChannel).Offset     =  Offset;
+    (*pChannel).Format     =  Format;
+    (*pChannel).Head       =  0;
+    (*pChannel).Tail       =  0;
+    (*pChannel).Dropped    =  0;
+    Result                 =  OK;
+  }
+
+  return (Result);
+}
+
+
+/*! \brief    Start sampling all channels set up every Period [uS]
+ *
+ *  All channels are emptied and time stamps start from 0.
+ *  A running sampler is restarted.
+ */
+RESULT    cSamplerStart(SAMPLER *pSampler,ULONG Period)
+{
+  RESULT  Result = FAIL;
+  DATA8   Channel;
+
+  cSamplerStop(pSampler);
+
+  if (Period >= MIN_SAMPLER_PERIOD)
+  {
+    for (Channel = 0;Channel < SAMPLER_CHANNELS;Channel++)
+    {
+      (*pSampler).Channel[Channel].Head     =  0;
+      (*pSampler).Channel[Channel].Tail     =  0;
+      (*pSampler).Channel[Channel].Dropped  =  0;
+    }
+    (*pSampler).Period    =  Period;
+    (*pSampler).Overruns  =  0;
+    (*pSampler).Stop      =  0;
+
+    if (pthread_create(&(*pSampler).Thread,NULL,cSamplerThread,pSampler) == 0)
+    {
+      (*pSampler).Running  =  1;
+      Result               =  OK;
+    }
+  }
+
+  return (Result);
+}
+
+
+/*! \brief    Stop sampling
+ *
+ *  Samples not read yet are kept
+ */
+void      cSamplerStop(SAMPLER *pSampler)
+{
+  if ((*pSampler).Running)
+  {
+    pthread_mutex_lock(&(*pSampler).Lock);
+    (*pSampler).Stop  =  1;
+    pthread_cond_signal(&(*pSampler).Wake);
+    pthread_mutex_unlock(&(*pSampler).Lock);
+    pthread_join((*pSampler).Thread,NULL);
+    (*pSampler).Running  =  0;
+
+#ifdef DEBUG_C_INPUT
+    printf("c_sampler stopped: Period=%luuS Overruns=%d\n",(unsigned long)(*pSampler).Period,(*pSampler).Overruns);
+#endif
+  }
+}
+
+
+/*! \brief    Take up to Elements samples (oldest first) from channel
+ *
+ *  Times are in mS from sampler start (pTimes may be NULL) so they stay
+ *  positive for more than 24 days. *pDropped returns the samples dropped
+ *  since last read.
+ *
+ *  \return   Samples taken
+ */
+DATA32    cSamplerRead(SAMPLER *pSampler,DATA8 Channel,DATA32 Elements,DATAF *pValues,DATA32 *pTimes,DATA32 *pDropped)
+{
+  SAMPLERCHANNEL *pChannel;
+  ULONG   Tail;
+  ULONG   Available;
+  DATA32  Index = 0;
+
+  *pDropped  =  0;
+  if ((Channel >= 0) && (Channel < SAMPLER_CHANNELS))
+  {
+    pChannel   =  &(*pSampler).Channel[Channel];
+    Tail       =  (*pChannel).Tail;
+    Available  =  __atomic_load_n(&(*pChannel).Head,__ATOMIC_ACQUIRE) - Tail;
+
+    while ((Index < Elements) && ((ULONG)Index < Available))
+    {
+      pValues[Index]    =  (*pChannel).Ring[(Tail + (ULONG)Index) & (SAMPLER_RING_SIZE - 1)].Value;
+      if (pTimes != NULL)
+      {
+        pTimes[Index]   =  (DATA32)(*pChannel).Ring[(Tail + (ULONG)Index) & (SAMPLER_RING_SIZE - 1)].Time;
+      }
+      Index++;
+    }
+    __atomic_store_n(&(*pChannel).Tail,Tail + (ULONG)Index,__ATOMIC_RELEASE);
+    *pDropped  =  __atomic_exchange_n(&(*pChannel).Dropped,0,__ATOMIC_RELAXED);
+  }
+
+  return (Index);
+}
+
+
+void      cSamplerClose(SAMPLER *pSampler)
+{
+  cSamplerStop(pSampler);
+  pthread_cond_destroy(&(*pSampler).Wake);
+  pthread_mutex_destroy(&(*pSampler).Lock);
+  free(pSampler);
+}
@@ -0,0 +1,87 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef C_SAMPLER_H_
+#define C_SAMPLER_H_
+
+#include  "lms2012.h"
+
+#include  <pthread.h>
+
+#if (SAMPLER_RING_SIZE & (SAMPLER_RING_SIZE - 1))
+#error "SAMPLER_RING_SIZE must be a power of 2"
+#endif
+
+typedef   struct
+{
+  ULONG     Time;                               // Time from sampler start [mS]
+  DATAF     Value;                              // Raw value
+}
+SAMPLE;
+
+/*
+ *  The value of a channel is read at
+ *
+ *    pSource + (*pActual * Stride) + Offset      (pActual != NULL)
+ *    pSource + Offset                            (pActual == NULL)
+ *
+ *  so values in the device log buffers of the shared memory can be followed
+ */
+
+typedef   struct
+{
+  const volatile UBYTE *pSource;                // Shared memory holding the value (NULL = channel not used)
+  const volatile UWORD *pActual;                // Index of newest entry in log buffer (NULL = no log buffer)
+  DATA32    Stride;                             // Bytes between log buffer entries
+  DATA32    Offset;                             // Byte offset of value in entry
+  DATA8     Format;                             // DATA_8, DATA_16, DATA_32 or DATA_F
+
+  ULONG     Head;                               // Next sample written (sampler thread - atomic access only)
+  ULONG     Tail;                               // Next sample read (VM - atomic access only)
+  DATA32    Dropped;                            // Samples lost because the ring was full (atomic access only)
+  SAMPLE    Ring[SAMPLER_RING_SIZE];
+}
+SAMPLERCHANNEL;
+
+typedef   struct
+{
+  pthread_t Thread;
+  pthread_mutex_t Lock;                         // Guards Stop while the sampler thread waits for next period
+  pthread_cond_t  Wake;                         // Signalled on stop (CLOCK_MONOTONIC)
+  DATA8     Running;                            // Sampler thread started
+  DATA8     Stop;                               // Sampler thread must terminate (set with Lock held)
+  ULONG     Period;                             // Sample period [uS]
+  DATA32    Overruns;                           // Sample periods missed (atomic access only)
+  SAMPLERCHANNEL Channel[SAMPLER_CHANNELS];
+}
+SAMPLER;
+
+SAMPLER*  cSamplerOpen(void);
+
+RESULT    cSamplerSetup(SAMPLER *pSampler,DATA8 Channel,const volatile void *pSource,const volatile UWORD *pActual,DATA32 Stride,DATA32 Offset,DATA8 Format);
+
+RESULT    cSamplerStart(SAMPLER *pSampler,ULONG Period);
+
+void      cSamplerStop(SAMPLER *pSampler);
+
+DATA32    cSamplerRead(SAMPLER *pSampler,DATA8 Channel,DATA32 Elements,DATAF *pValues,DATA32 *pTimes,DATA32 *pDropped);
+
+void      cSamplerClose(SAMPLER *pSampler);
+
+#endif /* C_SAMPLER_H_ */
@@ -0,0 +1,209 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ *  Percent
+ *
+ *  Inside the range the raw difference is smaller than the raw span so
+ *  Diff * PctSpan fits in 24 bits. Multiplying by the 32 bit reciprocal of
+ *  the span gives the quotient or one less - one compare and add makes it
+ *  exact. The remainder tells if the float formula would have had a
+ *  fraction to truncate towards zero.
+ *
+ *  SI
+ *
+ *  Scale and offset are fixed point with a shift chosen per device so they
+ *  keep as many bits as fit. The sum is exact in 64 bits and is converted
+ *  to DATAF in one step.
+ */
+
+
+#include  "c_scale.h"
+
+#include  <math.h>
+
+
+static DATA8 cScaleIsInt(DATAF Value)
+{
+  DATA8   Result = 0;
+
+  if ((Value >= (DATAF)-SCALE_MAX_RAW) && (Value <= (DATAF)SCALE_MAX_RAW))
+  {
+    if ((DATAF)(DATA32)Value == Value)
+    {
+      Result  =  1;
+    }
+  }
+
+  return (Result);
+}
+
+
+void      cScaleSetup(SCALE *pScale,DATAF RawMin,DATAF RawMax,DATAF PctMin,DATAF PctMax,DATAF SiMin,DATAF SiMax)
+{
+  double  Scale;
+  DATA32  Span;
+  int     Shift;
+  int     Exp;
+
+  (*pScale).RawMin    =  RawMin;
+  (*pScale).RawMax    =  RawMax;
+  (*pScale).PctMin    =  PctMin;
+  (*pScale).PctMax    =  PctMax;
+  (*pScale).SiMin     =  SiMin;
+  (*pScale).SiMax     =  SiMax;
+  (*pScale).PctInt    =  0;
+  (*pScale).SiInt     =  0;
+
+  if ((cScaleIsInt(RawMin)) && (cScaleIsInt(RawMax)) && (RawMin != RawMax))
+  {
+    (*pScale).RawMinInt  =  (DATA32)RawMin;
+    (*pScale).RawSpan    =  (DATA32)RawMax - (DATA32)RawMin;
+    Span                 =  ((*pScale).RawSpan < 0) ? -(*pScale).RawSpan : (*pScale).RawSpan;
+
+    if ((Span <= SCALE_MAX_SPAN) && (cScaleIsInt(PctMin)) && (cScaleIsInt(PctMax)) && (PctMin >= (DATAF)-128) && (PctMax <= (DATAF)127) && (PctMin <= PctMax))
+    {
+      (*pScale).PctMinInt  =  (DATA32)PctMin;
+      (*pScale).PctSpan    =  (DATA32)PctMax - (DATA32)PctMin;
+      (*pScale).PctRecip   =  0xFFFFFFFFU / (ULONG)Span;
+      (*pScale).PctInt     =  1;
+    }
+
+    if ((isfinite(SiMin)) && (isfinite(SiMax)))
+    {
+      Scale  =  ((double)SiMax - (double)SiMin) / (double)(*pScale).RawSpan;
+      Shift  =  SCALE_SI_MAX_SHIFT;
+      if (Scale != 0.0)
+      {
+        frexp(Scale,&Exp);
+        if (Shift > (SCALE_SI_BITS - Exp))
+        {
+          Shift  =  SCALE_SI_BITS - Exp;
+        }
+      }
+      if (SiMin != (DATAF)0)
+      {
+        frexp((double)SiMin,&Exp);
+        if (Shift > (SCALE_SI_OFFSET_BITS - Exp))
+        {
+          Shift  =  SCALE_SI_OFFSET_BITS - Exp;
+        }
+      }
+      if (Shift >= 0)
+      {
+        (*pScale).SiScale   =  (int64_t)llround(ldexp(Scale,Shift));
+        (*pScale).SiOffset  =  (int64_t)llround(ldexp((double)SiMin,Shift));
+        (*pScale).SiUnit    =  ldexpf(1.0f,-Shift);
+        (*pScale).SiInt     =  1;
+      }
+    }
+  }
+}
+
+
+/*! \brief    Convert raw value to percent
+ *
+ *  Limited to PctMin..PctMax and truncated towards zero. Raw must not be NaN.
+ */
+DATA8     cScalePct(SCALE *pScale,DATAF Raw)
+{
+  DATA8   Result;
+  DATAF   Pct;
+  DATA32  Diff;
+  DATA32  Span;
+  DATA32  Value;
+  ULONG   Product;
+  ULONG   Quotient;
+
+  if (((*pScale).PctInt) && (cScaleIsInt(Raw)))
+  {
+    Diff  =  (DATA32)Raw - (*pScale).RawMinInt;
+    Span  =  (*pScale).RawSpan;
+    if (Span < 0)
+    {
+      Diff  =  -Diff;
+      Span  =  -Span;
+    }
+
+    if (Diff <= 0)
+    {
+      Value  =  (*pScale).PctMinInt;
+    }
+    else
+    {
+      if (Diff >= Span)
+      {
+        Value  =  (*pScale).PctMinInt + (*pScale).PctSpan;
+      }
+      else
+      {
+        Product   =  (ULONG)Diff * (ULONG)(*pScale).PctSpan;
+        Quotient  =  (ULONG)(((uint64_t)Product * (*pScale).PctRecip) >> 32);
+        if (((Quotient + 1) * (ULONG)Span) <= Product)
+        {
+          Quotient++;
+        }
+        Value  =  (*pScale).PctMinInt + (DATA32)Quotient;
+        if ((Value < 0) && ((Quotient * (ULONG)Span) != Product))
+        { // Truncate towards zero
+
+          Value++;
+        }
+      }
+    }
+    Result  =  (DATA8)Value;
+  }
+  else
+  {
+    Pct  =  (((Raw - (*pScale).RawMin) * ((*pScale).PctMax - (*pScale).PctMin)) / ((*pScale).RawMax - (*pScale).RawMin) + (*pScale).PctMin);
+
+    if (Pct > (*pScale).PctMax)
+    {
+      Pct  =  (*pScale).PctMax;
+    }
+    if (Pct < (*pScale).PctMin)
+    {
+      Pct  =  (*pScale).PctMin;
+    }
+    Result  =  (DATA8)Pct;
+  }
+
+  return (Result);
+}
+
+
+/*! \brief    Convert raw value to SI value
+ *
+ *  Not limited. Raw must not be NaN.
+ */
+DATAF     cScaleSi(SCALE *pScale,DATAF Raw)
+{
+  DATAF   Result;
+
+  if (((*pScale).SiInt) && (cScaleIsInt(Raw)))
+  {
+    Result  =  (DATAF)(((int64_t)((DATA32)Raw - (*pScale).RawMinInt) * (*pScale).SiScale) + (*pScale).SiOffset) * (*pScale).SiUnit;
+  }
+  else
+  {
+    Result  =  (((Raw - (*pScale).RawMin) * ((*pScale).SiMax - (*pScale).SiMin)) / ((*pScale).RawMax - (*pScale).RawMin) + (*pScale).SiMin);
+  }
+
+  return (Result);
+}
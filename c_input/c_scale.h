@@ -0,0 +1,80 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef C_SCALE_H_
+#define C_SCALE_H_
+
+#include  "lmstypes.h"
+
+#include  <stdint.h>
+
+/*
+ *  Conversion of device raw values to percent and SI values
+ *
+ *    Pct = (Raw - RawMin) * (PctMax - PctMin) / (RawMax - RawMin) + PctMin
+ *    Si  = (Raw - RawMin) * (SiMax - SiMin) / (RawMax - RawMin) + SiMin
+ *
+ *  cScaleSetup() prepares integer coefficients once so a reading is
+ *  converted with integer multiplies only. Readings, limits or ranges that
+ *  are not whole numbers use the formula above in floating point.
+ *
+ *  Percent results are the same as the floating point formula truncated
+ *  to DATA8 (checked for all raw ranges up to SCALE_MAX_SPAN, see
+ *  lmssrc/adk/scalecheck). SI results are the exact value rounded once to
+ *  DATAF - within 1 ULP of the largest of |SiMin|, |SiMax| and
+ *  |(Raw - RawMin) * (SiMax - SiMin) / (RawMax - RawMin)|. The floating
+ *  point formula rounds three times and is up to 3 ULP of that off, so the
+ *  two differ by at most 4 ULP.
+ */
+
+#define   SCALE_MAX_RAW       16777216                // Largest raw value converted in integer (2^24 - all integers below are exact in DATAF)
+#define   SCALE_MAX_SPAN      65536                   // Largest |RawMax - RawMin| converted in integer for percent
+#define   SCALE_SI_BITS       37                      // Max bits in SI scale (raw difference * scale + offset must fit in 63 bits)
+#define   SCALE_SI_OFFSET_BITS  61                    // Max bits in SI offset
+#define   SCALE_SI_MAX_SHIFT  126                     // 2^-shift must be a normal DATAF
+
+typedef   struct
+{
+  DATAF     RawMin;
+  DATAF     RawMax;
+  DATAF     PctMin;
+  DATAF     PctMax;
+  DATAF     SiMin;
+  DATAF     SiMax;
+
+  DATA8     PctInt;                             // Percent in integer
+  DATA8     SiInt;                              // SI in integer
+  DATA32    RawMinInt;
+  DATA32    RawSpan;                            // RawMax - RawMin
+  DATA32    PctMinInt;
+  DATA32    PctSpan;                            // PctMax - PctMin
+  ULONG     PctRecip;                           // (2^32 - 1) / |RawSpan|
+  int64_t   SiScale;                            // Si = ((Raw - RawMin) * SiScale + SiOffset) * SiUnit
+  int64_t   SiOffset;
+  DATAF     SiUnit;                             // 2^-shift of SiScale and SiOffset
+}
+SCALE;
+
+void      cScaleSetup(SCALE *pScale,DATAF RawMin,DATAF RawMax,DATAF PctMin,DATAF PctMax,DATAF SiMin,DATAF SiMax);
+
+DATA8     cScalePct(SCALE *pScale,DATAF Raw);
+
+DATAF     cScaleSi(SCALE *pScale,DATAF Raw);
+
+#endif /* C_SCALE_H_ */
@@ -0,0 +1,862 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ *  Archive pack/unpack
+ *
+ *  Archives are gzip compressed ustar files - the same as "tar -cz" and
+ *  "tar -xz" - but they are made and read in a worker thread instead of a
+ *  shell so the VM keeps running. The byte code that starts a job is
+ *  repeated (BUSYBREAK) until the job is done so the calling program sees
+ *  the same result as before.
+ *
+ *  Only folders and regular files are packed. When unpacking, members with
+ *  absolute paths are made relative and members with ".." in the path are
+ *  skipped. GNU long names are understood, other extended headers are
+ *  skipped.
+ */
+
+
+#include  "lms2012.h"
+#include  "c_memory.h"
+#include  "c_archive.h"
+
+#include  <dirent.h>
+#include  <errno.h>
+#include  <fcntl.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <unistd.h>
+#include  <sys/stat.h>
+#include  <zlib.h>
+
+
+static void cArchiveOctal(char *pField,int Digits,ULONG Value)
+{
+  pField[Digits]  =  0;
+  while (Digits--)
+  {
+    pField[Digits]  =  (char)('0' + (Value & 7));
+    Value >>=  3;
+  }
+}
+
+
+static ULONG cArchiveGetOctal(char *pField,int Length)
+{
+  ULONG   Value = 0;
+
+  while ((Length > 0) && ((*pField == ' ') || (*pField == 0)))
+  {
+    pField++;
+    Length--;
+  }
+  while ((Length > 0) && (*pField >= '0') && (*pField <= '7'))
+  {
+    Value  =  (Value << 3) + (ULONG)(*pField - '0');
+    pField++;
+    Length--;
+  }
+
+  return (Value);
+}
+
+
+static ULONG cArchiveChecksum(UBYTE *pHeader)
+{
+  ULONG   Sum = 0;
+  int     Byte;
+
+  for (Byte = 0;Byte < ARCHIVE_BLOCK_SIZE;Byte++)
+  {
+    if ((Byte >= 148) && (Byte < 156))
+    { // Checksum field counts as spaces
+
+      Sum +=  (ULONG)' ';
+    }
+    else
+    {
+      Sum +=  (ULONG)pHeader[Byte];
+    }
+  }
+
+  return (Sum);
+}
+
+
+static void cArchiveProgress(ARCHIVE *pArchive,DATA32 Bytes)
+{
+  __atomic_add_fetch(&(*pArchive).Done,Bytes,__ATOMIC_RELAXED);
+}
+
+
+static RESULT cArchiveWriteZero(gzFile File,int Bytes)
+{
+  UBYTE   Zero[ARCHIVE_BLOCK_SIZE];
+  RESULT  Result = OK;
+  int     Chunk;
+
+  memset(Zero,0,sizeof(Zero));
+  while ((Bytes > 0) && (Result == OK))
+  {
+    Chunk  =  (Bytes > ARCHIVE_BLOCK_SIZE) ? ARCHIVE_BLOCK_SIZE : Bytes;
+    if (gzwrite(File,Zero,(unsigned)Chunk) != Chunk)
+    {
+      Result  =  FAIL;
+    }
+    Bytes -=  Chunk;
+  }
+
+  return (Result);
+}
+
+
+static RESULT cArchiveWriteHeader(gzFile File,char *pName,struct stat *pStatus,char Type,ULONG Size)
+{
+  RESULT  Result = FAIL;
+  UBYTE   Header[ARCHIVE_BLOCK_SIZE];
+  size_t  Length;
+  size_t  Split;
+
+  memset(Header,0,sizeof(Header));
+  Length  =  strlen(pName);
+
+  if (Length <= 100)
+  {
+    memcpy(&Header[0],pName,Length);
+    Result  =  OK;
+  }
+  else
+  { // Split at a "/" into prefix (155) and name (100)
+
+    Split  =  Length - 100;
+    while ((Split < Length) && (Split <= 155) && (pName[Split] != '/'))
+    {
+      Split++;
+    }
+    if ((Split <= 155) && (Split < Length) && (pName[Split] == '/'))
+    {
+      memcpy(&Header[345],pName,Split);
+      memcpy(&Header[0],&pName[Split + 1],Length - Split - 1);
+      Result  =  OK;
+    }
+  }
+  if (Result == OK)
+  {
+    cArchiveOctal((char*)&Header[100],7,(ULONG)((*pStatus).st_mode & 07777));
+    cArchiveOctal((char*)&Header[108],7,0);
+    cArchiveOctal((char*)&Header[116],7,0);
+    cArchiveOctal((char*)&Header[124],11,Size);
+    cArchiveOctal((char*)&Header[136],11,(ULONG)(*pStatus).st_mtime);
+    Header[156]  =  (UBYTE)Type;
+    memcpy(&Header[257],"ustar",6);
+    memcpy(&Header[263],"00",2);
+    cArchiveOctal((char*)&Header[148],6,cArchiveChecksum(Header));
+    Header[155]  =  ' ';
+
+    if (gzwrite(File,Header,ARCHIVE_BLOCK_SIZE) != ARCHIVE_BLOCK_SIZE)
+    {
+      Result  =  FAIL;
+    }
+  }
+#ifdef DEBUG
+  if (Result != OK)
+  {
+    printf("Archive %s not packed\r\n",pName);
+  }
+#endif
+
+  return (Result);
+}
+
+
+static DATA32 cArchiveCount(char *pPath)
+{
+  DATA32  Bytes = 0;
+  struct  stat Status;
+  struct  dirent **NameList;
+  char    Path[vmFILENAMESIZE];
+  int     Items;
+  int     Item;
+
+  if (lstat(pPath,&Status) == 0)
+  {
+    if (S_ISREG(Status.st_mode))
+    {
+      Bytes  =  (DATA32)Status.st_size;
+    }
+    if (S_ISDIR(Status.st_mode))
+    {
+      Items  =  scandir(pPath,&NameList,0,alphasort);
+      if (Items >= 0)
+      {
+        for (Item = 0;Item < Items;Item++)
+        {
+          if ((strcmp((*NameList[Item]).d_name,".") != 0) && (strcmp((*NameList[Item]).d_name,"..") != 0))
+          {
+            if (snprintf(Path,vmFILENAMESIZE,"%s/%s",pPath,(*NameList[Item]).d_name) < vmFILENAMESIZE)
+            {
+              Bytes +=  cArchiveCount(Path);
+            }
+          }
+          free(NameList[Item]);
+        }
+        free(NameList);
+      }
+    }
+  }
+
+  return (Bytes);
+}
+
+
+static RESULT cArchiveAdd(ARCHIVE *pArchive,gzFile File,char *pName)
+{
+  RESULT  Result = FAIL;
+  struct  stat Status;
+  struct  dirent **NameList;
+  char    Path[vmFILENAMESIZE];
+  char    Name[vmFILENAMESIZE];
+  UBYTE   Buffer[ARCHIVE_BUFFER_SIZE];
+  ULONG   Size;
+  ssize_t Bytes;
+  int     hFile;
+  int     Items;
+  int     Item;
+
+  if ((snprintf(Path,vmFILENAMESIZE,"%s%s",(*pArchive).Folder,pName) < vmFILENAMESIZE) && (lstat(Path,&Status) == 0))
+  {
+    if (S_ISDIR(Status.st_mode))
+    {
+      snprintf(Name,vmFILENAMESIZE,"%s/",pName);
+      Result  =  cArchiveWriteHeader(File,Name,&Status,'5',0);
+
+      Items  =  scandir(Path,&NameList,0,alphasort);
+      if (Items >= 0)
+      {
+        for (Item = 0;Item < Items;Item++)
+        {
+          if ((Result == OK) && (strcmp((*NameList[Item]).d_name,".") != 0) && (strcmp((*NameList[Item]).d_name,"..") != 0))
+          {
+            if (snprintf(Name,vmFILENAMESIZE,"%s/%s",pName,(*NameList[Item]).d_name) < vmFILENAMESIZE)
+            {
+              Result  =  cArchiveAdd(pArchive,File,Name);
+            }
+            else
+            {
+              Result  =  FAIL;
+            }
+          }
+          free(NameList[Item]);
+        }
+        free(NameList);
+      }
+    }
+    else
+    {
+      if (S_ISREG(Status.st_mode))
+      {
+        hFile  =  open(Path,O_RDONLY);
+        if (hFile >= MIN_HANDLE)
+        {
+          Size    =  (ULONG)Status.st_size;
+          Result  =  cArchiveWriteHeader(File,pName,&Status,'0',Size);
+
+          while ((Result == OK) && (Size > 0))
+          {
+            Bytes  =  read(hFile,Buffer,(Size > sizeof(Buffer)) ? sizeof(Buffer) : (size_t)Size);
+            if ((Bytes > 0) && (gzwrite(File,Buffer,(unsigned)Bytes) == (int)Bytes))
+            {
+              Size -=  (ULONG)Bytes;
+              cArchiveProgress(pArchive,(DATA32)Bytes);
+            }
+            else
+            {
+              if ((Bytes < 0) && (errno == EINTR))
+              {
+                continue;
+              }
+              Result  =  FAIL;
+            }
+          }
+          if ((Result == OK) && (Status.st_size % ARCHIVE_BLOCK_SIZE))
+          {
+            Result  =  cArchiveWriteZero(File,ARCHIVE_BLOCK_SIZE - (int)(Status.st_size % ARCHIVE_BLOCK_SIZE));
+          }
+          close(hFile);
+        }
+      }
+      else
+      { // Links and devices are not packed
+
+        Result  =  OK;
+      }
+    }
+  }
+
+  return (Result);
+}
+
+
+static RESULT cArchivePack(ARCHIVE *pArchive)
+{
+  RESULT  Result = FAIL;
+  char    Path[vmFILENAMESIZE];
+  gzFile  File;
+  z_off_t Written;
+  int     hFile;
+
+  if (snprintf(Path,vmFILENAMESIZE,"%s%s",(*pArchive).Folder,(*pArchive).Name) < vmFILENAMESIZE)
+  {
+    __atomic_store_n(&(*pArchive).Total,cArchiveCount(Path),__ATOMIC_RELAXED);
+  }
+
+  File  =  gzopen((*pArchive).Archive,"wb");
+  if (File != NULL)
+  {
+    gzbuffer(File,ARCHIVE_BUFFER_SIZE * 4);
+    Result  =  cArchiveAdd(pArchive,File,(*pArchive).Name);
+
+    if (Result == OK)
+    { // End of archive is two zero blocks - pad to full record like tar
+
+      Written  =  gztell(File) + 2 * ARCHIVE_BLOCK_SIZE;
+      Result   =  cArchiveWriteZero(File,2 * ARCHIVE_BLOCK_SIZE + (int)((ARCHIVE_RECORD_SIZE - (Written % ARCHIVE_RECORD_SIZE)) % ARCHIVE_RECORD_SIZE));
+    }
+    if (gzclose(File) != Z_OK)
+    {
+      Result  =  FAIL;
+    }
+    if (Result == OK)
+    {
+      hFile  =  open((*pArchive).Archive,O_RDONLY);
+      if (hFile >= MIN_HANDLE)
+      {
+        fsync(hFile);
+        close(hFile);
+      }
+    }
+    else
+    {
+      remove((*pArchive).Archive);
+    }
+  }
+
+  return (Result);
+}
+
+
+static RESULT cArchiveRead(gzFile File,void *pBuffer,ULONG Bytes)
+{
+  RESULT  Result = FAIL;
+
+  if (gzread(File,pBuffer,(unsigned)Bytes) == (int)Bytes)
+  {
+    Result  =  OK;
+  }
+
+  return (Result);
+}
+
+
+static RESULT cArchiveSkip(gzFile File,ULONG Bytes)
+{
+  RESULT  Result = OK;
+  UBYTE   Buffer[ARCHIVE_BLOCK_SIZE];
+
+  Bytes  =  (Bytes + (ARCHIVE_BLOCK_SIZE - 1)) & ~(ARCHIVE_BLOCK_SIZE - 1);
+  while ((Bytes > 0) && (Result == OK))
+  {
+    Result  =  cArchiveRead(File,Buffer,ARCHIVE_BLOCK_SIZE);
+    Bytes  -=  ARCHIVE_BLOCK_SIZE;
+  }
+
+  return (Result);
+}
+
+
+static RESULT cArchiveReadName(ARCHIVE *pArchive,gzFile File,ULONG Size)
+{
+  RESULT  Result = OK;
+  UBYTE   Buffer[ARCHIVE_BLOCK_SIZE];
+  ULONG   Offset = 0;
+  ULONG   Left;
+  ULONG   Bytes;
+
+  memset((*pArchive).LongName,0,sizeof((*pArchive).LongName));
+  Left  =  (Size + (ARCHIVE_BLOCK_SIZE - 1)) & ~(ARCHIVE_BLOCK_SIZE - 1);
+  while ((Left > 0) && (Result == OK))
+  {
+    Result  =  cArchiveRead(File,Buffer,ARCHIVE_BLOCK_SIZE);
+    Bytes   =  (Size - Offset > ARCHIVE_BLOCK_SIZE) ? ARCHIVE_BLOCK_SIZE : Size - Offset;
+    if ((Result == OK) && (Offset + Bytes < sizeof((*pArchive).LongName)))
+    {
+      memcpy(&(*pArchive).LongName[Offset],Buffer,Bytes);
+    }
+    Offset +=  Bytes;
+    Left   -=  ARCHIVE_BLOCK_SIZE;
+  }
+  if (Size >= sizeof((*pArchive).LongName))
+  { // Too long - make next member fail the name check
+
+    snprintf((*pArchive).LongName,sizeof((*pArchive).LongName),"..");
+  }
+
+  return (Result);
+}
+
+
+static RESULT cArchiveMakeName(ARCHIVE *pArchive,UBYTE *pHeader,char *pPath)
+{
+  RESULT  Result = FAIL;
+  char    Name[ARCHIVE_BLOCK_SIZE];                   // Prefix, "/", name and zero fit
+  char    *pName;
+  char    *pPart;
+
+  if ((*pArchive).LongName[0])
+  {
+    snprintf(Name,sizeof(Name),"%s",(*pArchive).LongName);
+    (*pArchive).LongName[0]  =  0;
+  }
+  else
+  {
+    if ((memcmp(&pHeader[257],"ustar",5) == 0) && (pHeader[345]))
+    {
+      snprintf(Name,sizeof(Name),"%.155s/%.100s",(char*)&pHeader[345],(char*)&pHeader[0]);
+    }
+    else
+    {
+      snprintf(Name,sizeof(Name),"%.100s",(char*)&pHeader[0]);
+    }
+  }
+
+  // Make relative and refuse to leave the folder
+  pName  =  Name;
+  while ((*pName == '/') || ((pName[0] == '.') && (pName[1] == '/')))
+  {
+    pName +=  (*pName == '/') ? 1 : 2;
+  }
+  pPart  =  pName;
+  Result =  (*pName) ? OK : FAIL;
+  while ((pPart != NULL) && (Result == OK))
+  {
+    if ((pPart[0] == '.') && (pPart[1] == '.') && ((pPart[2] == '/') || (pPart[2] == 0)))
+    {
+      Result  =  FAIL;
+    }
+    pPart  =  strchr(pPart,'/');
+    if (pPart != NULL)
+    {
+      pPart++;
+    }
+  }
+  if (Result == OK)
+  {
+    if (snprintf(pPath,vmFILENAMESIZE,"%s%s",(*pArchive).Folder,pName) >= vmFILENAMESIZE)
+    {
+      Result  =  FAIL;
+    }
+  }
+#ifdef DEBUG
+  if (Result != OK)
+  {
+    printf("Archive member %s skipped\r\n",Name);
+  }
+#endif
+
+  return (Result);
+}
+
+
+static void cArchiveMakeFolders(ARCHIVE *pArchive,char *pPath)
+{
+  char    Folder[vmFILENAMESIZE];
+  size_t  Start;
+  size_t  Char;
+
+  Start  =  strlen((*pArchive).Folder);
+  for (Char = Start;pPath[Char];Char++)
+  {
+    if ((pPath[Char] == '/') && (pPath[Char + 1]))
+    {
+      snprintf(Folder,vmFILENAMESIZE,"%.*s",(int)Char,pPath);
+      if (mkdir(Folder,DIRPERMISSIONS) == 0)
+      {
+        chmod(Folder,DIRPERMISSIONS);
+      }
+    }
+  }
+}
+
+
+static RESULT cArchiveWrite(int hFile,UBYTE *pBuffer,ULONG Bytes)
+{
+  RESULT  Result = OK;
+  ssize_t Written;
+
+  while ((Bytes > 0) && (Result == OK))
+  {
+    Written  =  write(hFile,pBuffer,(size_t)Bytes);
+    if (Written > 0)
+    {
+      pBuffer +=  Written;
+      Bytes   -=  (ULONG)Written;
+    }
+    else
+    {
+      if ((Written < 0) && (errno == EINTR))
+      {
+        continue;
+      }
+      Result  =  FAIL;
+    }
+  }
+
+  return (Result);
+}
+
+
+static int cArchiveCreate(char *pPath)
+{
+  int     hFile;
+
+  // Never write through a link left where the member goes - replace it
+  hFile  =  open(pPath,O_CREAT | O_EXCL | O_WRONLY | O_NOFOLLOW,FILEPERMISSIONS);
+  if ((hFile < MIN_HANDLE) && (errno == EEXIST) && (unlink(pPath) == 0))
+  {
+    hFile  =  open(pPath,O_CREAT | O_EXCL | O_WRONLY | O_NOFOLLOW,FILEPERMISSIONS);
+  }
+
+  return (hFile);
+}
+
+
+static RESULT cArchiveExtract(ARCHIVE *pArchive,gzFile File,char *pPath,ULONG Size,time_t Time)
+{
+  RESULT  Result = OK;
+  UBYTE   Buffer[ARCHIVE_BUFFER_SIZE];
+  struct  timespec Times[2];
+  ULONG   Bytes;
+  ULONG   Left;
+  int     hFile;
+
+  cArchiveMakeFolders(pArchive,pPath);
+  hFile  =  cArchiveCreate(pPath);
+
+  Left  =  (Size + (ARCHIVE_BLOCK_SIZE - 1)) & ~(ARCHIVE_BLOCK_SIZE - 1);
+  while ((Left > 0) && (Result == OK))
+  {
+    Bytes   =  (Left > sizeof(Buffer)) ? sizeof(Buffer) : Left;
+    Result  =  cArchiveRead(File,Buffer,Bytes);
+    if ((Result == OK) && (hFile >= MIN_HANDLE) && (Size > 0))
+    {
+      Result  =  cArchiveWrite(hFile,Buffer,(Size > Bytes) ? Bytes : Size);
+      Size -=  (Size > Bytes) ? Bytes : Size;
+    }
+    Left -=  Bytes;
+  }
+  if (hFile >= MIN_HANDLE)
+  {
+    Times[0].tv_sec   =  Time;
+    Times[0].tv_nsec  =  0;
+    Times[1]          =  Times[0];
+    futimens(hFile,Times);
+    fsync(hFile);
+    close(hFile);
+    chmod(pPath,FILEPERMISSIONS);
+  }
+  else
+  {
+#ifdef DEBUG
+    printf("Archive %s not created\r\n",pPath);
+#endif
+    Result  =  FAIL;
+  }
+
+  return (Result);
+}
+
+
+static RESULT cArchiveUnpack(ARCHIVE *pArchive)
+{
+  RESULT  Result = FAIL;
+  UBYTE   Header[ARCHIVE_BLOCK_SIZE];
+  char    Path[vmFILENAMESIZE];
+  struct  stat Status;
+  gzFile  File;
+  ULONG   Size;
+  ULONG   Sum;
+  int     Byte;
+
+  if (stat((*pArchive).Archive,&Status) == 0)
+  {
+    __atomic_store_n(&(*pArchive).Total,(DATA32)Status.st_size,__ATOMIC_RELAXED);
+  }
+  (*pArchive).LongName[0]  =  0;
+
+  File  =  gzopen((*pArchive).Archive,"rb");
+  if (File != NULL)
+  {
+    gzbuffer(File,ARCHIVE_BUFFER_SIZE * 4);
+
+    while (cArchiveRead(File,Header,ARCHIVE_BLOCK_SIZE) == OK)
+    {
+      Sum  =  0;
+      for (Byte = 0;Byte < ARCHIVE_BLOCK_SIZE;Byte++)
+      {
+        Sum |=  Header[Byte];
+      }
+      if (Sum == 0)
+      { // End of archive
+
+        Result  =  OK;
+        break;
+      }
+      if (cArchiveGetOctal((char*)&Header[148],8) != cArchiveChecksum(Header))
+      {
+        break;
+      }
+      Size  =  cArchiveGetOctal((char*)&Header[124],12);
+
+      if (Header[156] == 'L')
+      { // GNU long name of next member
+
+        if (cArchiveReadName(pArchive,File,Size) != OK)
+        {
+          break;
+        }
+      }
+      else
+      {
+        if ((Header[156] == '5') && (cArchiveMakeName(pArchive,Header,Path) == OK))
+        { // Folder
+
+          cArchiveMakeFolders(pArchive,Path);
+          if (mkdir(Path,DIRPERMISSIONS) == 0)
+          {
+            chmod(Path,DIRPERMISSIONS);
+          }
+          if (cArchiveSkip(File,Size) != OK)
+          {
+            break;
+          }
+        }
+        else
+        {
+          if (((Header[156] == '0') || (Header[156] == 0) || (Header[156] == '7')) && (cArchiveMakeName(pArchive,Header,Path) == OK))
+          { // Regular file
+
+            if (cArchiveExtract(pArchive,File,Path,Size,(time_t)cArchiveGetOctal((char*)&Header[136],12)) != OK)
+            {
+              break;
+            }
+          }
+          else
+          { // Links, devices and extended headers are skipped
+
+            if (cArchiveSkip(File,Size) != OK)
+            {
+              break;
+            }
+          }
+        }
+      }
+      __atomic_store_n(&(*pArchive).Done,(DATA32)gzoffset(File),__ATOMIC_RELAXED);
+    }
+    gzclose(File);
+  }
+
+  return (Result);
+}
+
+
+static void cArchiveJob(ARCHIVE *pArchive)
+{
+  if ((*pArchive).Mode == ARCHIVE_PACK)
+  {
+    (*pArchive).Result  =  cArchivePack(pArchive);
+  }
+  else
+  {
+    (*pArchive).Result  =  cArchiveUnpack(pArchive);
+  }
+#ifdef DEBUG
+  printf("Archive %s %s\r\n",(*pArchive).Archive,((*pArchive).Result == OK) ? "done" : "failed");
+#endif
+  __atomic_store_n(&(*pArchive).State,ARCHIVE_DONE,__ATOMIC_RELEASE);
+}
+
+
+static void* cArchiveThread(void *pArg)
+{
+  cArchiveJob((ARCHIVE*)pArg);
+
+  return (NULL);
+}
+
+
+static void cArchiveCollect(ARCHIVE *pArchive)
+{
+  if ((*pArchive).Threaded)
+  {
+    pthread_join((*pArchive).Thread,NULL);
+    (*pArchive).Threaded  =  0;
+  }
+  __atomic_store_n(&(*pArchive).State,ARCHIVE_IDLE,__ATOMIC_RELAXED);
+}
+
+
+void      cArchiveInit(void)
+{
+  MemoryInstance.Archive.State     =  ARCHIVE_IDLE;
+  MemoryInstance.Archive.Owned     =  0;
+  MemoryInstance.Archive.Threaded  =  0;
+  MemoryInstance.Archive.Total     =  0;
+  MemoryInstance.Archive.Done      =  0;
+}
+
+
+/*! \brief    Start or poll pack/unpack job
+ *
+ *  Returns BUSYBREAK until the job started by the caller is done, then
+ *  NOBREAK or FAILBREAK from the result of the job. Only one job runs at a
+ *  time - other callers wait until the owner has collected it or the owner
+ *  has been stopped (cArchiveClose).
+ */
+DSPSTAT   cArchiveRun(PRGID PrgId,OBJID ObjId,DATA8 Mode,char *pArchive,char *pFolder,char *pName)
+{
+  DSPSTAT DspStat = BUSYBREAK;
+  ARCHIVE *pJob;
+  DATA8   State;
+
+  pJob   =  &MemoryInstance.Archive;
+  State  =  __atomic_load_n(&(*pJob).State,__ATOMIC_ACQUIRE);
+
+  if (State == ARCHIVE_DONE)
+  {
+    if (((*pJob).Owned) && ((*pJob).PrgId == PrgId) && ((*pJob).ObjId == ObjId) && ((*pJob).Mode == Mode) && (strcmp((*pJob).Archive,pArchive) == 0))
+    { // Own job is done
+
+      cArchiveCollect(pJob);
+      DspStat  =  NOBREAK;
+      if ((*pJob).Result != OK)
+      {
+        LogErrorNumber(((*pJob).Mode == ARCHIVE_PACK) ? FILE_WRITE_ERROR : FILE_READ_ERROR);
+        DspStat  =  FAILBREAK;
+      }
+    }
+    else
+    {
+      if (!(*pJob).Owned)
+      { // Owner has been stopped - nobody will collect it
+
+        cArchiveCollect(pJob);
+      }
+    }
+  }
+  else
+  {
+    if (State == ARCHIVE_IDLE)
+    {
+      (*pJob).Mode   =  Mode;
+      (*pJob).Owned  =  1;
+      (*pJob).PrgId  =  PrgId;
+      (*pJob).ObjId  =  ObjId;
+      (*pJob).Total  =  0;
+      (*pJob).Done   =  0;
+      snprintf((*pJob).Archive,vmFILENAMESIZE,"%s",pArchive);
+      snprintf((*pJob).Folder,vmFILENAMESIZE,"%s",(pFolder[0]) ? pFolder : "./");
+      snprintf((*pJob).Name,vmFILENAMESIZE,"%s",pName);
+
+      __atomic_store_n(&(*pJob).State,ARCHIVE_RUNNING,__ATOMIC_RELEASE);
+      if (pthread_create(&(*pJob).Thread,NULL,cArchiveThread,pJob) == 0)
+      {
+        (*pJob).Threaded  =  1;
+      }
+      else
+      { // No thread - do it now
+
+        cArchiveJob(pJob);
+      }
+    }
+  }
+
+  return (DspStat);
+}
+
+
+/*! \brief    Release job of program that is stopped
+ *
+ *  A job that is still running is left to finish - the next caller
+ *  collects it.
+ */
+void      cArchiveClose(PRGID PrgId)
+{
+  ARCHIVE *pJob;
+
+  pJob  =  &MemoryInstance.Archive;
+  if ((__atomic_load_n(&(*pJob).State,__ATOMIC_ACQUIRE) != ARCHIVE_IDLE) && ((*pJob).Owned) && ((*pJob).PrgId == PrgId))
+  {
+    (*pJob).Owned  =  0;
+    if (__atomic_load_n(&(*pJob).State,__ATOMIC_ACQUIRE) == ARCHIVE_DONE)
+    {
+      cArchiveCollect(pJob);
+    }
+  }
+}
+
+
+void      cArchiveGetStatus(DATA8 *pBusy,DATA8 *pProgress)
+{
+  DATA32  Total;
+  DATA32  Done;
+
+  *pBusy      =  0;
+  *pProgress  =  0;
+  if (__atomic_load_n(&MemoryInstance.Archive.State,__ATOMIC_ACQUIRE) != ARCHIVE_IDLE)
+  {
+    Total  =  __atomic_load_n(&MemoryInstance.Archive.Total,__ATOMIC_RELAXED);
+    Done   =  __atomic_load_n(&MemoryInstance.Archive.Done,__ATOMIC_RELAXED);
+
+    *pBusy  =  1;
+    if (__atomic_load_n(&MemoryInstance.Archive.State,__ATOMIC_ACQUIRE) == ARCHIVE_DONE)
+    {
+      *pProgress  =  100;
+    }
+    else
+    {
+      if ((Total > 0) && (Done < Total))
+      {
+        *pProgress  =  (DATA8)(((DATAF)Done * (DATAF)100) / (DATAF)Total);
+      }
+    }
+  }
+}
+
+
+void      cArchiveExit(void)
+{
+  if (MemoryInstance.Archive.Threaded)
+  {
+    pthread_join(MemoryInstance.Archive.Thread,NULL);
+    MemoryInstance.Archive.Threaded  =  0;
+  }
+  MemoryInstance.Archive.State  =  ARCHIVE_IDLE;
+}
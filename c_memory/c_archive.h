@@ -0,0 +1,73 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef C_ARCHIVE_H_
+#define C_ARCHIVE_H_
+
+#include  "lms2012.h"
+
+#include  <pthread.h>
+
+#define   ARCHIVE_BLOCK_SIZE    512                   // tar block size
+#define   ARCHIVE_RECORD_SIZE   10240                 // tar record size (archive is padded to this)
+#define   ARCHIVE_BUFFER_SIZE   4096                  // File read/write chunk
+
+enum
+{
+  ARCHIVE_IDLE,
+  ARCHIVE_RUNNING,
+  ARCHIVE_DONE
+};
+
+enum
+{
+  ARCHIVE_PACK,
+  ARCHIVE_UNPACK
+};
+
+typedef   struct
+{
+  pthread_t Thread;
+  DATA8     State;                              // ARCHIVE_IDLE, ARCHIVE_RUNNING or ARCHIVE_DONE (atomic access only)
+  DATA8     Threaded;                           // Job runs on thread that must be joined
+  DATA8     Mode;                               // ARCHIVE_PACK or ARCHIVE_UNPACK
+  DATA8     Owned;                              // Program that started the job is still running
+  RESULT    Result;
+  PRGID     PrgId;                              // Program and object that started the job
+  OBJID     ObjId;
+  DATA32    Total;                              // Bytes to process (0 = not known yet - atomic access only)
+  DATA32    Done;                               // Bytes processed (atomic access only)
+  char      Archive[vmFILENAMESIZE];            // "../prjs/name.raf"
+  char      Folder[vmFILENAMESIZE];             // "../prjs/" - archive members are relative to this
+  char      Name[vmFILENAMESIZE];               // "name" - file or folder to pack
+  char      LongName[vmFILENAMESIZE];           // GNU long name for next member when unpacking
+}
+ARCHIVE;
+
+void      cArchiveInit(void);
+
+DSPSTAT   cArchiveRun(PRGID PrgId,OBJID ObjId,DATA8 Mode,char *pArchive,char *pFolder,char *pName);
+
+void      cArchiveClose(PRGID PrgId);
+
+void      cArchiveGetStatus(DATA8 *pBusy,DATA8 *pProgress);
+
+void      cArchiveExit(void);
+
+#endif /* C_ARCHIVE_H_ */
@@ -0,0 +1,716 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ *  Data log writer
+ *
+ *  Samples logged to a file are not written by the VM. The VM copies the
+ *  formatted samples into one of two buffers and hands the buffer over to a
+ *  writer thread when it is full. The writer thread writes the buffer in one
+ *  go while the VM fills the other buffer.
+ *
+ *  The buffers are shared without locks: a buffer belongs to the VM until
+ *  "Full" is set and to the writer thread until "Full" is cleared again. A
+ *  semaphore wakes the writer thread once for every buffer handed over.
+ *
+ *  Buffers are handed over so that every write ends on a DATALOG_BUFFER_SIZE
+ *  boundary in the file. A partly filled buffer is handed over if the oldest
+ *  sample in it is older than DATALOG_MAX_LATENCY so slow logs are still
+ *  updated on disk while they run.
+ *
+ *  If the writer thread has not finished the other buffer when the VM needs
+ *  it the sample is dropped and counted instead of stalling the VM.
+ *
+ *  With ENABLE_LOG_COMPACT samples are delta encoded into blocks (see
+ *  c_datalog.h) and a block is handed to the buffers as one record.
+ *
+ *  In ring mode the file is preallocated to hold a fixed number of samples
+ *  after the header and the writer thread overwrites the oldest samples in
+ *  place. When the log is closed the ring is rotated in the file so that
+ *  the samples are in order and the end signature is written after them.
+ */
+
+
+#define   _GNU_SOURCE                           // fallocate()
+
+#include  "lms2012.h"
+#include  "c_memory.h"
+#include  "c_datalog.h"
+
+#include  <errno.h>
+#include  <fcntl.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <unistd.h>
+
+
+static void cDatalogWriteBuffer(DATALOG *pLog,DATA32 Position,UBYTE *pData,DATA32 Bytes)
+{
+  ssize_t No;
+  DATA32  RingBytes;
+  DATA32  Offset;
+  DATA32  Chunk;
+
+  RingBytes  =  __atomic_load_n(&(*pLog).RingBytes,__ATOMIC_ACQUIRE);
+
+  while (Bytes > 0)
+  {
+    if (RingBytes == 0)
+    {
+      No  =  write((*pLog).hFile,pData,(size_t)Bytes);
+    }
+    else
+    { // Map log position into file (wrap around at end of ring)
+
+      if (Position < (*pLog).RingStart)
+      {
+        Offset  =  Position;
+        Chunk   =  (*pLog).RingStart - Position;
+      }
+      else
+      {
+        Offset  =  (Position - (*pLog).RingStart) % RingBytes;
+        Chunk   =  RingBytes - Offset;
+        Offset +=  (*pLog).RingStart;
+      }
+      if (Chunk > Bytes)
+      {
+        Chunk  =  Bytes;
+      }
+      No  =  pwrite((*pLog).hRing,pData,(size_t)Chunk,(*pLog).Base + Offset);
+    }
+    if (No > 0)
+    {
+      pData     +=  No;
+      Bytes     -=  (DATA32)No;
+      Position  +=  (DATA32)No;
+    }
+    else
+    {
+      if ((No < 0) && (errno == EINTR))
+      {
+        continue;
+      }
+      __atomic_add_fetch(&(*pLog).WriteErrors,1,__ATOMIC_RELAXED);
+      Bytes  =  0;
+    }
+  }
+}
+
+
+static void* cDatalogThread(void *pArg)
+{
+  DATALOG *pLog = (DATALOG*)pArg;
+  DATA8   Next = 0;
+  DATA8   Run = 1;
+
+  while (Run)
+  {
+    if (sem_wait(&(*pLog).Ready) == 0)
+    {
+      if (__atomic_load_n(&(*pLog).Full[Next],__ATOMIC_ACQUIRE))
+      {
+        cDatalogWriteBuffer(pLog,(*pLog).Start[Next],(*pLog).Buffer[Next],(*pLog).Used[Next]);
+        __atomic_store_n(&(*pLog).Full[Next],0,__ATOMIC_RELEASE);
+        Next ^=  1;
+      }
+      else
+      {
+        if (__atomic_load_n(&(*pLog).Stop,__ATOMIC_ACQUIRE))
+        {
+          Run  =  0;
+        }
+      }
+    }
+  }
+
+  return (NULL);
+}
+
+
+static RESULT cDatalogHandOver(DATALOG *pLog)
+{
+  RESULT  Result = FAIL;
+  DATA8   Active;
+
+  Active  =  (*pLog).Active;
+
+  if (__atomic_load_n(&(*pLog).Full[Active ^ 1],__ATOMIC_ACQUIRE) == 0)
+  {
+    if (((*pLog).RingBytes) || (cMemoryReserveSpace((*pLog).Used[Active]) == OK))
+    { // Ring is reserved when it is allocated
+
+      (*pLog).Start[Active]  =  (*pLog).Written;
+      (*pLog).Written       +=  (*pLog).Used[Active];
+
+      __atomic_store_n(&(*pLog).Full[Active],1,__ATOMIC_RELEASE);
+      sem_post(&(*pLog).Ready);
+
+      Active                =  Active ^ 1;
+      (*pLog).Active        =  Active;
+      (*pLog).Used[Active]  =  0;
+      (*pLog).Limit         =  DATALOG_BUFFER_SIZE - ((*pLog).Written % DATALOG_BUFFER_SIZE);
+
+      Result  =  OK;
+    }
+    else
+    {
+      (*pLog).Error  =  1;
+    }
+  }
+
+  return (Result);
+}
+
+
+DATALOG*  cDatalogOpen(int hFile)
+{
+  DATALOG *pLog;
+
+  pLog  =  (DATALOG*)calloc(1,sizeof(DATALOG));
+  if (pLog != NULL)
+  {
+    (*pLog).hFile  =  hFile;
+    (*pLog).hRing  =  -1;
+    (*pLog).Limit  =  DATALOG_BUFFER_SIZE;
+    (*pLog).Base   =  lseek(hFile,0,SEEK_END);
+    if ((*pLog).Base < 0)
+    {
+      (*pLog).Base  =  0;
+    }
+
+    if (sem_init(&(*pLog).Ready,0,0) == 0)
+    {
+      if (pthread_create(&(*pLog).Thread,NULL,cDatalogThread,pLog) != 0)
+      {
+        sem_destroy(&(*pLog).Ready);
+        free(pLog);
+        pLog  =  NULL;
+      }
+    }
+    else
+    {
+      free(pLog);
+      pLog  =  NULL;
+    }
+  }
+
+  return (pLog);
+}
+
+
+RESULT    cDatalogAppend(DATALOG *pLog,UBYTE *pData,DATA32 Bytes)
+{
+  RESULT  Result = FAIL;
+  DATA32  Space;
+
+  if ((!(*pLog).Error) && (Bytes <= DATALOG_BUFFER_SIZE))
+  {
+    Space  =  (*pLog).Limit - (*pLog).Used[(*pLog).Active];
+
+    if (Bytes <= Space)
+    {
+      memcpy(&(*pLog).Buffer[(*pLog).Active][(*pLog).Used[(*pLog).Active]],pData,(size_t)Bytes);
+      (*pLog).Used[(*pLog).Active]  +=  Bytes;
+      Result  =  OK;
+
+      if ((*pLog).Used[(*pLog).Active] >= (*pLog).Limit)
+      { // Full - write it if the other buffer is free (otherwise on next sample)
+
+        cDatalogHandOver(pLog);
+      }
+    }
+    else
+    {
+      if (__atomic_load_n(&(*pLog).Full[(*pLog).Active ^ 1],__ATOMIC_ACQUIRE) == 0)
+      { // Split sample over both buffers
+
+        memcpy(&(*pLog).Buffer[(*pLog).Active][(*pLog).Used[(*pLog).Active]],pData,(size_t)Space);
+        (*pLog).Used[(*pLog).Active]  +=  Space;
+
+        if (cDatalogHandOver(pLog) == OK)
+        {
+          memcpy((*pLog).Buffer[(*pLog).Active],&pData[Space],(size_t)(Bytes - Space));
+          (*pLog).Used[(*pLog).Active]  =  Bytes - Space;
+          Result  =  OK;
+        }
+      }
+    }
+  }
+
+  return (Result);
+}
+
+
+static RESULT cDatalogPut(DATALOG *pLog,DATA32 Time,UBYTE *pData,DATA32 Bytes,DATA32 Samples)
+{
+  RESULT  Result;
+  DATA8   Active;
+  DATA32  Used;
+
+  Active  =  (*pLog).Active;
+  Used    =  (*pLog).Used[Active];
+
+  Result  =  cDatalogAppend(pLog,pData,Bytes);
+  if (Result == OK)
+  {
+    (*pLog).Samples  +=  Samples;
+
+    if ((Active != (*pLog).Active) || (Used == 0))
+    {
+      (*pLog).FirstTime  =  Time;
+    }
+    if (((*pLog).Used[(*pLog).Active]) && ((Time - (*pLog).FirstTime) >= DATALOG_MAX_LATENCY))
+    {
+      cDatalogHandOver(pLog);
+    }
+  }
+  else
+  {
+    (*pLog).Dropped  +=  Samples;
+  }
+
+  return (Result);
+}
+
+
+static RESULT cDatalogStartRing(DATALOG *pLog,DATA32 Bytes)
+{
+  RESULT  Result = FAIL;
+  DATA32  RingBytes;
+
+  // Ring is laid out when the record size is known (first sample)
+
+  RingBytes  =  (*pLog).RingSamples * Bytes;
+  if ((Bytes > 0) && ((RingBytes / Bytes) == (*pLog).RingSamples))
+  {
+    if (cMemoryReserveSpace(RingBytes) == OK)
+    {
+      (*pLog).RingRecord  =  Bytes;
+      (*pLog).RingStart   =  (*pLog).Written + (*pLog).Used[(*pLog).Active];
+      // Allocate without changing the file size so the header can still be appended
+
+      fallocate((*pLog).hRing,FALLOC_FL_KEEP_SIZE,(*pLog).Base + (*pLog).RingStart,RingBytes);
+      __atomic_store_n(&(*pLog).RingBytes,RingBytes,__ATOMIC_RELEASE);
+
+      Result  =  OK;
+    }
+  }
+
+  return (Result);
+}
+
+
+RESULT    cDatalogWrite(DATALOG *pLog,DATA32 Time,UBYTE *pData,DATA32 Bytes)
+{
+  RESULT  Result = OK;
+
+  if ((*pLog).RingSamples)
+  {
+    if ((*pLog).RingBytes == 0)
+    {
+      Result  =  cDatalogStartRing(pLog,Bytes);
+      if (Result != OK)
+      { // No room for ring - go on as a normal log
+
+        (*pLog).RingSamples  =  0;
+        close((*pLog).hRing);
+        (*pLog).hRing        =  -1;
+        Result               =  OK;
+      }
+    }
+    else
+    {
+      if (Bytes != (*pLog).RingRecord)
+      { // Records must have same size to keep ring in order
+
+        Result  =  FAIL;
+        (*pLog).Dropped++;
+      }
+    }
+  }
+  if (Result == OK)
+  {
+    Result  =  cDatalogPut(pLog,Time,pData,Bytes,1);
+  }
+
+  return (Result);
+}
+
+
+RESULT    cDatalogSetRing(DATALOG *pLog,char *pFileName,DATA32 Samples)
+{
+  RESULT  Result = FAIL;
+
+#if (!defined(ENABLE_LOG_COMPACT) && !defined(ENABLE_LOG_ASCII))
+  // Only possible before the first sample and with fixed size records
+
+  if ((Samples > 0) && ((*pLog).RingSamples == 0) && ((*pLog).Samples == 0) && ((*pLog).Dropped == 0))
+  {
+    (*pLog).hRing  =  open(pFileName,O_RDWR);
+    if ((*pLog).hRing >= 0)
+    {
+      (*pLog).RingSamples  =  Samples;
+      Result               =  OK;
+    }
+  }
+#endif
+
+  return (Result);
+}
+
+
+RESULT    cDatalogEnd(DATALOG *pLog,UBYTE *pData,DATA32 Bytes)
+{
+  RESULT  Result = FAIL;
+
+  if ((*pLog).RingBytes)
+  { // Written after the ring when closed
+
+    if (Bytes <= (DATA32)sizeof((*pLog).Trailer))
+    {
+      memcpy((*pLog).Trailer,pData,(size_t)Bytes);
+      (*pLog).TrailerBytes  =  Bytes;
+      Result                =  OK;
+    }
+  }
+  else
+  {
+    Result  =  cDatalogAppend(pLog,pData,Bytes);
+  }
+
+  return (Result);
+}
+
+
+static void cDatalogReverse(DATALOG *pLog,off_t Start,off_t End)
+{
+  UBYTE   *pFirst;
+  UBYTE   *pLast;
+  UBYTE   Tmp;
+  size_t  Chunk;
+  size_t  Byte;
+
+  // Reverse bytes in file from Start to End using the (now unused) buffers
+
+  pFirst  =  (*pLog).Buffer[0];
+  pLast   =  (*pLog).Buffer[1];
+
+  while ((End - Start) >= 2)
+  {
+    Chunk  =  (size_t)((End - Start) / 2);
+    if (Chunk > DATALOG_BUFFER_SIZE)
+    {
+      Chunk  =  DATALOG_BUFFER_SIZE;
+    }
+    if ((pread((*pLog).hRing,pFirst,Chunk,Start) != (ssize_t)Chunk) || (pread((*pLog).hRing,pLast,Chunk,End - (off_t)Chunk) != (ssize_t)Chunk))
+    {
+      (*pLog).WriteErrors++;
+      break;
+    }
+    for (Byte = 0;Byte < (Chunk / 2);Byte++)
+    {
+      Tmp                        =  pFirst[Byte];
+      pFirst[Byte]               =  pFirst[Chunk - 1 - Byte];
+      pFirst[Chunk - 1 - Byte]   =  Tmp;
+      Tmp                        =  pLast[Byte];
+      pLast[Byte]                =  pLast[Chunk - 1 - Byte];
+      pLast[Chunk - 1 - Byte]    =  Tmp;
+    }
+    if ((pwrite((*pLog).hRing,pLast,Chunk,Start) != (ssize_t)Chunk) || (pwrite((*pLog).hRing,pFirst,Chunk,End - (off_t)Chunk) != (ssize_t)Chunk))
+    {
+      (*pLog).WriteErrors++;
+      break;
+    }
+    Start  +=  (off_t)Chunk;
+    End    -=  (off_t)Chunk;
+  }
+}
+
+
+static void cDatalogCloseRing(DATALOG *pLog)
+{
+  off_t   Start;
+  off_t   End;
+  DATA32  Used;
+  DATA32  Oldest;
+
+  Start  =  (*pLog).Base + (*pLog).RingStart;
+  Used   =  (*pLog).Written - (*pLog).RingStart;
+
+  if (Used > (*pLog).RingBytes)
+  { // Wrapped - rotate oldest sample to start of ring (three reversals)
+
+    Oldest  =  Used % (*pLog).RingBytes;
+    End     =  Start + (*pLog).RingBytes;
+    if (Oldest)
+    {
+      cDatalogReverse(pLog,Start,Start + Oldest);
+      cDatalogReverse(pLog,Start + Oldest,End);
+      cDatalogReverse(pLog,Start,End);
+    }
+  }
+  else
+  {
+    End     =  Start + Used;
+  }
+
+  if ((*pLog).TrailerBytes)
+  {
+    if (pwrite((*pLog).hRing,(*pLog).Trailer,(size_t)(*pLog).TrailerBytes,End) != (ssize_t)(*pLog).TrailerBytes)
+    {
+      (*pLog).WriteErrors++;
+    }
+    End  +=  (off_t)(*pLog).TrailerBytes;
+  }
+  if (ftruncate((*pLog).hRing,End) != 0)
+  {
+    (*pLog).WriteErrors++;
+  }
+}
+
+
+#ifdef ENABLE_LOG_COMPACT
+
+static UBYTE* cDatalogPutLong(UBYTE *pOut,ULONG Value)
+{
+  pOut[0]  =  (UBYTE)Value;
+  pOut[1]  =  (UBYTE)(Value >> 8);
+  pOut[2]  =  (UBYTE)(Value >> 16);
+  pOut[3]  =  (UBYTE)(Value >> 24);
+
+  return (&pOut[4]);
+}
+
+
+static UBYTE* cDatalogPutDelta(UBYTE *pOut,ULONG Value,ULONG Previous)
+{
+  SLONG   Delta;
+  ULONG   Zigzag;
+
+  Delta   =  (SLONG)(Value - Previous);
+  Zigzag  =  ((ULONG)Delta << 1) ^ (ULONG)(Delta >> 31);
+
+  while (Zigzag >= 0x80)
+  {
+    *pOut++   =  (UBYTE)(Zigzag | 0x80);
+    Zigzag  >>=  7;
+  }
+  *pOut++     =  (UBYTE)Zigzag;
+
+  return (pOut);
+}
+
+
+static void cDatalogEndBlock(DATALOG *pLog,DATA32 Time)
+{
+  UBYTE   *pBlock;
+  ULONG   Offset;
+  ULONG   *pTmp;
+
+  if ((*pLog).BlockRecords)
+  {
+    pBlock     =  (*pLog).Block;
+    pBlock     =  cDatalogPutLong(pBlock,DATALOG_BLOCK_MAGIC);
+    pBlock[0]  =  (UBYTE)(*pLog).BlockUsed;
+    pBlock[1]  =  (UBYTE)((*pLog).BlockUsed >> 8);
+    pBlock[2]  =  (UBYTE)(*pLog).BlockRecords;
+    pBlock[3]  =  (UBYTE)((*pLog).BlockRecords >> 8);
+    pBlock[4]  =  (UBYTE)(*pLog).BlockItems;
+
+    // Offset in file = file size when opened + bytes handed over + bytes in active buffer
+
+    Offset     =  (ULONG)((*pLog).Base + (*pLog).Written + (*pLog).Used[(*pLog).Active]);
+
+    if (cDatalogPut(pLog,Time,(*pLog).Block,DATALOG_BLOCK_HEADER + (*pLog).BlockUsed,(DATA32)(*pLog).BlockRecords) == OK)
+    {
+      if ((*pLog).IndexEntries >= (*pLog).IndexSize)
+      {
+        pTmp  =  (ULONG*)realloc((*pLog).pIndex,(size_t)((*pLog).IndexSize + DATALOG_INDEX_STEP) * 2 * sizeof(ULONG));
+        if (pTmp != NULL)
+        {
+          (*pLog).pIndex      =  pTmp;
+          (*pLog).IndexSize  +=  DATALOG_INDEX_STEP;
+        }
+        else
+        {
+          (*pLog).IndexError  =  1;
+        }
+      }
+      if ((*pLog).IndexEntries < (*pLog).IndexSize)
+      {
+        (*pLog).pIndex[(*pLog).IndexEntries * 2]      =  Offset;
+        (*pLog).pIndex[(*pLog).IndexEntries * 2 + 1]  =  (ULONG)(*pLog).BlockTime;
+        (*pLog).IndexEntries++;
+      }
+    }
+    else
+    { // Block lost - index would not match the blocks anyway
+
+      (*pLog).IndexError  =  1;
+    }
+    (*pLog).BlockRecords  =  0;
+    (*pLog).BlockUsed     =  0;
+  }
+}
+
+
+RESULT    cDatalogWriteCompact(DATALOG *pLog,DATA32 Time,DATA8 Items,DATAF *pValues)
+{
+  RESULT  Result = FAIL;
+  UBYTE   *pPayload;
+  UBYTE   *pOut;
+  ULONG   Value;
+  DATA8   Item;
+
+  if ((Items > 0) && (Items <= DATALOG_MAX_ITEMS))
+  {
+    // A record takes at most 5 bytes per field
+
+    if ((Items != (*pLog).BlockItems) || (((*pLog).BlockUsed + ((DATA32)Items + 1) * 5) > DATALOG_BLOCK_SIZE))
+    {
+      cDatalogEndBlock(pLog,Time);
+    }
+    if ((*pLog).BlockRecords == 0)
+    {
+      (*pLog).BlockItems  =  Items;
+      (*pLog).BlockTime   =  Time;
+      memset((*pLog).Previous,0,sizeof((*pLog).Previous));
+    }
+
+    pPayload  =  &(*pLog).Block[DATALOG_BLOCK_HEADER];
+    pOut      =  &pPayload[(*pLog).BlockUsed];
+
+    pOut      =  cDatalogPutDelta(pOut,(ULONG)Time,(*pLog).Previous[0]);
+    (*pLog).Previous[0]  =  (ULONG)Time;
+
+    for (Item = 0;Item < Items;Item++)
+    {
+      memcpy(&Value,&pValues[Item],sizeof(ULONG));
+      pOut    =  cDatalogPutDelta(pOut,Value,(*pLog).Previous[Item + 1]);
+      (*pLog).Previous[Item + 1]  =  Value;
+    }
+
+    (*pLog).BlockUsed  =  (DATA32)(pOut - pPayload);
+    (*pLog).BlockRecords++;
+
+    if ((Time - (*pLog).BlockTime) >= DATALOG_MAX_LATENCY)
+    {
+      cDatalogEndBlock(pLog,Time);
+    }
+    Result  =  OK;
+  }
+  else
+  {
+    (*pLog).Dropped++;
+  }
+
+  return (Result);
+}
+
+
+RESULT    cDatalogWriteIndex(DATALOG *pLog)
+{
+  RESULT  Result = FAIL;
+  UBYTE   Buffer[DATALOG_INDEX_STEP * 2 * sizeof(ULONG)];
+  UBYTE   *pOut;
+  DATA32  Entry;
+
+  cDatalogEndBlock(pLog,(*pLog).BlockTime);
+
+  if (!(*pLog).IndexError)
+  {
+    pOut    =  cDatalogPutLong(Buffer,DATALOG_INDEX_MAGIC);
+    pOut    =  cDatalogPutLong(pOut,(ULONG)(*pLog).IndexEntries);
+    Result  =  cDatalogAppend(pLog,Buffer,(DATA32)(pOut - Buffer));
+
+    Entry   =  0;
+    while ((Result == OK) && (Entry < (*pLog).IndexEntries))
+    {
+      pOut  =  Buffer;
+      while ((Entry < (*pLog).IndexEntries) && (pOut < &Buffer[sizeof(Buffer)]))
+      {
+        pOut  =  cDatalogPutLong(pOut,(*pLog).pIndex[Entry * 2]);
+        pOut  =  cDatalogPutLong(pOut,(*pLog).pIndex[Entry * 2 + 1]);
+        Entry++;
+      }
+      Result  =  cDatalogAppend(pLog,Buffer,(DATA32)(pOut - Buffer));
+    }
+
+    if (Result == OK)
+    {
+      pOut    =  cDatalogPutLong(Buffer,(ULONG)(*pLog).IndexEntries);
+      pOut    =  cDatalogPutLong(pOut,DATALOG_INDEX_MAGIC);
+      Result  =  cDatalogAppend(pLog,Buffer,(DATA32)(pOut - Buffer));
+    }
+  }
+
+  return (Result);
+}
+
+#endif
+
+
+void      cDatalogClose(DATALOG *pLog)
+{
+  DATA8   Active;
+
+#ifdef ENABLE_LOG_COMPACT
+  cDatalogEndBlock(pLog,(*pLog).BlockTime);
+#endif
+  __atomic_store_n(&(*pLog).Stop,1,__ATOMIC_RELEASE);
+  sem_post(&(*pLog).Ready);
+  pthread_join((*pLog).Thread,NULL);
+  sem_destroy(&(*pLog).Ready);
+
+  // Writer thread has written all buffers handed over - write the rest here
+
+  Active  =  (*pLog).Active;
+  if (((*pLog).Used[Active]) && (!(*pLog).Error))
+  {
+    if (((*pLog).RingBytes) || (cMemoryReserveSpace((*pLog).Used[Active]) == OK))
+    {
+      cDatalogWriteBuffer(pLog,(*pLog).Written,(*pLog).Buffer[Active],(*pLog).Used[Active]);
+      (*pLog).Written  +=  (*pLog).Used[Active];
+    }
+  }
+
+  if ((*pLog).hRing >= 0)
+  {
+    if ((*pLog).RingBytes)
+    {
+      cDatalogCloseRing(pLog);
+    }
+    close((*pLog).hRing);
+  }
+
+#ifdef DEBUG_C_MEMORY_LOG
+  printf("LOG_CLOSE %d samples, %d dropped, %d write errors\n",(*pLog).Samples,(*pLog).Dropped,(*pLog).WriteErrors);
+#endif
+  if ((*pLog).WriteErrors)
+  {
+    LogErrorNumber(FILE_WRITE_ERROR);
+  }
+
+#ifdef ENABLE_LOG_COMPACT
+  free((*pLog).pIndex);
+#endif
+  free(pLog);
+}
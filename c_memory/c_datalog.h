@@ -0,0 +1,136 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef C_DATALOG_H_
+#define C_DATALOG_H_
+
+#include  "lms2012.h"
+
+#include  <pthread.h>
+#include  <semaphore.h>
+#include  <sys/types.h>
+
+#if (defined(ENABLE_LOG_COMPACT) && defined(ENABLE_LOG_ASCII))
+#error "ENABLE_LOG_COMPACT and ENABLE_LOG_ASCII can not be used together"
+#endif
+
+#ifdef ENABLE_LOG_COMPACT
+
+/*
+ *  Compact log format (after the two text header lines)
+ *
+ *  Samples are stored in blocks. Every block starts from scratch so a reader
+ *  can start decoding at any block. All numbers are little endian.
+ *
+ *    Block         Magic [4] (DATALOG_BLOCK_MAGIC)
+ *                  Bytes [2] (payload size)
+ *                  Records [2]
+ *                  Items [1] (values per record)
+ *                  Payload [Bytes]
+ *
+ *    Record        Time and then the Items values as varints. Every field is
+ *                  the zigzag encoded difference from the same field in the
+ *                  previous record in the block (0 for the first record).
+ *                  Values are the bit patterns of the DATAF values.
+ *
+ *    Index         Magic [4] (DATALOG_INDEX_MAGIC)
+ *                  Entries [4]
+ *                  Entries * (Offset [4], Time [4]) (file offset and time of block)
+ *                  Entries [4]
+ *                  Magic [4] (DATALOG_INDEX_MAGIC)
+ *
+ *  The index is followed by the normal 8 byte end signature so a reader can
+ *  find it from the end of the file. Both magics read as NaN if taken as a
+ *  DATAF time value so they can never be mistaken for a plain binary log.
+ */
+
+#define   DATALOG_BLOCK_MAGIC   0xFFC14C44            // "DL" + NaN
+#define   DATALOG_INDEX_MAGIC   0xFFC14944            // "DI" + NaN
+#define   DATALOG_BLOCK_HEADER  9                     // Bytes in block header
+#define   DATALOG_BLOCK_SIZE    2048                  // Max payload bytes in a block
+#define   DATALOG_MAX_ITEMS     127                   // Max values in a record
+#define   DATALOG_INDEX_STEP    256                   // Index entries allocated at a time
+
+#endif
+
+typedef   struct
+{
+  int       hFile;
+  pthread_t Thread;
+  sem_t     Ready;                              // Posted for every buffer handed over and on stop
+
+  DATA8     Stop;                               // Writer thread must terminate when all buffers are written
+  DATA8     Full[2];                            // Buffer is owned by the writer thread (atomic access only)
+  DATA32    Used[2];                            // Bytes in buffer
+  DATA32    Start[2];                           // Log position of first byte in buffer
+  DATA32    WriteErrors;                        // Buffers that could not be written (writer thread only)
+
+  off_t     Base;                               // File size when opened (log appended to existing file)
+  int       hRing;                              // Read/write handle to file in ring mode
+  DATA32    RingSamples;                        // Samples in ring (0 = log grows)
+  DATA32    RingRecord;                         // Bytes in every record in ring
+  DATA32    RingStart;                          // Log position of first record in ring
+  DATA32    RingBytes;                          // Bytes in ring (0 until first record - atomic access only)
+  UBYTE     Trailer[16];                        // Written after ring when closed
+  DATA32    TrailerBytes;
+
+  DATA8     Active;                             // Buffer being filled by the VM
+  DATA8     Error;                              // No space left - stop logging
+  DATA32    Limit;                              // Bytes that fits in active buffer before next aligned write
+  DATA32    FirstTime;                          // Time of first sample in active buffer [mS]
+  DATA32    Written;                            // Bytes handed over to the writer thread
+  DATA32    Samples;                            // Samples logged
+  DATA32    Dropped;                            // Samples lost because the writer thread could not keep up
+
+#ifdef ENABLE_LOG_COMPACT
+  DATA8     BlockItems;                         // Values per record in block
+  UWORD     BlockRecords;                       // Records in block
+  DATA32    BlockUsed;                          // Payload bytes in block
+  DATA32    BlockTime;                          // Time of first record in block [mS]
+  ULONG     Previous[DATALOG_MAX_ITEMS + 1];    // Previous time and values in block
+  ULONG     *pIndex;                            // Offset and time of every block written
+  DATA32    IndexEntries;
+  DATA32    IndexSize;
+  DATA8     IndexError;                         // Index could not be kept - do not write it
+  UBYTE     Block[DATALOG_BLOCK_HEADER + DATALOG_BLOCK_SIZE];
+#endif
+
+  UBYTE     Buffer[2][DATALOG_BUFFER_SIZE];
+}
+DATALOG;
+
+DATALOG*  cDatalogOpen(int hFile);
+
+RESULT    cDatalogAppend(DATALOG *pLog,UBYTE *pData,DATA32 Bytes);
+
+RESULT    cDatalogWrite(DATALOG *pLog,DATA32 Time,UBYTE *pData,DATA32 Bytes);
+
+RESULT    cDatalogSetRing(DATALOG *pLog,char *pFileName,DATA32 Samples);
+
+RESULT    cDatalogEnd(DATALOG *pLog,UBYTE *pData,DATA32 Bytes);
+
+#ifdef ENABLE_LOG_COMPACT
+RESULT    cDatalogWriteCompact(DATALOG *pLog,DATA32 Time,DATA8 Items,DATAF *pValues);
+
+RESULT    cDatalogWriteIndex(DATALOG *pLog);
+#endif
+
+void      cDatalogClose(DATALOG *pLog);
+
+#endif /* C_DATALOG_H_ */
@@ -0,0 +1,418 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ *  Directory cache
+ *
+ *  Every cached folder has an inotify watch that is added before the folder
+ *  is read so no change can be missed. Pending events are read (non blocking)
+ *  every time the cache is used:
+ *
+ *    entries created, deleted or moved       ->  list and size invalid
+ *    entries written or changed              ->  size invalid
+ *    folder itself deleted or moved          ->  list and size invalid, not watched
+ *    event queue overflow                    ->  everything invalid
+ *
+ *  A size that becomes invalid also invalidates the sizes of all cached
+ *  folders above it. Events only mark entries invalid - lists are freed when
+ *  the folder is read again or the slot is reused so a list being walked is
+ *  never freed under the walker.
+ */
+
+
+#include  "lms2012.h"
+#include  "c_memory.h"
+#include  "c_dircache.h"
+
+#include  <errno.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <unistd.h>
+#include  <sys/inotify.h>
+#include  <sys/stat.h>
+
+#define   DIRCACHE_EVENTS       (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+
+static void cDirCacheFreeList(DIRCACHEITEM *pItem)
+{
+  int     Item;
+
+  if ((*pItem).pNameList != NULL)
+  {
+    for (Item = 0;Item < (*pItem).Items;Item++)
+    {
+      free((*pItem).pNameList[Item]);
+    }
+    free((*pItem).pNameList);
+  }
+  (*pItem).pNameList  =  NULL;
+  (*pItem).Items      =  0;
+  (*pItem).ListValid  =  0;
+}
+
+
+static void cDirCacheInvalidateSize(char *pFolder)
+{
+  DIRCACHEITEM *pItem;
+  int     Slot;
+  size_t  Length;
+
+  // Folder itself and every cached folder above it
+  for (Slot = 0;Slot < DIRCACHE_FOLDERS;Slot++)
+  {
+    pItem   =  &MemoryInstance.DirCache[Slot];
+    Length  =  strlen((*pItem).Folder);
+
+    if (Length)
+    {
+      if ((strncmp(pFolder,(*pItem).Folder,Length) == 0) && ((pFolder[Length] == 0) || (pFolder[Length] == '/') || ((*pItem).Folder[Length - 1] == '/')))
+      {
+        (*pItem).SizeValid  =  0;
+      }
+    }
+  }
+}
+
+
+static void cDirCacheRemoveWatch(DIRCACHEITEM *pItem)
+{
+  int     Slot;
+  int     Shared = 0;
+
+  if ((*pItem).Watch >= 0)
+  {
+    // The same folder may be cached under different names
+    for (Slot = 0;Slot < DIRCACHE_FOLDERS;Slot++)
+    {
+      if ((&MemoryInstance.DirCache[Slot] != pItem) && (MemoryInstance.DirCache[Slot].Watch == (*pItem).Watch))
+      {
+        Shared  =  1;
+      }
+    }
+    if (!Shared)
+    {
+      inotify_rm_watch(MemoryInstance.DirNotify,(*pItem).Watch);
+    }
+    (*pItem).Watch  =  -1;
+  }
+}
+
+
+static void cDirCacheFreeSlot(DIRCACHEITEM *pItem)
+{
+  cDirCacheInvalidateSize((*pItem).Folder);
+  cDirCacheRemoveWatch(pItem);
+  cDirCacheFreeList(pItem);
+  (*pItem).Folder[0]  =  0;
+  (*pItem).SizeValid  =  0;
+  (*pItem).Locked     =  0;
+  (*pItem).Used       =  0;
+}
+
+
+static void cDirCacheUpdate(void)
+{
+  char    Buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  struct  inotify_event *pEvent;
+  DIRCACHEITEM *pItem;
+  ssize_t Length;
+  char    *pPointer;
+  int     Slot;
+
+  if (MemoryInstance.DirNotify >= 0)
+  {
+    while ((Length = read(MemoryInstance.DirNotify,Buffer,sizeof(Buffer))) > 0)
+    {
+      for (pPointer = Buffer;pPointer < &Buffer[Length];pPointer += sizeof(struct inotify_event) + (*pEvent).len)
+      {
+        pEvent  =  (struct inotify_event*)pPointer;
+
+        for (Slot = 0;Slot < DIRCACHE_FOLDERS;Slot++)
+        {
+          pItem  =  &MemoryInstance.DirCache[Slot];
+
+          if ((*pItem).Folder[0])
+          {
+            if ((*pEvent).mask & IN_Q_OVERFLOW)
+            {
+              (*pItem).ListValid  =  0;
+              (*pItem).SizeValid  =  0;
+            }
+            else
+            {
+              if ((*pItem).Watch == (*pEvent).wd)
+              {
+                if ((*pEvent).mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+                { // Watch is gone - read every time until slot is reused
+
+                  (*pItem).Watch      =  -1;
+                  (*pItem).ListValid  =  0;
+                }
+                if ((*pEvent).mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))
+                {
+                  (*pItem).ListValid  =  0;
+                }
+                cDirCacheInvalidateSize((*pItem).Folder);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+
+static DIRCACHEITEM* cDirCacheGetSlot(char *pFolder)
+{
+  DIRCACHEITEM *pItem = NULL;
+  DIRCACHEITEM *pOldest = NULL;
+  int     Slot;
+
+  for (Slot = 0;(Slot < DIRCACHE_FOLDERS) && (pItem == NULL);Slot++)
+  {
+    if (strcmp(MemoryInstance.DirCache[Slot].Folder,pFolder) == 0)
+    {
+      pItem  =  &MemoryInstance.DirCache[Slot];
+    }
+  }
+  if (pItem == NULL)
+  { // Not cached - use free or least recently used slot
+
+    for (Slot = 0;Slot < DIRCACHE_FOLDERS;Slot++)
+    {
+      if (!MemoryInstance.DirCache[Slot].Locked)
+      {
+        if ((pOldest == NULL) || (MemoryInstance.DirCache[Slot].Used < (*pOldest).Used))
+        {
+          pOldest  =  &MemoryInstance.DirCache[Slot];
+        }
+      }
+    }
+    pItem  =  pOldest;
+    if (pItem != NULL)
+    {
+      if ((*pItem).Folder[0])
+      {
+        cDirCacheFreeSlot(pItem);
+      }
+      snprintf((*pItem).Folder,vmFILENAMESIZE,"%s",pFolder);
+
+      // Watch before reading so that no change is lost
+      (*pItem).Watch  =  -1;
+      if (MemoryInstance.DirNotify >= 0)
+      {
+        (*pItem).Watch  =  inotify_add_watch(MemoryInstance.DirNotify,pFolder,DIRCACHE_EVENTS);
+      }
+#ifdef DEBUG
+      if ((*pItem).Watch < 0)
+      {
+        printf("DirCache %s not watched (%d)\r\n",pFolder,errno);
+      }
+#endif
+    }
+  }
+  if (pItem != NULL)
+  {
+    (*pItem).Used  =  ++MemoryInstance.DirCacheTime;
+  }
+
+  return (pItem);
+}
+
+
+static DIRCACHEITEM* cDirCacheList(char *pFolder)
+{
+  DIRCACHEITEM *pItem;
+
+  cDirCacheUpdate();
+  pItem  =  cDirCacheGetSlot(pFolder);
+
+  if (pItem != NULL)
+  { // List is not read again while the folder is walked further up
+
+    if (((!(*pItem).ListValid) || ((*pItem).Watch < 0)) && (!(*pItem).Locked))
+    {
+      cDirCacheFreeList(pItem);
+      (*pItem).Items  =  scandir(pFolder,&(*pItem).pNameList,0,(int (*)(const struct dirent **,const struct dirent **))&cMemorySort);
+      if ((*pItem).Items < 0)
+      {
+        (*pItem).Items      =  0;
+        (*pItem).pNameList  =  NULL;
+        cDirCacheFreeSlot(pItem);
+        pItem  =  NULL;
+      }
+      else
+      {
+        (*pItem).ListValid  =  1;
+      }
+    }
+  }
+
+  return (pItem);
+}
+
+
+static void cDirCacheMakeKey(char *pFolderName,char *pFolder)
+{
+  size_t  Length;
+
+  snprintf(pFolder,vmFILENAMESIZE,"%s",pFolderName);
+  Length  =  strlen(pFolder);
+  while ((Length > 1) && (pFolder[Length - 1] == '/'))
+  {
+    pFolder[--Length]  =  0;
+  }
+}
+
+
+DIRCACHEITEM* cDirCacheGetList(char *pFolderName)
+{
+  char    Folder[vmFILENAMESIZE];
+
+  cDirCacheMakeKey(pFolderName,Folder);
+
+  return (cDirCacheList(Folder));
+}
+
+
+static DATA32 cDirCacheFolderSize(char *pFolder,DATA8 Depth)
+{
+  DIRCACHEITEM *pItem;
+  struct  stat Status;
+  char    Name[vmFILENAMESIZE];
+  DATA32  Size = 0;
+  int     Item;
+
+  pItem  =  cDirCacheList(pFolder);
+  if ((pItem != NULL) && (*pItem).SizeValid && ((*pItem).Watch >= 0))
+  {
+    Size  =  (*pItem).Size;
+  }
+  else
+  {
+    if (stat(pFolder,&Status) == 0)
+    {
+      Size  =  (DATA32)Status.st_size;
+    }
+    if (pItem != NULL)
+    {
+      if (!(*pItem).Locked)
+      {
+        // Valid unless an event arrives while the folder is walked
+        (*pItem).SizeValid  =  1;
+        (*pItem).Locked     =  1;
+
+        for (Item = 0;Item < (*pItem).Items;Item++)
+        {
+          if ((strcmp((*(*pItem).pNameList[Item]).d_name,".") != 0) && (strcmp((*(*pItem).pNameList[Item]).d_name,"..") != 0))
+          {
+            if ((snprintf(Name,vmFILENAMESIZE,"%s%s%s",pFolder,(pFolder[strlen(pFolder) - 1] == '/') ? "" : "/",(*(*pItem).pNameList[Item]).d_name) < vmFILENAMESIZE) && (lstat(Name,&Status) == 0))
+            {
+              if (S_ISDIR(Status.st_mode) && (Depth < DIRCACHE_FOLDERS / 2))
+              {
+                Size +=  cDirCacheFolderSize(Name,Depth + 1);
+              }
+              else
+              {
+                Size +=  (DATA32)Status.st_size;
+              }
+            }
+          }
+        }
+        (*pItem).Locked  =  0;
+        (*pItem).Size    =  Size;
+      }
+    }
+  }
+
+  return (Size);
+}
+
+
+RESULT    cDirCacheGetSize(char *pFolderName,DATA32 *pSize)
+{
+  RESULT  Result = FAIL;
+  char    Folder[vmFILENAMESIZE];
+  struct  stat Status;
+
+  *pSize  =  0;
+  cDirCacheMakeKey(pFolderName,Folder);
+
+  if (stat(Folder,&Status) == 0)
+  {
+    if (S_ISDIR(Status.st_mode))
+    {
+      *pSize  =  cDirCacheFolderSize(Folder,0);
+    }
+    else
+    {
+      *pSize  =  (DATA32)Status.st_size;
+    }
+    Result  =  OK;
+  }
+
+  return (Result);
+}
+
+
+void      cDirCacheInit(void)
+{
+  int     Slot;
+
+  for (Slot = 0;Slot < DIRCACHE_FOLDERS;Slot++)
+  {
+    MemoryInstance.DirCache[Slot].Folder[0]  =  0;
+    MemoryInstance.DirCache[Slot].Watch      =  -1;
+    MemoryInstance.DirCache[Slot].ListValid  =  0;
+    MemoryInstance.DirCache[Slot].SizeValid  =  0;
+    MemoryInstance.DirCache[Slot].Locked     =  0;
+    MemoryInstance.DirCache[Slot].Items      =  0;
+    MemoryInstance.DirCache[Slot].pNameList  =  NULL;
+    MemoryInstance.DirCache[Slot].Used       =  0;
+  }
+  MemoryInstance.DirCacheTime  =  0;
+  MemoryInstance.DirNotify     =  inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#ifdef DEBUG
+  if (MemoryInstance.DirNotify < 0)
+  {
+    printf("DirCache inotify not available (%d)\r\n",errno);
+  }
+#endif
+}
+
+
+void      cDirCacheExit(void)
+{
+  int     Slot;
+
+  for (Slot = 0;Slot < DIRCACHE_FOLDERS;Slot++)
+  {
+    cDirCacheFreeList(&MemoryInstance.DirCache[Slot]);
+    MemoryInstance.DirCache[Slot].Folder[0]  =  0;
+    MemoryInstance.DirCache[Slot].Watch      =  -1;
+  }
+  if (MemoryInstance.DirNotify >= 0)
+  {
+    close(MemoryInstance.DirNotify);
+    MemoryInstance.DirNotify  =  -1;
+  }
+}
@@ -0,0 +1,60 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef C_DIRCACHE_H_
+#define C_DIRCACHE_H_
+
+#include  "lms2012.h"
+
+#include  <dirent.h>
+
+/*
+ *  Directory cache
+ *
+ *  Folder listings and folder sizes are kept between calls and only read
+ *  again from the file system when inotify reports a change in the folder
+ *  (or below it for sizes). Folders that can not be watched are read every
+ *  time as before.
+ */
+
+#define   DIRCACHE_FOLDERS      64                    // Max folders in directory cache
+
+typedef   struct
+{
+  char      Folder[vmFILENAMESIZE];             // Folder name without trailing "/" (empty = slot free)
+  int       Watch;                              // inotify watch descriptor (-1 = not watched - read every time)
+  DATA8     ListValid;                          // Entry list is up to date
+  DATA8     SizeValid;                          // Size is up to date
+  DATA8     Locked;                             // List in use while sizing sub folders - must not be reused
+  int       Items;                              // Entries in folder (including "." and "..")
+  struct dirent **pNameList;                    // Entries sorted by cMemorySort
+  DATA32    Size;                               // Bytes in folder and everything below it
+  ULONG     Used;                               // Time stamp of last use
+}
+DIRCACHEITEM;
+
+void      cDirCacheInit(void);
+
+void      cDirCacheExit(void);
+
+DIRCACHEITEM* cDirCacheGetList(char *pFolderName);
+
+RESULT    cDirCacheGetSize(char *pFolderName,DATA32 *pSize);
+
+#endif /* C_DIRCACHE_H_ */
@@ -0,0 +1,217 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+/*
+ *  Image cache
+ *
+ *  The image pointer returned is owned by the cache and is only valid
+ *  until the cache is used again - callers copy or draw it right away.
+ */
+
+
+#include  "lms2012.h"
+#include  "c_memory.h"
+#include  "c_imagecache.h"
+
+#include  <fcntl.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <unistd.h>
+#include  <sys/stat.h>
+
+
+static void cImageCacheFree(IMAGECACHEITEM *pItem)
+{
+  if ((*pItem).pImage != NULL)
+  {
+    free((*pItem).pImage);
+    MemoryInstance.ImageCacheBytes -=  (*pItem).Size;
+  }
+  memset(pItem,0,sizeof(IMAGECACHEITEM));
+}
+
+
+static IMAGECACHEITEM* cImageCacheNew(DATA32 Size)
+{
+  IMAGECACHEITEM *pItem = NULL;
+  IMAGECACHEITEM *pOldest;
+  int     Entry;
+
+  do
+  {
+    pOldest  =  NULL;
+    for (Entry = 0;(Entry < IMAGECACHE_ENTRIES) && (pItem == NULL);Entry++)
+    {
+      if (MemoryInstance.ImageCache[Entry].Name[0] == 0)
+      {
+        if ((MemoryInstance.ImageCacheBytes + Size) <= IMAGE_CACHE_SIZE)
+        {
+          pItem  =  &MemoryInstance.ImageCache[Entry];
+        }
+      }
+      else
+      {
+        if ((pOldest == NULL) || (MemoryInstance.ImageCache[Entry].Used < (*pOldest).Used))
+        {
+          pOldest  =  &MemoryInstance.ImageCache[Entry];
+        }
+      }
+    }
+    if ((pItem == NULL) && (pOldest != NULL))
+    { // No room - drop least recently used image
+
+      cImageCacheFree(pOldest);
+    }
+  }
+  while ((pItem == NULL) && (pOldest != NULL));
+
+  return (pItem);
+}
+
+
+static UBYTE* cImageCacheRead(char *pFileName,struct stat *pStatus)
+{
+  UBYTE   *pImage = NULL;
+  int     hFile;
+
+  hFile  =  open(pFileName,O_RDONLY);
+  if (hFile >= MIN_HANDLE)
+  {
+    if ((fstat(hFile,pStatus) == 0) && (S_ISREG((*pStatus).st_mode)) && ((*pStatus).st_size > 0) && ((*pStatus).st_size <= DATA32_MAX))
+    {
+      pImage  =  (UBYTE*)malloc((size_t)(*pStatus).st_size);
+      if (pImage != NULL)
+      {
+        if (read(hFile,pImage,(size_t)(*pStatus).st_size) != (ssize_t)(*pStatus).st_size)
+        {
+          free(pImage);
+          pImage  =  NULL;
+        }
+      }
+    }
+    close(hFile);
+  }
+
+  return (pImage);
+}
+
+
+/*! \brief    Get image file contents
+ *
+ *  \param    pFileName   Full file name including extension
+ *  \param    ppImage     Set to image bytes (valid until next call)
+ *  \param    pSize       Set to number of bytes
+ *  \return   OK or FAIL (file could not be read)
+ */
+RESULT    cImageCacheGet(char *pFileName,UBYTE **ppImage,DATA32 *pSize)
+{
+  RESULT  Result = FAIL;
+  IMAGECACHEITEM *pItem = NULL;
+  struct  stat Status;
+  UBYTE   *pImage;
+  int     Entry;
+
+  // Image too big for the cache from last call
+  free(MemoryInstance.pImageScratch);
+  MemoryInstance.pImageScratch  =  NULL;
+
+  for (Entry = 0;(Entry < IMAGECACHE_ENTRIES) && (pItem == NULL);Entry++)
+  {
+    if ((MemoryInstance.ImageCache[Entry].Name[0]) && (strcmp(MemoryInstance.ImageCache[Entry].Name,pFileName) == 0))
+    {
+      pItem  =  &MemoryInstance.ImageCache[Entry];
+    }
+  }
+  if (pItem != NULL)
+  {
+    if ((stat(pFileName,&Status) == 0) && ((*pItem).Device == (ULONG)Status.st_dev) && ((*pItem).Inode == (ULONG)Status.st_ino) && ((*pItem).Size == (DATA32)Status.st_size) && ((*pItem).Time == (ULONG)Status.st_mtim.tv_sec) && ((*pItem).TimeNs == (ULONG)Status.st_mtim.tv_nsec))
+    { // Cached image is up to date
+
+      (*pItem).Used  =  ++MemoryInstance.ImageCacheTime;
+      *ppImage  =  (*pItem).pImage;
+      *pSize    =  (*pItem).Size;
+      Result    =  OK;
+    }
+    else
+    {
+      cImageCacheFree(pItem);
+    }
+  }
+  if (Result != OK)
+  {
+    pImage  =  cImageCacheRead(pFileName,&Status);
+    if (pImage != NULL)
+    {
+      *ppImage  =  pImage;
+      *pSize    =  (DATA32)Status.st_size;
+      Result    =  OK;
+
+      pItem     =  NULL;
+      if ((Status.st_size <= IMAGE_CACHE_SIZE) && (strlen(pFileName) < vmFILENAMESIZE))
+      {
+        pItem  =  cImageCacheNew((DATA32)Status.st_size);
+      }
+      if (pItem != NULL)
+      {
+        snprintf((*pItem).Name,vmFILENAMESIZE,"%s",pFileName);
+        (*pItem).Device  =  (ULONG)Status.st_dev;
+        (*pItem).Inode   =  (ULONG)Status.st_ino;
+        (*pItem).Time    =  (ULONG)Status.st_mtim.tv_sec;
+        (*pItem).TimeNs  =  (ULONG)Status.st_mtim.tv_nsec;
+        (*pItem).Size    =  (DATA32)Status.st_size;
+        (*pItem).pImage  =  pImage;
+        (*pItem).Used    =  ++MemoryInstance.ImageCacheTime;
+        MemoryInstance.ImageCacheBytes +=  (*pItem).Size;
+      }
+      else
+      {
+        MemoryInstance.pImageScratch  =  pImage;
+      }
+    }
+  }
+#ifdef DEBUG
+  printf("Image %s %s\r\n",pFileName,(Result == OK) ? ((MemoryInstance.pImageScratch == NULL) ? "ok" : "not cached") : "not found");
+#endif
+
+  return (Result);
+}
+
+
+void      cImageCacheInit(void)
+{
+  memset(MemoryInstance.ImageCache,0,sizeof(MemoryInstance.ImageCache));
+  MemoryInstance.ImageCacheBytes  =  0;
+  MemoryInstance.ImageCacheTime   =  0;
+  MemoryInstance.pImageScratch    =  NULL;
+}
+
+
+void      cImageCacheExit(void)
+{
+  int     Entry;
+
+  for (Entry = 0;Entry < IMAGECACHE_ENTRIES;Entry++)
+  {
+    cImageCacheFree(&MemoryInstance.ImageCache[Entry]);
+  }
+  free(MemoryInstance.pImageScratch);
+  MemoryInstance.pImageScratch  =  NULL;
+}
@@ -0,0 +1,61 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#ifndef C_IMAGECACHE_H_
+#define C_IMAGECACHE_H_
+
+#include  "lms2012.h"
+
+/*
+ *  Image cache
+ *
+ *  Graphic files (BMPFILE, icons) are kept in memory keyed by name and
+ *  checked against device, inode, size and modification time before use,
+ *  so drawing the same image again does not read the file. The least
+ *  recently used images are dropped when IMAGE_CACHE_SIZE bytes are used.
+ *  Images larger than the cache are read every time.
+ */
+
+#ifndef   IMAGE_CACHE_SIZE
+#define   IMAGE_CACHE_SIZE      65536                 // Max bytes in image cache (0 = no cache)
+#endif
+
+#define   IMAGECACHE_ENTRIES    32                    // Max images in cache
+
+typedef   struct
+{
+  char      Name[vmFILENAMESIZE];               // File name (empty = entry free)
+  ULONG     Device;
+  ULONG     Inode;
+  ULONG     Time;                               // Modification time [S]
+  ULONG     TimeNs;                             // Modification time [nS]
+  DATA32    Size;                               // Bytes in image
+  UBYTE     *pImage;
+  ULONG     Used;                               // Time stamp of last use
+}
+IMAGECACHEITEM;
+
+void      cImageCacheInit(void);
+
+void      cImageCacheExit(void);
+
+RESULT    cImageCacheGet(char *pFileName,UBYTE **ppImage,DATA32 *pSize);
+
+#endif /* C_IMAGECACHE_H_ */
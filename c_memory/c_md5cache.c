@@ -0,0 +1,249 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+/*
+ *  MD5 cache
+ *
+ *  An entry is only used if device, inode, size and modification time
+ *  (seconds and nanoseconds) all match the file, so any later write that
+ *  moves the time stamp drops it.
+ *
+ *  A digest calculated from the file itself is only stored if the file did
+ *  not change while it was read and was last modified more than a second
+ *  ago - another writer could still be writing within the same time stamp
+ *  tick. A digest from the download path is stored right away: it was
+ *  calculated from exactly the bytes written and the file is still open by
+ *  the writer.
+ */
+
+
+#include  "lms2012.h"
+#include  "c_memory.h"
+#include  "c_md5.h"
+#include  "c_md5cache.h"
+
+#include  <fcntl.h>
+#include  <stdio.h>
+#include  <string.h>
+#include  <time.h>
+#include  <unistd.h>
+#include  <sys/stat.h>
+
+
+static MD5CACHEITEM* cMd5CacheFind(struct stat *pStatus,DATA8 Create)
+{
+  MD5CACHEITEM *pItem = NULL;
+  MD5CACHEITEM *pOldest = NULL;
+  int     Entry;
+
+  for (Entry = 0;(Entry < MD5CACHE_ENTRIES) && (pItem == NULL);Entry++)
+  {
+    if ((MemoryInstance.Md5Cache[Entry].Used) && (MemoryInstance.Md5Cache[Entry].Device == (ULONG)(*pStatus).st_dev) && (MemoryInstance.Md5Cache[Entry].Inode == (ULONG)(*pStatus).st_ino))
+    {
+      pItem  =  &MemoryInstance.Md5Cache[Entry];
+    }
+    if ((pOldest == NULL) || (MemoryInstance.Md5Cache[Entry].Used < (*pOldest).Used))
+    {
+      pOldest  =  &MemoryInstance.Md5Cache[Entry];
+    }
+  }
+  if (pItem != NULL)
+  {
+    if (((*pItem).Size != (ULONG)(*pStatus).st_size) || ((*pItem).Time != (ULONG)(*pStatus).st_mtim.tv_sec) || ((*pItem).TimeNs != (ULONG)(*pStatus).st_mtim.tv_nsec))
+    { // File has changed
+
+      if (!Create)
+      {
+        pItem  =  NULL;
+      }
+    }
+  }
+  else
+  {
+    if (Create)
+    {
+      pItem  =  pOldest;
+    }
+  }
+  if ((pItem != NULL) && (Create))
+  {
+    (*pItem).Device  =  (ULONG)(*pStatus).st_dev;
+    (*pItem).Inode   =  (ULONG)(*pStatus).st_ino;
+    (*pItem).Size    =  (ULONG)(*pStatus).st_size;
+    (*pItem).Time    =  (ULONG)(*pStatus).st_mtim.tv_sec;
+    (*pItem).TimeNs  =  (ULONG)(*pStatus).st_mtim.tv_nsec;
+    MemoryInstance.Md5CacheChanged  =  1;
+  }
+  if (pItem != NULL)
+  {
+    (*pItem).Used  =  ++MemoryInstance.Md5CacheTime;
+  }
+
+  return (pItem);
+}
+
+
+/*! \brief    Get MD5 digest of file
+ *
+ *  Same result as md5_file: 1 = digest in pMd5, 0 = file could not be read
+ */
+int       cMd5CacheFile(char *pFileName,unsigned char *pMd5)
+{
+  int     Result = 0;
+  MD5CACHEITEM *pItem;
+  DATA8   Regular = 0;
+  struct  stat Before;
+  struct  stat After;
+  ULONG   Md5[4];
+
+  if ((stat(pFileName,&Before) == 0) && (S_ISREG(Before.st_mode)))
+  {
+    Regular  =  1;
+    pItem  =  cMd5CacheFind(&Before,0);
+    if (pItem != NULL)
+    {
+      memcpy(pMd5,(*pItem).Md5,sizeof(Md5));
+      Result  =  1;
+    }
+  }
+  if (!Result)
+  {
+    Result  =  md5_file(pFileName,0,(unsigned char*)Md5);
+    if (Result)
+    {
+      memcpy(pMd5,Md5,sizeof(Md5));
+
+      if ((Regular) && (stat(pFileName,&After) == 0))
+      {
+        if ((Before.st_ino == After.st_ino) && (Before.st_size == After.st_size) && (Before.st_mtim.tv_sec == After.st_mtim.tv_sec) && (Before.st_mtim.tv_nsec == After.st_mtim.tv_nsec) && (After.st_mtim.tv_sec < (time(NULL) - 1)))
+        {
+          pItem  =  cMd5CacheFind(&After,1);
+          memcpy((*pItem).Md5,Md5,sizeof(Md5));
+        }
+      }
+    }
+  }
+
+  return (Result);
+}
+
+
+/*! \brief    Store digest of file that has just been written
+ *
+ *  Must be called after the last write and before the file is closed - the
+ *  digest must have been calculated from exactly the bytes written. It is
+ *  stored with the exact size and modification time of the file so
+ *  cMd5CacheFind drops it as soon as the file is written again.
+ */
+void      cMd5CacheAdd(int hFile,unsigned char *pMd5)
+{
+  MD5CACHEITEM *pItem;
+  struct  stat Status;
+
+  if ((fstat(hFile,&Status) == 0) && (S_ISREG(Status.st_mode)))
+  {
+    pItem  =  cMd5CacheFind(&Status,1);
+    memcpy((*pItem).Md5,pMd5,sizeof((*pItem).Md5));
+  }
+}
+
+
+void      cMd5CacheInit(void)
+{
+  char    FileName[vmFILENAMESIZE];
+  int     hFile;
+  ULONG   Header[2];
+  int     Entry;
+
+  memset(MemoryInstance.Md5Cache,0,sizeof(MemoryInstance.Md5Cache));
+  MemoryInstance.Md5CacheTime     =  0;
+  MemoryInstance.Md5CacheChanged  =  0;
+
+  snprintf(FileName,vmFILENAMESIZE,"%s/%s",vmSETTINGS_DIR,MD5CACHE_FILE_NAME);
+  hFile  =  open(FileName,O_RDONLY);
+  if (hFile >= MIN_HANDLE)
+  {
+    if ((read(hFile,Header,sizeof(Header)) == sizeof(Header)) && (Header[0] == MD5CACHE_MAGIC) && (Header[1] <= MD5CACHE_ENTRIES))
+    {
+      if (read(hFile,MemoryInstance.Md5Cache,Header[1] * sizeof(MD5CACHEITEM)) == (ssize_t)(Header[1] * sizeof(MD5CACHEITEM)))
+      {
+        for (Entry = 0;Entry < MD5CACHE_ENTRIES;Entry++)
+        {
+          if (MemoryInstance.Md5Cache[Entry].Used > MemoryInstance.Md5CacheTime)
+          {
+            MemoryInstance.Md5CacheTime  =  MemoryInstance.Md5Cache[Entry].Used;
+          }
+        }
+      }
+      else
+      {
+        memset(MemoryInstance.Md5Cache,0,sizeof(MemoryInstance.Md5Cache));
+      }
+    }
+    close(hFile);
+  }
+}
+
+
+/*! \brief    Save cache if it has changed
+ *
+ *  Called when a program stops and when the VM exits
+ */
+void      cMd5CacheSave(void)
+{
+  char    FileName[vmFILENAMESIZE];
+  char    TmpName[vmFILENAMESIZE];
+  int     hFile;
+  ULONG   Header[2];
+  RESULT  Result = FAIL;
+
+  snprintf(FileName,vmFILENAMESIZE,"%s/%s",vmSETTINGS_DIR,MD5CACHE_FILE_NAME);
+  if ((MemoryInstance.Md5CacheChanged) && (snprintf(TmpName,vmFILENAMESIZE,"%s.tmp",FileName) < vmFILENAMESIZE))
+  {
+    // Replace old cache in one step so a crash never leaves half a file
+    hFile  =  open(TmpName,O_CREAT | O_WRONLY | O_TRUNC,FILEPERMISSIONS);
+    if (hFile >= MIN_HANDLE)
+    {
+      Header[0]  =  MD5CACHE_MAGIC;
+      Header[1]  =  MD5CACHE_ENTRIES;
+      if ((write(hFile,Header,sizeof(Header)) == sizeof(Header)) && (write(hFile,MemoryInstance.Md5Cache,sizeof(MemoryInstance.Md5Cache)) == sizeof(MemoryInstance.Md5Cache)))
+      {
+        if (fsync(hFile) == 0)
+        {
+          Result  =  OK;
+        }
+      }
+      close(hFile);
+      if ((Result == OK) && (rename(TmpName,FileName) == 0))
+      {
+        MemoryInstance.Md5CacheChanged  =  0;
+      }
+      else
+      {
+        remove(TmpName);
+      }
+    }
+  }
+}
+
+
+void      cMd5CacheExit(void)
+{
+  cMd5CacheSave();
+}
@@ -0,0 +1,65 @@
+/*
+ * lms2012-compat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef C_MD5CACHE_H_
+#define C_MD5CACHE_H_
+
+#include  "lms2012.h"
+
+/*
+ *  MD5 cache
+ *
+ *  Digests of files are kept keyed by device, inode, size and modification
+ *  time so a file is only read again when it has changed. Files received
+ *  through the download path are hashed while they are written. The cache
+ *  is saved in the settings folder when a program stops and when the VM
+ *  exits.
+ *
+ *  Cache file      Magic [4] (MD5CACHE_MAGIC)
+ *                  Entries [4]
+ *                  Entries * MD5CACHEITEM
+ */
+
+#define   MD5CACHE_ENTRIES      256                   // Max files in cache
+#define   MD5CACHE_MAGIC        0x3143444D            // "MDC1"
+#define   MD5CACHE_FILE_NAME    "md5cache"            // File name in settings folder
+
+typedef   struct
+{
+  ULONG     Device;
+  ULONG     Inode;
+  ULONG     Size;
+  ULONG     Time;                               // Modification time [S]
+  ULONG     TimeNs;                             // Modification time [nS]
+  ULONG     Md5[4];
+  ULONG     Used;                               // Time stamp of last use (0 = entry free)
+}
+MD5CACHEITEM;
+
+void      cMd5CacheInit(void);
+
+void      cMd5CacheExit(void);
+
+void      cMd5CacheSave(void);
+
+int       cMd5CacheFile(char *pFileName,unsigned char *pMd5);
+
+void      cMd5CacheAdd(int hFile,unsigned char *pMd5);
+
+#endif /* C_MD5CACHE_H_ */
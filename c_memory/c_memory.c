@@ -70,6 +70,8 @@
 #include <sys/sysinfo.h>
 #include <mntent.h>
 #include <malloc.h>
+#include <errno.h>
+#include <sys/mman.h>
 
 MEMORY_GLOBALS MemoryInstance;
 
@@ -77,6 +79,26 @@ MEMORY_GLOBALS MemoryInstance;
 #define   DEBUG
 #endif
 
+/*
+ *  Free space accounting
+ *
+ *  The file system is only queried (statvfs) when the figures are older than
+ *  UPDATE_MEMORY, when forced or when a reservation does not fit. In between
+ *  every byte written or reserved by the VM is subtracted from the free space
+ *  found at the last query so that the out of space checks stay conservative.
+ *  If a write still fails with ENOSPC (other processes writing) the figures
+ *  are refreshed on the spot.
+ */
+void      cMemoryUpdateFree(void)
+{
+  VMInstance.MemoryFree  =  MemoryInstance.SpaceFree - ((MemoryInstance.SpaceUsed + (KB - 1)) / KB);
+  if (VMInstance.MemoryFree < 0)
+  {
+    VMInstance.MemoryFree  =  0;
+  }
+}
+
+
 void      cMemoryGetUsage(DATA32 *pTotal,DATA32 *pFree,DATA8 Force)
 {
   ULONG   Time;
@@ -97,12 +119,10 @@ void      cMemoryGetUsage(DATA32 *pTotal,DATA32 *pFree,DATA8 Force)
         VMInstance.MemorySize  =  (DATA32)(Status.f_blocks * (Status.f_bsize / KB));
       }
 #endif
-      Used                   =  (DATA32)((Status.f_blocks - Status.f_bavail) * (Status.f_bsize / KB));
-      VMInstance.MemoryFree  =  VMInstance.MemorySize - Used;
-      if (VMInstance.MemoryFree < 0)
-      {
-        VMInstance.MemoryFree  =  0;
-      }
+      Used                        =  (DATA32)((Status.f_blocks - Status.f_bavail) * (Status.f_bsize / KB));
+      MemoryInstance.SpaceFree    =  VMInstance.MemorySize - Used;
+      MemoryInstance.SpaceUsed    =  0;
+      cMemoryUpdateFree();
     }
   }
 
@@ -123,6 +143,34 @@ void      cMemoryGetUsage(DATA32 *pTotal,DATA32 *pFree,DATA8 Force)
 }
 
 
+RESULT    cMemoryReserveSpace(DATA32 Bytes)
+{
+  RESULT  Result = FAIL;
+  DATA32  Free;
+
+  cMemoryGetUsage(NULL,&Free,0);
+  if (((Bytes + (KB - 1)) / KB) > Free)
+  { // Estimate says no - ask the file system before refusing
+
+    cMemoryGetUsage(NULL,&Free,1);
+  }
+  if (((MemoryInstance.SpaceUsed + Bytes + (KB - 1)) / KB) <= MemoryInstance.SpaceFree)
+  {
+    MemoryInstance.SpaceUsed +=  Bytes;
+    cMemoryUpdateFree();
+    Result  =  OK;
+  }
+#ifdef DEBUG_C_MEMORY_LOW
+  if (Result != OK)
+  {
+    printf("  cMemoryReserveSpace ERROR     B=%10lu F=%10luKB\n",(long unsigned int)Bytes,(long unsigned int)VMInstance.MemoryFree);
+  }
+#endif
+
+  return (Result);
+}
+
+
 RESULT    cMemoryRealloc(void *pOldMemory,void **ppMemory,DATA32 Size)
 {
   RESULT  Result = FAIL;
@@ -161,7 +209,69 @@ RESULT    cMemoryFree(void *pMemory)
 }
 
 
-RESULT    cMemoryAlloc(PRGID PrgId,DATA8 Type,GBINDEX Size,void **ppMemory,HANDLER *pHandle)
+/*
+ *  Memory usage
+ *
+ *  Bytes held in pools are counted per program and per kind of allocation
+ *  with the peak since the program was started. MEMORY_KIND_ALL is the sum
+ *  of all kinds but MEMORY_KIND_MAPPED (not in RAM).
+ */
+#ifdef DEBUG_MEMORY_USAGE
+static const char *MemoryKindName[MEMORY_KINDS + 1] =
+{
+  [MEMORY_KIND_PROGRAM] = "program",
+  [MEMORY_KIND_ARRAY]   = "array",
+  [MEMORY_KIND_STRING]  = "string",
+  [MEMORY_KIND_FILE]    = "file",
+  [MEMORY_KIND_IMAGE]   = "image",
+  [MEMORY_KIND_MAPPED]  = "mapped",
+  [MEMORY_KIND_ALL]     = "total",
+};
+#endif
+
+static void cMemoryAccount(PRGID PrgId,DATA8 Kind,GBINDEX OldSize,GBINDEX NewSize)
+{
+  MEMORYUSAGE *pUsage;
+
+  if ((PrgId >= 0) && (PrgId < MAX_PROGRAMS) && (Kind >= 0) && (Kind < MEMORY_KINDS))
+  {
+    pUsage  =  &MemoryInstance.Usage[PrgId][Kind];
+    (*pUsage).Current +=  (DATA32)NewSize - (DATA32)OldSize;
+    if ((*pUsage).Current > (*pUsage).Peak)
+    {
+      (*pUsage).Peak  =  (*pUsage).Current;
+    }
+    if (Kind != MEMORY_KIND_MAPPED)
+    {
+      pUsage  =  &MemoryInstance.Usage[PrgId][MEMORY_KIND_ALL];
+      (*pUsage).Current +=  (DATA32)NewSize - (DATA32)OldSize;
+      if ((*pUsage).Current > (*pUsage).Peak)
+      {
+        (*pUsage).Peak  =  (*pUsage).Current;
+      }
+    }
+  }
+}
+
+
+RESULT    cMemoryGetPoolUsage(PRGID PrgId,DATA8 Kind,DATA32 *pCurrent,DATA32 *pPeak)
+{
+  RESULT  Result = FAIL;
+
+  *pCurrent  =  0;
+  *pPeak     =  0;
+  if ((PrgId >= 0) && (PrgId < MAX_PROGRAMS) && (Kind >= 0) && (Kind <= MEMORY_KIND_ALL))
+  {
+    *pCurrent  =  MemoryInstance.Usage[PrgId][Kind].Current;
+    *pPeak     =  MemoryInstance.Usage[PrgId][Kind].Peak;
+    Result     =  OK;
+  }
+
+  return (Result);
+}
+
+
+RESULT    cMemoryAlloc(PRGID PrgId,DATA8 Type,DATA8 Kind,GBINDEX Size,void **ppMemory,HANDLER *pHandle)
 {
   RESULT  Result = FAIL;
   HANDLER TmpHandle;
@@ -183,7 +293,9 @@ RESULT    cMemoryAlloc(PRGID PrgId,DATA8 Type,GBINDEX Size,void **ppMemory,HANDL
       {
         *ppMemory  =  MemoryInstance.pPoolList[PrgId][TmpHandle].pPool;
         MemoryInstance.pPoolList[PrgId][TmpHandle].Type   =  Type;
+        MemoryInstance.pPoolList[PrgId][TmpHandle].Kind   =  Kind;
         MemoryInstance.pPoolList[PrgId][TmpHandle].Size   =  Size;
+        cMemoryAccount(PrgId,Kind,0,Size);
         *pHandle  =  TmpHandle;
         Result    =  OK;
       }
@@ -204,6 +316,105 @@ RESULT    cMemoryAlloc(PRGID PrgId,DATA8 Type,GBINDEX Size,void **ppMemory,HANDL
 }
 
 
+/*
+ *  Mapped pools
+ *
+ *  Big arrays can be kept in a scratch file in MEMORY_FOLDER that is mapped
+ *  into memory so the kernel only keeps the pages in use in RAM. The file is
+ *  removed right after it is created so it disappears with the pool - also
+ *  if the VM crashes. Storage is allocated up front so that writing to the
+ *  array can not fail later on a full file system.
+ */
+static void* cMemoryMap(int hFile,GBINDEX OldSize,GBINDEX Size)
+{
+  void    *pMemory = NULL;
+  RESULT  Result = OK;
+
+  if (Size > OldSize)
+  {
+    Result  =  cMemoryReserveSpace((DATA32)(Size - OldSize));
+    if ((Result == OK) && (posix_fallocate(hFile,0,(off_t)Size) != 0))
+    {
+      Result  =  FAIL;
+    }
+  }
+  else
+  {
+    if (ftruncate(hFile,(off_t)Size) != 0)
+    {
+      Result  =  FAIL;
+    }
+  }
+  if (Result == OK)
+  {
+    pMemory  =  mmap(NULL,(size_t)Size,PROT_READ | PROT_WRITE,MAP_SHARED,hFile,0);
+    if (pMemory == MAP_FAILED)
+    {
+      pMemory  =  NULL;
+    }
+  }
+
+  return (pMemory);
+}
+
+
+RESULT    cMemoryAllocMapped(PRGID PrgId,GBINDEX Size,void **ppMemory,HANDLER *pHandle)
+{
+  RESULT  Result = FAIL;
+  HANDLER TmpHandle;
+  char    Filename[vmFILENAMESIZE];
+  int     hFile;
+
+  *pHandle    =  -1;
+
+  if ((PrgId < MAX_PROGRAMS) && (Size > 0) && (Size <= MAX_ARRAY_SIZE))
+  {
+    TmpHandle   =  0;
+
+    while ((TmpHandle < MAX_HANDLES) && (MemoryInstance.pPoolList[PrgId][TmpHandle].pPool != NULL))
+    {
+      TmpHandle++;
+    }
+    if ((TmpHandle < MAX_HANDLES) && (snprintf(Filename,vmFILENAMESIZE,"%s/.arrayXXXXXX",MEMORY_FOLDER) < vmFILENAMESIZE))
+    {
+      hFile  =  mkstemp(Filename);
+      if (hFile >= MIN_HANDLE)
+      {
+        unlink(Filename);
+        *ppMemory  =  cMemoryMap(hFile,0,Size);
+        if (*ppMemory != NULL)
+        {
+          MemoryInstance.pPoolList[PrgId][TmpHandle].pPool  =  *ppMemory;
+          MemoryInstance.pPoolList[PrgId][TmpHandle].Type   =  POOL_TYPE_MAPPED;
+          MemoryInstance.pPoolList[PrgId][TmpHandle].Kind   =  MEMORY_KIND_MAPPED;
+          MemoryInstance.pPoolList[PrgId][TmpHandle].Size   =  Size;
+          cMemoryAccount(PrgId,MEMORY_KIND_MAPPED,0,Size);
+          MemoryInstance.pPoolList[PrgId][TmpHandle].hFile  =  hFile;
+          *pHandle  =  TmpHandle;
+          Result    =  OK;
+        }
+        else
+        {
+          close(hFile);
+        }
+      }
+    }
+  }
+#ifdef DEBUG
+  if (Result == OK)
+  {
+    printf("  cMemoryAllocMapped   %-8p S=%8lu P=%1u H=%1u\n",*ppMemory,(long unsigned int)Size,(unsigned int)PrgId,(unsigned int)TmpHandle);
+  }
+  else
+  {
+    printf("  cMemoryAllocMapped ERROR    - S=%8lu P=%1u\n",(long unsigned int)Size,(unsigned int)PrgId);
+  }
+#endif
+
+  return (Result);
+}
+
+
 void*     cMemoryReallocate(PRGID PrgId,HANDLER Handle,GBINDEX Size)
 {
   void    *pTmp;
@@ -211,11 +422,43 @@ void*     cMemoryReallocate(PRGID PrgId,HANDLER Handle,GBINDEX Size)
   pTmp  =  NULL;
   if ((PrgId < MAX_PROGRAMS) && (Handle >= 0) && (Handle < MAX_HANDLES))
   {
-    if ((Size > 0) && (Size <= MAX_ARRAY_SIZE))
+    if (MemoryInstance.pPoolList[PrgId][Handle].Type == POOL_TYPE_MAPPED)
+    {
+      if (MemoryInstance.pPoolList[PrgId][Handle].pPool != NULL)
+      {
+        munmap(MemoryInstance.pPoolList[PrgId][Handle].pPool,(size_t)MemoryInstance.pPoolList[PrgId][Handle].Size);
+        if ((Size > 0) && (Size <= MAX_ARRAY_SIZE))
+        {
+          pTmp  =  cMemoryMap(MemoryInstance.pPoolList[PrgId][Handle].hFile,MemoryInstance.pPoolList[PrgId][Handle].Size,Size);
+        }
+        if (pTmp != NULL)
+        {
+          cMemoryAccount(PrgId,MEMORY_KIND_MAPPED,MemoryInstance.pPoolList[PrgId][Handle].Size,Size);
+          MemoryInstance.pPoolList[PrgId][Handle].Size   =  Size;
+        }
+        else
+        {
+          close(MemoryInstance.pPoolList[PrgId][Handle].hFile);
+          cMemoryAccount(PrgId,MEMORY_KIND_MAPPED,MemoryInstance.pPoolList[PrgId][Handle].Size,0);
+          MemoryInstance.pPoolList[PrgId][Handle].Size   =  0;
+        }
+      }
+    }
+    else
     {
-      if (cMemoryRealloc(MemoryInstance.pPoolList[PrgId][Handle].pPool,&pTmp,(DATA32)Size) == OK)
+      if ((Size > 0) && (Size <= MAX_ARRAY_SIZE))
       {
-        MemoryInstance.pPoolList[PrgId][Handle].Size   =  Size;
+        if (cMemoryRealloc(MemoryInstance.pPoolList[PrgId][Handle].pPool,&pTmp,(DATA32)Size) == OK)
+        {
+          cMemoryAccount(PrgId,MemoryInstance.pPoolList[PrgId][Handle].Kind,MemoryInstance.pPoolList[PrgId][Handle].Size,Size);
+          MemoryInstance.pPoolList[PrgId][Handle].Size   =  Size;
+        }
+      }
+      if (pTmp == NULL)
+      { // Old pool is lost
+
+        cMemoryAccount(PrgId,MemoryInstance.pPoolList[PrgId][Handle].Kind,MemoryInstance.pPoolList[PrgId][Handle].Size,0);
+        MemoryInstance.pPoolList[PrgId][Handle].Size   =  0;
       }
     }
     MemoryInstance.pPoolList[PrgId][Handle].pPool  =  pTmp;
@@ -275,10 +518,124 @@ RESULT    cMemoryArraryPointer(PRGID PrgId,HANDLER Handle,void **pMemory)
 }
 
 
+/*
+ *  Durability
+ *
+ *  Files that have been written are flushed to storage (fdatasync) when they
+ *  are closed instead of flushing the whole system with sync(). If the file
+ *  was created by the open its folder is flushed as well so that the new
+ *  directory entry survives a power loss.
+ *
+ *  With ENABLE_DEFERRED_FLUSH the flush and close is handed to a background
+ *  thread so the VM does not wait for the storage. If the queue is full the
+ *  file is flushed right away. FLUSH waits for the queue to empty.
+ */
+void      cMemoryFlushFolder(char *pFolder)
+{
+  int     hFolder;
+
+  if (pFolder[0])
+  {
+    hFolder  =  open(pFolder,O_RDONLY | O_DIRECTORY);
+    if (hFolder >= 0)
+    {
+      fsync(hFolder);
+      close(hFolder);
+    }
+  }
+}
+
+
+void      cMemoryFlushAndClose(int hFile,char *pFolder)
+{
+  fdatasync(hFile);
+  close(hFile);
+  cMemoryFlushFolder(pFolder);
+}
+
+
+#ifdef ENABLE_DEFERRED_FLUSH
+
+void*     cMemoryFlushThread(void *pArg)
+{
+  FLUSHITEM Item;
+
+  pthread_mutex_lock(&MemoryInstance.FlushMutex);
+  while ((MemoryInstance.FlushRunning) || (MemoryInstance.FlushOut != MemoryInstance.FlushIn))
+  {
+    if (MemoryInstance.FlushOut == MemoryInstance.FlushIn)
+    {
+      pthread_cond_wait(&MemoryInstance.FlushCond,&MemoryInstance.FlushMutex);
+    }
+    else
+    {
+      Item  =  MemoryInstance.FlushQueue[MemoryInstance.FlushOut];
+      pthread_mutex_unlock(&MemoryInstance.FlushMutex);
+
+      cMemoryFlushAndClose(Item.hFile,Item.Folder);
+
+      pthread_mutex_lock(&MemoryInstance.FlushMutex);
+      MemoryInstance.FlushOut  =  (MemoryInstance.FlushOut + 1) % FLUSH_QUEUE_SIZE;
+    }
+  }
+  pthread_mutex_unlock(&MemoryInstance.FlushMutex);
+
+  return (NULL);
+}
+
+#endif
+
+
+void      cMemoryCloseWritten(int hFile,char *pFolder)
+{
+#ifdef ENABLE_DEFERRED_FLUSH
+  DATA16  In;
+
+  pthread_mutex_lock(&MemoryInstance.FlushMutex);
+  In  =  (MemoryInstance.FlushIn + 1) % FLUSH_QUEUE_SIZE;
+  if ((MemoryInstance.FlushRunning) && (In != MemoryInstance.FlushOut))
+  {
+    MemoryInstance.FlushQueue[MemoryInstance.FlushIn].hFile  =  hFile;
+    snprintf(MemoryInstance.FlushQueue[MemoryInstance.FlushIn].Folder,vmFILENAMESIZE,"%s",pFolder);
+    MemoryInstance.FlushIn  =  In;
+    pthread_cond_signal(&MemoryInstance.FlushCond);
+    hFile  =  -1;
+  }
+  pthread_mutex_unlock(&MemoryInstance.FlushMutex);
+
+  if (hFile >= 0)
+  { // Queue full - do it now
+
+    cMemoryFlushAndClose(hFile,pFolder);
+  }
+#else
+  cMemoryFlushAndClose(hFile,pFolder);
+#endif
+}
+
+
+DATA8     cMemoryFlushPending(void)
+{
+  DATA8   Result = 0;
+
+#ifdef ENABLE_DEFERRED_FLUSH
+  pthread_mutex_lock(&MemoryInstance.FlushMutex);
+  if (MemoryInstance.FlushOut != MemoryInstance.FlushIn)
+  {
+    Result  =  1;
+  }
+  pthread_mutex_unlock(&MemoryInstance.FlushMutex);
+#endif
+
+  return (Result);
+}
+
+
 DSPSTAT   cMemoryFreeHandle(PRGID PrgId,HANDLER Handle)
 {
   DSPSTAT Result = FAILBREAK;
   FDESCR  *pFDescr;
+  char    Folder[vmFILENAMESIZE];
 
   if ((PrgId < MAX_PROGRAMS) && (Handle >= 0) && (Handle < MAX_HANDLES))
   {
@@ -289,9 +646,27 @@ DSPSTAT   cMemoryFreeHandle(PRGID PrgId,HANDLER Handle)
         pFDescr  =  (FDESCR*)MemoryInstance.pPoolList[PrgId][Handle].pPool;
         if (((*pFDescr).Access))
         {
+          if ((*pFDescr).Access == OPEN_FOR_READ)
+          {
+            close((*pFDescr).hFile);
+          }
+          else
+          {
+            if ((*pFDescr).pLog != NULL)
+            { // Write what is left in the log buffers
+
+              cDatalogClose((*pFDescr).pLog);
+              (*pFDescr).pLog  =  NULL;
+              cMemoryAccount(PrgId,MEMORY_KIND_FILE,(GBINDEX)sizeof(DATALOG),0);
+            }
+            Folder[0]  =  0;
+            if ((*pFDescr).Created)
+            {
+              FindName((*pFDescr).Filename,Folder,NULL,NULL);
+            }
+            cMemoryCloseWritten((*pFDescr).hFile,Folder);
+          }
           (*pFDescr).Access  =  0;
-          close((*pFDescr).hFile);
-          sync();
           Result  =  NOBREAK;
         }
 #ifdef DEBUG
@@ -306,7 +681,16 @@ DSPSTAT   cMemoryFreeHandle(PRGID PrgId,HANDLER Handle)
 #ifdef DEBUG
       printf("  cMemoryFreeHandle    %-8p S=%8lu H=%1u\n",MemoryInstance.pPoolList[PrgId][Handle].pPool,(long unsigned int)MemoryInstance.pPoolList[PrgId][Handle].Size,Handle);
 #endif
-      cMemoryFree(MemoryInstance.pPoolList[PrgId][Handle].pPool);
+      if (MemoryInstance.pPoolList[PrgId][Handle].Type == POOL_TYPE_MAPPED)
+      {
+        munmap(MemoryInstance.pPoolList[PrgId][Handle].pPool,(size_t)MemoryInstance.pPoolList[PrgId][Handle].Size);
+        close(MemoryInstance.pPoolList[PrgId][Handle].hFile);
+      }
+      else
+      {
+        cMemoryFree(MemoryInstance.pPoolList[PrgId][Handle].pPool);
+      }
+      cMemoryAccount(PrgId,MemoryInstance.pPoolList[PrgId][Handle].Kind,MemoryInstance.pPoolList[PrgId][Handle].Size,0);
       MemoryInstance.pPoolList[PrgId][Handle].pPool  =  NULL;
       MemoryInstance.pPoolList[PrgId][Handle].Size   =  0;
 
@@ -336,6 +720,18 @@ void      cMemoryFreePool(PRGID PrgId,void *pMemory)
 void      cMemoryFreeProgram(PRGID PrgId)
 {
   HANDLER TmpHandle;
+#ifdef DEBUG_MEMORY_USAGE
+  DATA8   Kind;
+
+  if (MemoryInstance.Usage[PrgId][MEMORY_KIND_ALL].Peak)
+  {
+    printf("  Memory usage P=%1u   (current/peak bytes)\n",(unsigned int)PrgId);
+    for (Kind = 0;Kind <= MEMORY_KIND_ALL;Kind++)
+    {
+      printf("    %-8s %10ld %10ld\n",MemoryKindName[Kind],(long)MemoryInstance.Usage[PrgId][Kind].Current,(long)MemoryInstance.Usage[PrgId][Kind].Peak);
+    }
+  }
+#endif
 
   for (TmpHandle = 0;TmpHandle < MAX_HANDLES;TmpHandle++)
   {
@@ -399,6 +795,8 @@ RESULT    cMemoryInit(void)
 
   VMInstance.MemorySize     =  INSTALLED_MEMORY;
   VMInstance.MemoryFree     =  INSTALLED_MEMORY;
+  MemoryInstance.SpaceFree  =  INSTALLED_MEMORY;
+  MemoryInstance.SpaceUsed  =  0;
 
 #ifdef DEBUG_C_MEMORY_LOW
   DATA32  Total;
@@ -413,6 +811,23 @@ RESULT    cMemoryInit(void)
   MemoryInstance.SyncTime   =  (DATA32)0;
   MemoryInstance.SyncTick   =  (DATA32)0;
 
+  cDirCacheInit();
+  cMd5CacheInit();
+  cArchiveInit();
+  cImageCacheInit();
+
+#ifdef ENABLE_DEFERRED_FLUSH
+  pthread_mutex_init(&MemoryInstance.FlushMutex,NULL);
+  pthread_cond_init(&MemoryInstance.FlushCond,NULL);
+  MemoryInstance.FlushIn       =  0;
+  MemoryInstance.FlushOut      =  0;
+  MemoryInstance.FlushRunning  =  1;
+  if (pthread_create(&MemoryInstance.FlushThread,NULL,cMemoryFlushThread,NULL) != 0)
+  {
+    MemoryInstance.FlushRunning  =  0;
+  }
+#endif
+
   Result  =  OK;
 
   return (Result);
@@ -424,7 +839,10 @@ RESULT    cMemoryOpen(PRGID PrgId,GBINDEX Size,void **pMemory)
   RESULT  Result = FAIL;
   HANDLER TmpHandle;
 
-  Result  =  cMemoryAlloc(PrgId,POOL_TYPE_MEMORY,Size,pMemory,&TmpHandle);
+  // New program - start usage from scratch
+  memset(MemoryInstance.Usage[PrgId],0,sizeof(MemoryInstance.Usage[PrgId]));
+
+  Result  =  cMemoryAlloc(PrgId,POOL_TYPE_MEMORY,MEMORY_KIND_PROGRAM,Size,pMemory,&TmpHandle);
 
   return (Result);
 }
@@ -435,6 +853,8 @@ RESULT    cMemoryClose(PRGID PrgId)
   RESULT  Result = FAIL;
 
   cMemoryFreeProgram(PrgId);
+  cArchiveClose(PrgId);
+  cMd5CacheSave();
   Result  =  OK;
 
   return (Result);
@@ -447,6 +867,23 @@ RESULT    cMemoryExit(void)
   int     File;
   char    PrgNameBuf[vmFILENAMESIZE];
 
+#ifdef ENABLE_DEFERRED_FLUSH
+  if (MemoryInstance.FlushRunning)
+  { // Let the thread empty the queue and stop
+
+    pthread_mutex_lock(&MemoryInstance.FlushMutex);
+    MemoryInstance.FlushRunning  =  0;
+    pthread_cond_signal(&MemoryInstance.FlushCond);
+    pthread_mutex_unlock(&MemoryInstance.FlushMutex);
+    pthread_join(MemoryInstance.FlushThread,NULL);
+  }
+#endif
+
+  cArchiveExit();
+  cDirCacheExit();
+  cMd5CacheExit();
+  cImageCacheExit();
+
   snprintf(PrgNameBuf,vmFILENAMESIZE,"%s/%s%s",vmSETTINGS_DIR,vmLASTRUN_FILE_NAME,vmEXT_CONFIG);
   File  =  open(PrgNameBuf,O_CREAT | O_WRONLY | O_TRUNC,FILEPERMISSIONS);
   if (File >= MIN_HANDLE)
@@ -755,13 +1192,17 @@ int       cMemorySort(void *ppFirst,void *ppSecond)
 
 DATA8     cMemoryFindSubFolders(char *pFolderName)
 {
+  DIRCACHEITEM *pList;
   struct  dirent **NameList;
   int     Items;
   DATA8   Folders = 0;
 
-  Items     =  scandir(pFolderName,&NameList,0,(int (*)(const struct dirent **,const struct dirent **))cMemorySort);
-  if (Items >= 0)
+  pList     =  cDirCacheGetList(pFolderName);
+  if (pList != NULL)
   {
+    NameList  =  (*pList).pNameList;
+    Items     =  (*pList).Items;
+
     while (Items--)
     {
       if ((*NameList[Items]).d_name[0] != '.')
@@ -771,9 +1212,7 @@ DATA8     cMemoryFindSubFolders(char *pFolderName)
           Folders++;
         }
       }
-      free(NameList[Items]);
     }
-    free(NameList);
   }
 
   return (Folders);
@@ -841,6 +1280,7 @@ DATA8     cMemoryFindType(char *pExt)
 DATA8     cMemoryGetSubFolderName(DATA8 Item,DATA8 MaxLength,char *pFolderName,char *pSubFolderName)
 {
   DATA8   Filetype = 0;
+  DIRCACHEITEM *pList;
   struct  dirent **NameList;
   int     Items;
   int     Tmp;
@@ -848,12 +1288,15 @@ DATA8     cMemoryGetSubFolderName(DATA8 Item,DATA8 MaxLength,char *pFolderName,c
   DATA8   Folders = 0;
 
   pSubFolderName[0]  =  0;
-  Items     =  scandir(pFolderName,&NameList,0,(int (*)(const struct dirent **,const struct dirent **))cMemorySort);
+  pList     =  cDirCacheGetList(pFolderName);
   Tmp       =  0;
 
-  if (Items >= 0)
+  if (pList != NULL)
   {
-    while (Tmp < Items)
+    NameList  =  (*pList).pNameList;
+    Items     =  (*pList).Items;
+
+    while ((Tmp < Items) && (Item != Folders))
     {
       if ((*NameList[Tmp]).d_name[0] != '.')
       {
@@ -871,9 +1314,8 @@ DATA8     cMemoryGetSubFolderName(DATA8 Item,DATA8 MaxLength,char *pFolderName,c
             {
               Filetype  =  cMemoryFindType(&(*NameList[Tmp]).d_name[Char]);
 
-              // delete extension
-              (*NameList[Tmp]).d_name[Char]  =  0;
-              snprintf((char*)pSubFolderName,(int)MaxLength,"%s",(*NameList[Tmp]).d_name);
+              // copy without extension (list is shared with the cache)
+              snprintf((char*)pSubFolderName,(int)MaxLength,"%.*s",(int)Char,(*NameList[Tmp]).d_name);
             }
             else
             { // must be a folder or file without extension
@@ -883,10 +1325,8 @@ DATA8     cMemoryGetSubFolderName(DATA8 Item,DATA8 MaxLength,char *pFolderName,c
           }
         }
       }
-      free(NameList[Tmp]);
       Tmp++;
     }
-    free(NameList);
   }
 
   return (Filetype);
@@ -935,27 +1375,16 @@ void      cMemoryDeleteSubFolders(char *pFolderName)
 
 DATA32    cMemoryFindSize(char *pFolderName,DATA32 *pFiles)
 {
-  struct  dirent **NameList;
-  struct  stat Status;
-  int     Items;
+  DIRCACHEITEM *pList;
   DATA32  Size = 0;
 
   *pFiles  =  0;
-  if (stat(pFolderName,&Status) == 0)
+  if (cDirCacheGetSize(pFolderName,&Size) == OK)
   {
-    Size +=  (DATA32)Status.st_size;
-    Items     =  scandir(pFolderName,&NameList,0,(int (*)(const struct dirent **,const struct dirent **))cMemorySort);
-    if (Items >= 0)
+    pList  =  cDirCacheGetList(pFolderName);
+    if (pList != NULL)
     {
-      *pFiles  =  (DATA32)Items;
-
-      while (Items--)
-      {
-        stat((*NameList[Items]).d_name,&Status);
-        Size +=  (DATA32)Status.st_size;
-        free(NameList[Items]);
-      }
-      free(NameList);
+      *pFiles  =  (DATA32)(*pList).Items;
     }
   }
   Size  =  (Size + (KB - 1)) / KB;
@@ -1022,13 +1451,17 @@ DATA8     cMemoryGetCacheFiles(void)
 
 DATA8     cMemoryFindFiles(char *pFolderName)
 {
+  DIRCACHEITEM *pList;
   struct  dirent **NameList;
   int     Items;
   DATA8   Files = 0;
 
-  Items     =  scandir(pFolderName,&NameList,0,alphasort);
-  if (Items >= 0)
+  pList     =  cDirCacheGetList(pFolderName);
+  if (pList != NULL)
   {
+    NameList  =  (*pList).pNameList;
+    Items     =  (*pList).Items;
+
     while (Items--)
     {
       if ((*NameList[Items]).d_name[0] != '.')
@@ -1038,9 +1471,7 @@ DATA8     cMemoryFindFiles(char *pFolderName)
           Files++;
         }
       }
-      free(NameList[Items]);
     }
-    free(NameList);
   }
 
   return (Files);
@@ -1063,7 +1494,7 @@ RESULT    cMemoryGetIcon(DATA8 *pFolderName,DATA8 Item,DATA32 *pImagePointer)
   PRGID   TmpPrgId;
   char    PrgNamePath[SUBFOLDERNAME_SIZE];
   char    PrgNameBuf[MAX_FILENAME_SIZE];
-  LFILE    *pFile;
+  UBYTE   *pCached;
 
   TmpPrgId      =  CurrentProgramId();
 
@@ -1073,23 +1504,15 @@ RESULT    cMemoryGetIcon(DATA8 *pFolderName,DATA8 Item,DATA32 *pImagePointer)
   {
     snprintf(PrgNameBuf,MAX_FILENAME_SIZE,"%s%s/icon%s",(char*)pFolderName,PrgNamePath,EXT_GRAPHICS);
 
-    pFile = fopen (PrgNameBuf, "rb");
-    if (NULL != pFile)
+    if (cImageCacheGet(PrgNameBuf,&pCached,&ISize) == OK)
     {
-      fseek (pFile , 0 , SEEK_END);
-      ISize = ftell (pFile);
-      rewind (pFile);
-
       // allocate memory to contain the whole file:
-      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,(GBINDEX)ISize,(void**)&pImage,&TmpHandle) == OK)
+      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,MEMORY_KIND_IMAGE,(GBINDEX)ISize,(void**)&pImage,&TmpHandle) == OK)
       {
-        if (ISize == fread(pImage,1,ISize,pFile))
-        {
-          *pImagePointer  =  (DATA32)pImage;
-          Result  =  OK;
-        }
+        memcpy(pImage,pCached,(size_t)ISize);
+        *pImagePointer  =  (DATA32)pImage;
+        Result  =  OK;
       }
-      fclose (pFile);
     }
   }
 
@@ -1198,10 +1621,16 @@ DSPSTAT   cMemoryOpenFile(PRGID PrgId,DATA8 Access,char *pFileName,HANDLER *pHan
   FDESCR  *pFDescr;
   struct  stat FileStatus;
   int     hFile  = -1;
+  DATA8   Created = 0;
 
   *pHandle  =  0;
   *pSize    =  0;
 
+  if ((Access != OPEN_FOR_READ) && (access(pFileName,F_OK) != 0))
+  {
+    Created  =  1;
+  }
+
   switch (Access)
   {
     case OPEN_FOR_WRITE :
@@ -1248,10 +1677,14 @@ DSPSTAT   cMemoryOpenFile(PRGID PrgId,DATA8 Access,char *pFileName,HANDLER *pHan
 
   if (hFile >= MIN_HANDLE)
   {
-    if (cMemoryAlloc(PrgId,POOL_TYPE_FILE,(GBINDEX)sizeof(FDESCR),(void**)&pFDescr,pHandle) == OK)
+    if (cMemoryAlloc(PrgId,POOL_TYPE_FILE,MEMORY_KIND_FILE,(GBINDEX)sizeof(FDESCR),(void**)&pFDescr,pHandle) == OK)
     {
-      (*pFDescr).hFile    =  hFile;
-      (*pFDescr).Access   =  Access;
+      (*pFDescr).hFile        =  hFile;
+      (*pFDescr).Access       =  Access;
+      (*pFDescr).Created      =  Created;
+      (*pFDescr).ReadPointer  =  0;
+      (*pFDescr).ReadBytes    =  0;
+      (*pFDescr).pLog         =  NULL;
       snprintf((*pFDescr).Filename,MAX_FILENAME_SIZE,"%s",pFileName);
 
       stat(pFileName,&FileStatus);
@@ -1278,14 +1711,17 @@ DSPSTAT   cMemoryWriteFile(PRGID PrgId,HANDLER Handle,DATA32 Size,DATA8 Del,DATA
 {
   DSPSTAT Result = FAILBREAK;
   FDESCR  *pFDescr;
-  DATA32  Free;
+  DATA32  DelSize = 0;
 
   if (cMemoryGetPointer(PrgId,Handle,(void**)&pFDescr) == OK)
   {
     if (((*pFDescr).Access == OPEN_FOR_WRITE) || ((*pFDescr).Access == OPEN_FOR_APPEND) || ((*pFDescr).Access == OPEN_FOR_LOG))
     {
-      cMemoryGetUsage(NULL,&Free,1);
-      if (((Size + (KB - 1)) / KB) <= Free)
+      if ((Del < DELS) && (Del != DEL_NONE))
+      {
+        DelSize  =  strlen(Delimiter[Del]);
+      }
+      if (cMemoryReserveSpace(Size + DelSize) == OK)
       {
         if (write((*pFDescr).hFile,pSource,Size) == Size)
         {
@@ -1296,8 +1732,7 @@ DSPSTAT   cMemoryWriteFile(PRGID PrgId,HANDLER Handle,DATA32 Size,DATA8 Del,DATA
           {
             if (Del != DEL_NONE)
             {
-              Size  =  strlen(Delimiter[Del]);
-              if (write((*pFDescr).hFile,Delimiter[Del],Size) == Size)
+              if (write((*pFDescr).hFile,Delimiter[Del],DelSize) == DelSize)
               {
                 Result  =  NOBREAK;
               }
@@ -1308,6 +1743,11 @@ DSPSTAT   cMemoryWriteFile(PRGID PrgId,HANDLER Handle,DATA32 Size,DATA8 Del,DATA
             }
           }
         }
+        if ((Result == FAILBREAK) && (errno == ENOSPC))
+        { // Accounting was too optimistic - get real figures
+
+          cMemoryGetUsage(NULL,NULL,1);
+        }
       }
     }
   }
@@ -1321,13 +1761,45 @@ DSPSTAT   cMemoryWriteFile(PRGID PrgId,HANDLER Handle,DATA32 Size,DATA8 Del,DATA
 }
 
 
+/*
+ *  Files opened for read are read ahead into a buffer in the file descriptor
+ *  so that scanning for delimiters does not need a system call per byte.
+ *  The file offset in the kernel is therefore ahead of what the program has
+ *  consumed - anything reading the file handle directly must use up what is
+ *  left in the buffer first (handles opened for read are never written or
+ *  seeked).
+ */
+DATA32    cMemoryFillReadBuffer(FDESCR *pFDescr)
+{
+  ssize_t No;
+
+  if ((*pFDescr).ReadPointer >= (*pFDescr).ReadBytes)
+  {
+    (*pFDescr).ReadPointer  =  0;
+    (*pFDescr).ReadBytes    =  0;
+
+    No  =  read((*pFDescr).hFile,(*pFDescr).ReadBuffer,FILE_READ_BUFFER_SIZE);
+    if (No > 0)
+    {
+      (*pFDescr).ReadBytes  =  (DATA32)No;
+    }
+  }
+
+  return ((*pFDescr).ReadBytes - (*pFDescr).ReadPointer);
+}
+
+
 DSPSTAT   cMemoryReadFile(PRGID PrgId,HANDLER Handle,DATA32 Size,DATA8 Del,DATA8 *pDestination)
 {
   DSPSTAT Result = FAILBREAK;
   FDESCR  *pFDescr;
-  DATA8   No;
-  DATA8   Tmp;
-  DATA8   Last;
+  UBYTE   *pStart;
+  UBYTE   *pFound;
+  DATA32  Bytes;
+  DATA32  Offset;
+  ssize_t No;
+  DATA8   Found;
+  UBYTE   Last;
 
   if (cMemoryGetPointer(PrgId,Handle,(void**)&pFDescr) == OK)
   {
@@ -1345,55 +1817,539 @@ DSPSTAT   cMemoryReadFile(PRGID PrgId,HANDLER Handle,DATA32 Size,DATA8 Del,DATA8
             pDestination  =  (DATA8*)VmMemoryResize(VMInstance.Handle,Size);
           }
         }
-        No    =  1;
-        Last  =  0;
-        while ((No == 1) && (Size > 0))
+        if (Del >= DELS)
         {
-          No  =  (DATA8)read((*pFDescr).hFile,&Tmp,1);
+          Del  =  DEL_NONE;
+        }
+        Found  =  0;
+        Last   =  0;
+        while ((!Found) && (Size > 0))
+        {
+          if ((Del == DEL_NONE) && ((*pFDescr).ReadPointer >= (*pFDescr).ReadBytes) && (Size >= FILE_READ_BUFFER_SIZE))
+          { // Large binary read - bypass the buffer
 
-          if (Del < DELS)
+            No  =  read((*pFDescr).hFile,pDestination,(size_t)Size);
+            if (No <= 0)
+            {
+              break;
+            }
+            pDestination +=  No;
+            Size         -=  (DATA32)No;
+          }
+          else
           {
+            Bytes  =  cMemoryFillReadBuffer(pFDescr);
+            if (Bytes == 0)
+            { // End of file
+
+              break;
+            }
+            if (Bytes > Size)
+            {
+              Bytes  =  Size;
+            }
+            pStart  =  &(*pFDescr).ReadBuffer[(*pFDescr).ReadPointer];
+
             if (Del != DEL_NONE)
             {
               if (Del != DEL_CRLF)
               {
-                if (Tmp == Delimiter[Del][0])
+                pFound  =  (UBYTE*)memchr(pStart,Delimiter[Del][0],(size_t)Bytes);
+                if (pFound != NULL)
                 {
-                  No  =  0;
+                  Bytes  =  (DATA32)(pFound - pStart);
+                  Found  =  1;
                 }
               }
               else
-              {
-                if ((Tmp == Delimiter[Del][1]) && (Last == Delimiter[Del][0]))
+              { // Only a line feed right after a carriage return terminates - the carriage return is kept
+
+                Offset  =  0;
+                while ((!Found) && (Offset < Bytes))
                 {
-                  No  =  0;
+                  pFound  =  (UBYTE*)memchr(&pStart[Offset],Delimiter[Del][1],(size_t)(Bytes - Offset));
+                  if (pFound == NULL)
+                  {
+                    Offset  =  Bytes;
+                  }
+                  else
+                  {
+                    Offset  =  (DATA32)(pFound - pStart);
+                    if (((Offset > 0) && (pStart[Offset - 1] == Delimiter[Del][0])) || ((Offset == 0) && (Last == Delimiter[Del][0])))
+                    {
+                      Bytes  =  Offset;
+                      Found  =  1;
+                    }
+                    else
+                    {
+                      Offset++;
+                    }
+                  }
                 }
-                Last  =  Tmp;
               }
             }
-          }
 
-          if (No)
-          {
-            *pDestination  =  Tmp;
-            pDestination++;
-            Size--;
+            memcpy(pDestination,pStart,(size_t)Bytes);
+            if (Bytes > 0)
+            {
+              Last  =  pStart[Bytes - 1];
+            }
+            pDestination              +=  Bytes;
+            Size                      -=  Bytes;
+            (*pFDescr).ReadPointer    +=  Bytes;
+
+            if (Found)
+            { // Consume delimiter
+
+              ((*pFDescr).ReadPointer)++;
+            }
           }
         }
         if (Size)
         {
           *pDestination  =  0;
         }
-
-        Result  =  NOBREAK;
+
+        Result  =  NOBREAK;
+      }
+    }
+  }
+
+  if (Result == FAILBREAK)
+  {
+    LogErrorNumber(FILE_READ_ERROR);
+  }
+
+  return (Result);
+}
+
+
+/*
+ *  Array file I/O
+ *
+ *  Array elements are read and written as they are kept in memory (little
+ *  endian on the brick) without any conversion. Reads go straight from the
+ *  file into the array - only bytes already in the read buffer are copied.
+ */
+static DESCR* cMemoryGetArray(PRGID PrgId,HANDLER Handle,DATA32 Index,DATA32 Elements,DATA8 Grow)
+{
+  DESCR   *pDescr = NULL;
+
+  if ((cMemoryGetPointer(PrgId,Handle,(void**)&pDescr) == OK) && (MemoryInstance.pPoolList[PrgId][Handle].Type != POOL_TYPE_FILE))
+  {
+    if (((*pDescr).ElementSize > 0) && (Index >= 0) && (Elements >= 0) && (Index <= MAX_ARRAY_SIZE) && (Elements <= MAX_ARRAY_SIZE) && ((Index + Elements) <= (MAX_ARRAY_SIZE / (*pDescr).ElementSize)))
+    {
+      if ((Index + Elements) > (*pDescr).Elements)
+      {
+        if ((!Grow) || (cMemoryResize(PrgId,Handle,Index + Elements) == NULL))
+        {
+          pDescr  =  NULL;
+        }
+        else
+        {
+          cMemoryGetPointer(PrgId,Handle,(void**)&pDescr);
+        }
+      }
+    }
+    else
+    {
+      pDescr  =  NULL;
+    }
+  }
+
+  return (pDescr);
+}
+
+
+DSPSTAT   cMemoryReadArray(PRGID PrgId,HANDLER Handle,HANDLER hArray,DATA32 Index,DATA32 Elements,DATA32 *pElements)
+{
+  DSPSTAT Result = FAILBREAK;
+  FDESCR  *pFDescr;
+  DESCR   *pDescr;
+  UBYTE   *pDestination;
+  DATA32  Size;
+  DATA32  Done = 0;
+  DATA32  Bytes;
+  ssize_t No;
+
+  *pElements  =  0;
+  if ((cMemoryGetPointer(PrgId,Handle,(void**)&pFDescr) == OK) && (MemoryInstance.pPoolList[PrgId][Handle].Type == POOL_TYPE_FILE))
+  {
+    if ((*pFDescr).Access == OPEN_FOR_READ)
+    {
+      pDescr  =  cMemoryGetArray(PrgId,hArray,Index,Elements,1);
+      if (pDescr != NULL)
+      {
+        pDestination  =  (UBYTE*)&(*pDescr).pArray[Index * (*pDescr).ElementSize];
+        Size          =  Elements * (*pDescr).ElementSize;
+
+        // Bytes already read into the buffer first
+        Bytes  =  (*pFDescr).ReadBytes - (*pFDescr).ReadPointer;
+        if (Bytes > Size)
+        {
+          Bytes  =  Size;
+        }
+        memcpy(pDestination,&(*pFDescr).ReadBuffer[(*pFDescr).ReadPointer],(size_t)Bytes);
+        (*pFDescr).ReadPointer +=  Bytes;
+        Done                    =  Bytes;
+
+        while (Done < Size)
+        {
+          No  =  read((*pFDescr).hFile,&pDestination[Done],(size_t)(Size - Done));
+          if (No <= 0)
+          {
+            break;
+          }
+          Done +=  (DATA32)No;
+        }
+
+        // Leave a partial element at the end of the file unread
+        Bytes  =  Done % (*pDescr).ElementSize;
+        if (Bytes)
+        {
+          lseek((*pFDescr).hFile,-(off_t)Bytes,SEEK_CUR);
+          Done -=  Bytes;
+        }
+        *pElements  =  Done / (*pDescr).ElementSize;
+        Result      =  NOBREAK;
+#ifdef DEBUG_C_MEMORY_FILE
+        printf("Read array %-2d   %5d %s [%d]\n",hArray,(*pFDescr).hFile,(*pFDescr).Filename,*pElements);
+#endif
+      }
+    }
+  }
+
+  if (Result == FAILBREAK)
+  {
+    LogErrorNumber(FILE_READ_ERROR);
+  }
+
+  return (Result);
+}
+
+
+DSPSTAT   cMemoryWriteArray(PRGID PrgId,HANDLER Handle,HANDLER hArray,DATA32 Index,DATA32 Elements)
+{
+  DSPSTAT Result = FAILBREAK;
+  DESCR   *pDescr;
+
+  pDescr  =  cMemoryGetArray(PrgId,hArray,Index,Elements,0);
+  if (pDescr != NULL)
+  {
+    Result  =  cMemoryWriteFile(PrgId,Handle,Elements * (*pDescr).ElementSize,DEL_NONE,&(*pDescr).pArray[Index * (*pDescr).ElementSize]);
+  }
+  else
+  {
+    LogErrorNumber(FILE_WRITE_ERROR);
+  }
+
+  return (Result);
+}
+
+
+/*
+ *  Delimited text to array
+ *
+ *  A text file with one row per line and values separated by a delimiter
+ *  (CSV) is parsed in one pass through the read buffer. Values are parsed
+ *  without sscanf: an optional sign, digits, and for DATAF arrays a decimal
+ *  point and an exponent. Cells that can not be parsed or are missing are
+ *  stored as NAN and the line of the first one is reported.
+ */
+#define   TABLE_FIELD_SIZE      32                    // Max characters in one value
+
+static const double PowerOf10[] =
+{
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+static RESULT cMemoryParseValue(char *pField,DATA8 Type,void *pValue)
+{
+  RESULT  Result = FAIL;
+  DATA8   Negative = 0;
+  DATA8   Digits = 0;
+  DATA8   ExpNegative = 0;
+  DATA8   Overflow = 0;
+  DATA32  Exponent = 0;
+  DATA32  Scale = 0;
+  ULONG   Integer = 0;
+  double  Value = 0.0;
+
+  if ((*pField == '-') || (*pField == '+'))
+  {
+    Negative  =  (*pField == '-') ? 1 : 0;
+    pField++;
+  }
+  while ((*pField >= '0') && (*pField <= '9'))
+  {
+    if (Integer > (((ULONG)DATA32_MAX - (ULONG)(*pField - '0')) / 10))
+    { // Checked before multiplying - ULONG would wrap
+
+      Overflow  =  1;
+    }
+    else
+    {
+      Integer  =  Integer * 10 + (ULONG)(*pField - '0');
+    }
+    Value  =  Value * 10.0 + (double)(*pField - '0');
+    Digits++;
+    pField++;
+  }
+  if (Type == DATA_F)
+  {
+    if (*pField == '.')
+    {
+      pField++;
+      while ((*pField >= '0') && (*pField <= '9'))
+      {
+        Value  =  Value * 10.0 + (double)(*pField - '0');
+        Scale--;
+        Digits++;
+        pField++;
+      }
+    }
+    if ((Digits) && ((*pField == 'e') || (*pField == 'E')))
+    {
+      pField++;
+      if ((*pField == '-') || (*pField == '+'))
+      {
+        ExpNegative  =  (*pField == '-') ? 1 : 0;
+        pField++;
+      }
+      if ((*pField < '0') || (*pField > '9'))
+      {
+        Digits  =  0;
+      }
+      while ((*pField >= '0') && (*pField <= '9'))
+      {
+        if (Exponent < 1000)
+        {
+          Exponent  =  Exponent * 10 + (DATA32)(*pField - '0');
+        }
+        pField++;
+      }
+      Scale +=  (ExpNegative) ? -Exponent : Exponent;
+    }
+  }
+  while (*pField == ' ')
+  {
+    pField++;
+  }
+
+  if ((Digits) && (*pField == 0))
+  {
+    if (Type == DATA_F)
+    {
+      while (Scale < -22)
+      {
+        Value /=  PowerOf10[22];
+        Scale +=  22;
+      }
+      while (Scale > 22)
+      {
+        Value *=  PowerOf10[22];
+        Scale -=  22;
+      }
+      Value  =  (Scale < 0) ? (Value / PowerOf10[-Scale]) : (Value * PowerOf10[Scale]);
+      if (Value <= (double)DATAF_MAX)
+      {
+        *(DATAF*)pValue  =  (DATAF)((Negative) ? -Value : Value);
+        Result  =  OK;
+      }
+    }
+    else
+    {
+      if (!Overflow)
+      {
+        *(DATA32*)pValue  =  (Negative) ? -(DATA32)Integer : (DATA32)Integer;
+        Result  =  OK;
+      }
+    }
+  }
+
+  return (Result);
+}
+
+
+static RESULT cMemoryTableStore(PRGID PrgId,HANDLER hArray,DATA32 Index,char *pField,DATA8 *pBad)
+{
+  RESULT  Result = OK;
+  DESCR   *pDescr;
+  DATA32  Elements;
+
+  cMemoryGetPointer(PrgId,hArray,(void**)&pDescr);
+  if (Index >= (*pDescr).Elements)
+  { // Grow array in steps
+
+    Elements  =  (*pDescr).Elements * 2;
+    if ((Elements <= Index) || (Elements > (MAX_ARRAY_SIZE / (*pDescr).ElementSize)))
+    {
+      Elements  =  Index + 1;
+    }
+    Result  =  FAIL;
+    if (cMemoryResize(PrgId,hArray,Elements) != NULL)
+    {
+      cMemoryGetPointer(PrgId,hArray,(void**)&pDescr);
+      Result  =  OK;
+    }
+  }
+
+  if (Result == OK)
+  {
+    if ((*pDescr).Type == DATA_F)
+    {
+      if ((pField == NULL) || (cMemoryParseValue(pField,DATA_F,&((DATAF*)(*pDescr).pArray)[Index]) != OK))
+      {
+        ((DATAF*)(*pDescr).pArray)[Index]  =  DATAF_NAN;
+        *pBad   =  1;
+      }
+    }
+    else
+    {
+      if ((pField == NULL) || (cMemoryParseValue(pField,DATA_32,&((DATA32*)(*pDescr).pArray)[Index]) != OK))
+      {
+        ((DATA32*)(*pDescr).pArray)[Index]  =  DATA32_NAN;
+        *pBad   =  1;
+      }
+    }
+  }
+
+  return (Result);
+}
+
+
+/*! \brief    Parse delimited text file into array
+ *
+ *  Columns FIRST .. FIRST + COLUMNS - 1 (0 = first column) of every line are
+ *  stored row by row in a DATAF or DATA32 array that is sized to fit. Empty
+ *  lines are skipped.
+ *
+ *  \return   NOBREAK or FAILBREAK (handle, array or delimiter not valid or out of memory)
+ */
+DSPSTAT   cMemoryReadTable(PRGID PrgId,HANDLER Handle,DATA8 Del,DATA8 First,DATA8 Columns,HANDLER hArray,DATA32 *pRows,DATA32 *pError)
+{
+  DSPSTAT Result = FAILBREAK;
+  RESULT  Stored = OK;
+  FDESCR  *pFDescr;
+  DESCR   *pDescr;
+  char    Field[TABLE_FIELD_SIZE];
+  char    Separator;
+  DATA8   Length = 0;
+  DATA8   Overflow = 0;
+  DATA8   Started = 0;
+  DATA8   Last = 0;
+  DATA8   Bad = 0;
+  DATA16  Column = 0;
+  DATA32  Line = 1;
+  DATA32  Rows = 0;
+  DATA32  Bytes;
+  UBYTE   Char;
+
+  *pRows   =  0;
+  *pError  =  0;
+
+  if ((cMemoryGetPointer(PrgId,Handle,(void**)&pFDescr) == OK) && (MemoryInstance.pPoolList[PrgId][Handle].Type == POOL_TYPE_FILE) && ((*pFDescr).Access == OPEN_FOR_READ))
+  {
+    if ((cMemoryGetPointer(PrgId,hArray,(void**)&pDescr) == OK) && (MemoryInstance.pPoolList[PrgId][hArray].Type != POOL_TYPE_FILE) && (((*pDescr).Type == DATA_F) || ((*pDescr).Type == DATA_32)))
+    {
+      if (((Del == DEL_TAB) || (Del == DEL_SPACE) || (Del == DEL_COLON) || (Del == DEL_COMMA)) && (First >= 0) && (Columns > 0))
+      {
+        Separator  =  Delimiter[Del][0];
+        Result     =  NOBREAK;
+      }
+    }
+  }
+
+  while ((Result == NOBREAK) && (Stored != FAIL) && (!Last))
+  {
+    Bytes  =  cMemoryFillReadBuffer(pFDescr);
+    if (Bytes == 0)
+    { // End of file ends last line
+
+      Last   =  1;
+      Bytes  =  1;
+    }
+    while ((Bytes > 0) && (Stored != FAIL))
+    {
+      Char  =  (Last) ? '\n' : (*pFDescr).ReadBuffer[(*pFDescr).ReadPointer++];
+      Bytes--;
+
+      if ((Char == (UBYTE)Separator) && (Separator == ' ') && (Length == 0))
+      { // Runs of spaces are one delimiter
+      }
+      else
+      {
+        if ((Char == (UBYTE)Separator) || ((Char == '\n') && (Started)))
+        { // End of value
+
+          if ((Column >= First) && (Column < (First + Columns)))
+          {
+            Field[Length]  =  0;
+            Stored  =  cMemoryTableStore(PrgId,hArray,Rows * Columns + (Column - First),(Overflow) ? NULL : Field,&Bad);
+          }
+          Column++;
+          Length    =  0;
+          Overflow  =  0;
+        }
+        if (Char == '\n')
+        {
+          if (Started)
+          { // End of row - missing values are errors
+
+            while ((Column < (First + Columns)) && (Stored != FAIL))
+            {
+              if (Column >= First)
+              {
+                Stored  =  cMemoryTableStore(PrgId,hArray,Rows * Columns + (Column - First),NULL,&Bad);
+              }
+              Column++;
+            }
+            Rows++;
+          }
+          if ((Bad) && (*pError == 0))
+          {
+            *pError  =  Line;
+          }
+          Bad      =  0;
+          Line++;
+          Column   =  0;
+          Started  =  0;
+        }
+        else
+        {
+          if ((Char != (UBYTE)Separator) && (Char != '\r') && (!((Char == ' ') && (Length == 0))))
+          {
+            if (Length < (TABLE_FIELD_SIZE - 1))
+            {
+              Field[Length++]  =  (char)Char;
+            }
+            else
+            {
+              Overflow  =  1;
+            }
+          }
+          if (Char != '\r')
+          {
+            Started  =  1;
+          }
+        }
       }
     }
   }
 
-  if (Result == FAILBREAK)
+  if (Result == NOBREAK)
   {
-    LogErrorNumber(FILE_READ_ERROR);
+    if ((Stored == FAIL) || (cMemoryResize(PrgId,hArray,Rows * Columns) == NULL))
+    {
+      Result  =  FAILBREAK;
+    }
+    *pRows  =  Rows;
   }
+#ifdef DEBUG_C_MEMORY_FILE
+  printf("Read table %-2d   R=%d E=%d\n",hArray,*pRows,*pError);
+#endif
 
   return (Result);
 }
@@ -1430,6 +2386,47 @@ DSPSTAT   cMemoryCloseFile(PRGID PrgId,HANDLER Handle)
 }
 
 
+DSPSTAT   cMemoryFlushFile(PRGID PrgId,HANDLER Handle)
+{
+  DSPSTAT Result = NOBREAK;
+  FDESCR  *pFDescr;
+  char    Folder[vmFILENAMESIZE];
+
+  if (cMemoryFlushPending())
+  { // Wait for files closed earlier
+
+    Result  =  BUSYBREAK;
+  }
+  else
+  {
+    if ((PrgId < MAX_PROGRAMS) && (Handle >= 0) && (Handle < MAX_HANDLES))
+    {
+      if (MemoryInstance.pPoolList[PrgId][Handle].Type == POOL_TYPE_FILE)
+      {
+        if (cMemoryGetPointer(PrgId,Handle,(void**)&pFDescr) == OK)
+        {
+          if (((*pFDescr).Access) && ((*pFDescr).Access != OPEN_FOR_READ))
+          {
+            fdatasync((*pFDescr).hFile);
+            if ((*pFDescr).Created)
+            {
+              FindName((*pFDescr).Filename,Folder,NULL,NULL);
+              cMemoryFlushFolder(Folder);
+              (*pFDescr).Created  =  0;
+            }
+#ifdef DEBUG_C_MEMORY_FILE
+            printf("Flush file %-2d    %5d %s\n",Handle,(*pFDescr).hFile,(*pFDescr).Filename);
+#endif
+          }
+        }
+      }
+    }
+  }
+
+  return (Result);
+}
+
+
 void      cMemoryFindLogName(PRGID PrgId,char* pName)
 {
   HANDLER TmpHandle;
@@ -1462,18 +2459,17 @@ RESULT    cMemoryGetImage(DATA8 *pFileName,DATA16 Size,UBYTE *pBmp)
 {
   RESULT  Result = FAIL;
   PRGID   TmpPrgId;
-  int     File;
   char    FilenameBuf[MAX_FILENAME_SIZE];
+  UBYTE   *pCached;
+  DATA32  ISize;
 
   TmpPrgId  =  CurrentProgramId();
 
   if (ConstructFilename(TmpPrgId,(char*)pFileName,FilenameBuf,EXT_GRAPHICS) == OK)
   {
-    File      =  open(FilenameBuf,O_RDONLY);
-    if (File >= MIN_HANDLE)
+    if (cImageCacheGet(FilenameBuf,&pCached,&ISize) == OK)
     {
-      read(File,pBmp,(size_t)Size);
-      close(File);
+      memcpy(pBmp,pCached,(size_t)((ISize < (DATA32)Size) ? ISize : (DATA32)Size));
       Result  =  OK;
     }
   }
@@ -1519,17 +2515,28 @@ RESULT    cMemoryGetMediaName(char *pChar,char *pName)
 
 typedef   struct
 {
-  DIR     *pDir;
+  DATA16  Entry;                                // Index into entry names
+  DATA8   Priority;
+}
+FOLDERITEM;
+
+
+typedef   struct
+{
+  DATA8   Pending;                              // Entries not read from directory cache yet
   DATA16  Entries;
   DATA8   Type;
   DATA8   Sort;
   DATA8   Folder[MAX_FILENAME_SIZE];
-  DATA8   Entry[DIR_DEEPT][FILENAME_SIZE];
-  DATA8   Priority[DIR_DEEPT];
+  DATA8   Entry[DIR_DEEPT][FILENAME_SIZE];      // Names in directory order
+  FOLDERITEM Item[DIR_DEEPT];                   // Entries in display order
 }
 FOLDER;
 
 
+#define   FOLDER_ENTRY(pMemory,No)    ((char*)(*pMemory).Entry[(*pMemory).Item[(No)].Entry])
+
+
 enum
 {
   SORT_NONE,
@@ -1566,20 +2573,14 @@ char      *pFavourites[SORT_TYPES][8] =
 };
 
 
-void      cMemorySortEntry(FOLDER *pMemory,UBYTE Type,char *pName)
+void      cMemoryAddEntry(FOLDER *pMemory,UBYTE Type,char *pName)
 {
   DATA8   Sort;
-  DATA8   Sort1;
-  DATA8   Sort2;
   DATA8   Pointer;
   DATA8   Priority;
-  DATA8   TmpPriority;
-  DATA8   Favourites;
-  char    TmpEntry[FILENAME_SIZE];
 
   Sort        =  (*pMemory).Sort;
-  Favourites  =  NoOfFavourites[Sort];
-  Priority    =  Favourites;
+  Priority    =  NoOfFavourites[Sort];
 
   if ((Type != DT_DIR) && (Type != DT_LNK))
   { // Files
@@ -1597,7 +2598,6 @@ void      cMemorySortEntry(FOLDER *pMemory,UBYTE Type,char *pName)
     {
       Priority  =  FILETYPES;
     }
-    Favourites  =  FILETYPES;
   }
   else
   { // Folders
@@ -1626,26 +2626,27 @@ void      cMemorySortEntry(FOLDER *pMemory,UBYTE Type,char *pName)
     }
   }
   snprintf((char*)(*pMemory).Entry[(*pMemory).Entries],FILENAME_SIZE,"%s",pName);
-  (*pMemory).Priority[(*pMemory).Entries]  =  Priority;
+  (*pMemory).Item[(*pMemory).Entries].Entry     =  (*pMemory).Entries;
+  (*pMemory).Item[(*pMemory).Entries].Priority  =  Priority;
   ((*pMemory).Entries)++;
-  if (Priority < Favourites)
+}
+
+
+int       cMemoryCompareItems(const void *pA,const void *pB)
+{
+  const FOLDERITEM *pItemA = (const FOLDERITEM*)pA;
+  const FOLDERITEM *pItemB = (const FOLDERITEM*)pB;
+  int     Result;
+
+  // By priority - entries with same priority stay in directory order
+
+  Result  =  (int)(*pItemA).Priority - (int)(*pItemB).Priority;
+  if (Result == 0)
   {
-    for (Sort1 = 0;Sort1 < ((*pMemory).Entries - 1);Sort1++)
-    {
-      for (Sort2 = 0;Sort2 < ((*pMemory).Entries - 1);Sort2++)
-      {
-        if ((*pMemory).Priority[Sort2 + 1] < (*pMemory).Priority[Sort2])
-        {
-          TmpPriority  =  (*pMemory).Priority[Sort2];
-          strcpy(TmpEntry,(char*)(*pMemory).Entry[Sort2]);
-          (*pMemory).Priority[Sort2]  =  (*pMemory).Priority[Sort2 + 1];
-          strcpy((char*)(*pMemory).Entry[Sort2],(char*)(*pMemory).Entry[Sort2 + 1]);
-          (*pMemory).Priority[Sort2 + 1]  =  TmpPriority;
-          strcpy((char*)(*pMemory).Entry[Sort2 + 1],(char*)TmpEntry);
-        }
-      }
-    }
+    Result  =  (int)(*pItemA).Entry - (int)(*pItemB).Entry;
   }
+
+  return (Result);
 }
 
 
@@ -1653,10 +2654,12 @@ void      cMemorySortList(FOLDER *pMemory)
 {
   DATA16  Pointer;
 
+  qsort((*pMemory).Item,(size_t)(*pMemory).Entries,sizeof(FOLDERITEM),cMemoryCompareItems);
+
   for (Pointer = 0;Pointer < (*pMemory).Entries;Pointer++)
   {
 #ifdef DEBUG
-    printf("[%s](%d)(%d) %s\n",(char*)(*pMemory).Folder,(*pMemory).Sort,(*pMemory).Priority[Pointer],(char*)(*pMemory).Entry[Pointer]);
+    printf("[%s](%d)(%d) %s\n",(char*)(*pMemory).Folder,(*pMemory).Sort,(*pMemory).Item[Pointer].Priority,FOLDER_ENTRY(pMemory,Pointer));
 #endif
   }
 }
@@ -1673,20 +2676,20 @@ RESULT    cMemoryOpenFolder(PRGID PrgId,DATA8 Type,DATA8 *pFolderName,HANDLER *p
   RESULT  Result;
   FOLDER  *pMemory;
 
-  Result  =  cMemoryAlloc(PrgId,POOL_TYPE_MEMORY,(GBINDEX)sizeof(FOLDER),((void**)&pMemory),pHandle);
+  Result  =  cMemoryAlloc(PrgId,POOL_TYPE_MEMORY,MEMORY_KIND_FILE,(GBINDEX)sizeof(FOLDER),((void**)&pMemory),pHandle);
   if (Result == OK)
   {
-    (*pMemory).pDir     =  NULL;
+    (*pMemory).Pending  =  0;
     (*pMemory).Entries  =  0;
     (*pMemory).Type     = Type;
     snprintf((char*)(*pMemory).Folder,MAX_FILENAME_SIZE,"%s",(char*)pFolderName);
-    (*pMemory).pDir  =  opendir((char*)(*pMemory).Folder);
-    if ((*pMemory).pDir == NULL)
+    if (cDirCacheGetList((char*)(*pMemory).Folder) == NULL)
     {
       Result  =  FAIL;
     }
     else
     {
+      (*pMemory).Pending  =  1;
       if (strcmp((char*)pFolderName,vmPRJS_DIR) == 0)
       {
         (*pMemory).Sort  =  SORT_PRJS;
@@ -1717,7 +2720,7 @@ RESULT    cMemoryOpenFolder(PRGID PrgId,DATA8 Type,DATA8 *pFolderName,HANDLER *p
 
 
 /*
- *  Count and sort items - one for each call
+ *  Read all items from directory cache and sort them
  *  Return total count
  */
 RESULT    cMemoryGetFolderItems(PRGID PrgId,HANDLER Handle,DATA16 *pItems)
@@ -1725,7 +2728,9 @@ RESULT    cMemoryGetFolderItems(PRGID PrgId,HANDLER Handle,DATA16 *pItems)
   RESULT  Result;
   FOLDER  *pMemory;
   char    Ext[vmEXTSIZE];
+  DIRCACHEITEM *pList;
   struct  dirent *pEntry;
+  int     Item;
 
   Result    =  cMemoryGetPointer(PrgId,Handle,((void**)&pMemory));
   *pItems   =  0;
@@ -1733,12 +2738,14 @@ RESULT    cMemoryGetFolderItems(PRGID PrgId,HANDLER Handle,DATA16 *pItems)
   if (Result == OK)
   { // Handle ok
 
-    if ((*pMemory).pDir != NULL)
+    if ((*pMemory).Pending)
     {
-      pEntry  =  readdir((*pMemory).pDir);
-      if (pEntry != NULL)
+      pList  =  cDirCacheGetList((char*)(*pMemory).Folder);
+      for (Item = 0;(pList != NULL) && (Item < (*pList).Items);Item++)
       { // More entries
 
+        pEntry  =  (*pList).pNameList[Item];
+
         if ((*pMemory).Entries < DIR_DEEPT)
         {
           if ((*pEntry).d_name[0] != '.')
@@ -1750,7 +2757,7 @@ RESULT    cMemoryGetFolderItems(PRGID PrgId,HANDLER Handle,DATA16 *pItems)
                 if (((*pEntry).d_type == DT_DIR) || ((*pEntry).d_type == DT_LNK))
                 { // Folders
 
-                  cMemorySortEntry(pMemory,(*pEntry).d_type,(*pEntry).d_name);
+                  cMemoryAddEntry(pMemory,(*pEntry).d_type,(*pEntry).d_name);
 #ifdef DEBUG
                   printf("[%s](%d) %s\n",(char*)(*pMemory).Folder,(*pMemory).Sort,(*pEntry).d_name);
 #endif
@@ -1764,7 +2771,7 @@ RESULT    cMemoryGetFolderItems(PRGID PrgId,HANDLER Handle,DATA16 *pItems)
                   FindName((*pEntry).d_name,NULL,NULL,Ext);
                   if (cMemoryFindType(Ext))
                   {
-                    cMemorySortEntry(pMemory,(*pEntry).d_type,(*pEntry).d_name);
+                    cMemoryAddEntry(pMemory,(*pEntry).d_type,(*pEntry).d_name);
 #ifdef DEBUG
                     printf("[%s](%d) %s\n",(char*)(*pMemory).Folder,(*pMemory).Sort,(*pEntry).d_name);
 #endif
@@ -1774,15 +2781,12 @@ RESULT    cMemoryGetFolderItems(PRGID PrgId,HANDLER Handle,DATA16 *pItems)
             }
           }
         }
-        Result  =  BUSY;
       }
-      else
-      { // No more entries
 
-        cMemorySortList(pMemory);
-        closedir((*pMemory).pDir);
-        (*pMemory).pDir  =  NULL;
-      }
+      // No more entries
+
+      cMemorySortList(pMemory);
+      (*pMemory).Pending  =  0;
     }
     *pItems  =  ((*pMemory).Entries);
   }
@@ -1814,7 +2818,7 @@ RESULT    cMemoryGetItemName(PRGID PrgId,HANDLER Handle,DATA16 Item,DATA8 Length
 
       if (Length >= 2)
       {
-        if (cMemoryCheckFilename((char*)(*pMemory).Entry[Item - 1],NULL,Name,Ext) == OK)
+        if (cMemoryCheckFilename(FOLDER_ENTRY(pMemory,Item - 1),NULL,Name,Ext) == OK)
         {
           *pType  =  cMemoryFindType(Ext);
           if (strlen(Name) >= Length)
@@ -1824,7 +2828,7 @@ RESULT    cMemoryGetItemName(PRGID PrgId,HANDLER Handle,DATA16 Item,DATA8 Length
           }
 
           snprintf((char*)pName,(int)Length,"%s",Name);
-          *pPriority  =  (*pMemory).Priority[Item - 1];
+          *pPriority  =  (*pMemory).Item[Item - 1].Priority;
         }
         else
         {
@@ -1856,8 +2860,7 @@ RESULT    cMemoryGetItemIcon(PRGID PrgId,HANDLER Handle,DATA16 Item,HANDLER *pHa
   char    Filename[MAX_FILENAME_SIZE];
   DATA32  ISize;
   IP      pImage;
-  struct  stat FileStatus;
-  int     hFile;
+  UBYTE   *pCached;
 
   Result  =  cMemoryGetPointer(PrgId,Handle,((void**)&pMemory));
 
@@ -1868,28 +2871,17 @@ RESULT    cMemoryGetItemIcon(PRGID PrgId,HANDLER Handle,DATA16 Item,HANDLER *pHa
     if ((Item > 0) && (Item <= (*pMemory).Entries))
     { // Item ok
 
-      snprintf(Filename,MAX_FILENAME_SIZE,"%s/%s/%s%s",(char*)(*pMemory).Folder,(char*)(*pMemory).Entry[Item - 1],ICON_FILE_NAME,EXT_GRAPHICS);
+      snprintf(Filename,MAX_FILENAME_SIZE,"%s/%s/%s%s",(char*)(*pMemory).Folder,FOLDER_ENTRY(pMemory,Item - 1),ICON_FILE_NAME,EXT_GRAPHICS);
 
-      hFile  =  open(Filename,O_RDONLY);
-
-      if (hFile >= MIN_HANDLE)
+      if (cImageCacheGet(Filename,&pCached,&ISize) == OK)
       {
-
-        stat(Filename,&FileStatus);
-        ISize  =  FileStatus.st_size;
-
         // allocate memory to contain the whole file:
-        if (cMemoryAlloc(PrgId,POOL_TYPE_MEMORY,(GBINDEX)ISize,(void**)&pImage,pHandle) == OK)
+        if (cMemoryAlloc(PrgId,POOL_TYPE_MEMORY,MEMORY_KIND_IMAGE,(GBINDEX)ISize,(void**)&pImage,pHandle) == OK)
         {
-
-          if ((DATA32)read(hFile,pImage,ISize) == ISize)
-          {
-            *pImagePointer  =  (DATA32)pImage;
-            Result  =  OK;
-          }
+          memcpy(pImage,pCached,(size_t)ISize);
+          *pImagePointer  =  (DATA32)pImage;
+          Result  =  OK;
         }
-
-        close(hFile);
       }
     }
   }
@@ -1924,7 +2916,7 @@ RESULT    cMemoryGetItemText(PRGID PrgId,HANDLER Handle,DATA16 Item,DATA8 Length
     { // Item ok
 
 //      snprintf(Filename,MAX_FILENAME_SIZE,"%s/%s/%s%s",(char*)(*pMemory).Folder,(char*)(*pMemory).Entry[Item - 1],TEXT_FILE_NAME,EXT_TEXT);
-      snprintf(Filename,MAX_FILENAME_SIZE,"%s/%s%s",vmSETTINGS_DIR,(char*)(*pMemory).Entry[Item - 1],EXT_TEXT);
+      snprintf(Filename,MAX_FILENAME_SIZE,"%s/%s%s",vmSETTINGS_DIR,FOLDER_ENTRY(pMemory,Item - 1),EXT_TEXT);
       hFile   =  open(Filename,O_RDONLY);
       if (hFile >= MIN_HANDLE)
       {
@@ -1979,7 +2971,7 @@ RESULT    cMemorySetItemText(PRGID PrgId,HANDLER Handle,DATA16 Item,DATA8 *pText
     if ((Item > 0) && (Item <= (*pMemory).Entries) && Length)
     { // Item ok
 
-      snprintf(Filename,MAX_FILENAME_SIZE,"%s/%s/%s%s",(char*)(*pMemory).Folder,(char*)(*pMemory).Entry[Item - 1],TEXT_FILE_NAME,EXT_TEXT);
+      snprintf(Filename,MAX_FILENAME_SIZE,"%s/%s/%s%s",(char*)(*pMemory).Folder,FOLDER_ENTRY(pMemory,Item - 1),TEXT_FILE_NAME,EXT_TEXT);
 
       pFile = fopen (Filename, "wb");
       if (NULL != pFile)
@@ -2021,7 +3013,7 @@ RESULT    cMemoryGetItem(PRGID PrgId,HANDLER Handle,DATA16 Item,DATA8 Length,DAT
     if ((Item > 0) && (Item <= (*pMemory).Entries))
     { // Item ok
 
-      if (cMemoryCheckFilename((char*)(*pMemory).Entry[Item - 1],Folder,Name,Ext) == OK)
+      if (cMemoryCheckFilename(FOLDER_ENTRY(pMemory,Item - 1),Folder,Name,Ext) == OK)
       {
         *pType  =  cMemoryFindType(Ext);
         snprintf((char*)pName,(int)Length,"%s%s/%s",(char*)(*pMemory).Folder,Folder,Name);
@@ -2043,7 +3035,7 @@ RESULT    cMemoryGetItem(PRGID PrgId,HANDLER Handle,DATA16 Item,DATA8 Length,DAT
 
 
 /*
- *  Close directory stream and free memory handle
+ *  Free memory handle
  */
 void      cMemoryCloseFolder(PRGID PrgId,HANDLER *pHandle)
 {
@@ -2055,10 +3047,6 @@ void      cMemoryCloseFolder(PRGID PrgId,HANDLER *pHandle)
   if (Result == OK)
   { // Handle ok
 
-    if ((*pMemory).pDir != NULL)
-    {
-      closedir((*pMemory).pDir);
-    }
     cMemoryFreePool(PrgId,(void*)pMemory);
   }
   *pHandle  =  0;
@@ -2187,6 +3175,58 @@ void      cMemoryCloseFolder(PRGID PrgId,HANDLER *pHandle)
  *    -  \param  (DATA8)    NAME        - First character in file name (character string)\n
  *
  *\n
+ *  - CMD = FLUSH
+ *\n  Flush data written to file to storage (waits for files closed earlier to be flushed)\n
+ *    -  \param  (HANDLER)  HANDLE      - Handle to file\n
+ *
+ *\n
+ *  - CMD = GET_LOG_STATUS
+ *\n  Get number of samples written to and dropped from data log file\n
+ *    -  \param  (HANDLER)  HANDLE      - Handle to file\n
+ *    -  \return (DATA32)   SAMPLES     - Samples logged\n
+ *    -  \return (DATA32)   DROPPED     - Samples dropped because storage could not keep up\n
+ *
+ *\n
+ *  - CMD = SET_LOG_RING
+ *\n  Keep only the latest samples in data log file (call after OPEN_LOG before first WRITE_LOG).\n
+ *  The file is preallocated and the oldest samples are overwritten. The samples are put in order
+ *  when the log is closed. Not possible for logs in ram or with variable record size (ASCII or compact logs)\n
+ *    -  \param  (HANDLER)  HANDLE      - Handle to file\n
+ *    -  \param  (DATA32)   SAMPLES     - Number of samples to keep\n
+ *    -  \return (DATA8)    OK          - Ring mode started (0 = no, 1 = yes)\n
+ *
+ *\n
+ *  - CMD = READ_ARRAY
+ *\n  Read array elements from binary file (elements as stored in memory - little endian). The array
+ *  grows if needed. A partial element at the end of the file is not read\n
+ *    -  \param  (HANDLER)  HANDLE      - Handle to file (opened for read)\n
+ *    -  \param  (HANDLER)  HARRAY      - Array handle\n
+ *    -  \param  (DATA32)   INDEX       - Index to first element to read into\n
+ *    -  \param  (DATA32)   ELEMENTS    - Number of elements to read\n
+ *    -  \return (DATA32)   READ        - Number of elements read (less at end of file)\n
+ *
+ *\n
+ *  - CMD = WRITE_ARRAY
+ *\n  Write array elements to binary file (elements as stored in memory - little endian)\n
+ *    -  \param  (HANDLER)  HANDLE      - Handle to file (opened for write or append)\n
+ *    -  \param  (HANDLER)  HARRAY      - Array handle\n
+ *    -  \param  (DATA32)   INDEX       - Index to first element to write\n
+ *    -  \param  (DATA32)   ELEMENTS    - Number of elements to write\n
+ *
+ *\n
+ *  - CMD = READ_TABLE
+ *\n  Parse delimited text file (e.g. CSV) into DATAF or DATA32 array - one row per line, row after row.
+ *  The array is resized to ROWS * COLUMNS. Values that can not be parsed or are missing are set to NAN.
+ *  Read a header line with READ_TEXT first to skip it\n
+ *    -  \param  (HANDLER)  HANDLE      - Handle to file (opened for read)\n
+ *    -  \param  (DATA8)    \ref delimiters "DEL" - Delimiter between values (TAB, SPACE, COLON or COMMA)\n
+ *    -  \param  (DATA8)    FIRST       - First column to read (0 = first)\n
+ *    -  \param  (DATA8)    COLUMNS     - Number of columns to read\n
+ *    -  \param  (HANDLER)  HARRAY      - Array handle (DATAF or DATA32 array)\n
+ *    -  \return (DATA32)   ROWS        - Number of rows read\n
+ *    -  \return (DATA32)   ERROR       - Line of first value that could not be parsed (1 = first line read, 0 = none)\n
+ *
+ *\n
  *  - CMD = GET_LOG_NAME
  *\n  Get the current open log filename\n
  *    -  \param  (DATA8)    LENGTH      - Max string length (don't care if NAME is a HND\n
@@ -2344,9 +3384,12 @@ void      cMemoryFile(void)
 
   void    *pTmp;
   HANDLER TmpHandle2;
+  FDESCR  *pFDescr;
 
   DATA32  Size;
   DATA32  Files;
+  DATA32  Samples;
+  DATA32  Dropped;
 
   TmpPrgId      =  CurrentProgramId();
   TmpIp         =  GetObjectIp();
@@ -2512,13 +3555,9 @@ void      cMemoryFile(void)
 
         DspStat       =  NOBREAK;
 
-        if ((SIIM < MIN_LIVE_UPDATE_TIME) || (FilenameBuf[0] == 0))
+        if (FilenameBuf[0] == 0)
         { // Log in ram
 
-          if (FilenameBuf[0])
-          {
-            DspStat   =  cMemoryOpenFile(TmpPrgId,OPEN_FOR_LOG,FilenameBuf,&TmpHandle,&ISize);
-          }
           if (DspStat == NOBREAK)
           {
             Elements      =  LOGBUFFER_SIZE;
@@ -2526,7 +3565,7 @@ void      cMemoryFile(void)
             ElementSize   =  sizeof(DATA8);
             ISize         =  Elements * ElementSize + sizeof(DESCR);
 
-            if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
+            if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,MEMORY_KIND_FILE,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
             {
               (*(DESCR*)pTmp).Type          =  DATA_8;
               (*(DESCR*)pTmp).ElementSize   =  (DATA8)ElementSize;
@@ -2572,7 +3611,20 @@ void      cMemoryFile(void)
           DspStat   =  cMemoryOpenFile(TmpPrgId,OPEN_FOR_LOG,FilenameBuf,&TmpHandle,&ISize);
           if (DspStat == NOBREAK)
           {
-            DspStat =  cMemoryWriteFile(TmpPrgId,TmpHandle,(DATA32)Bytes,DEL_NONE,(DATA8*)Buffer);
+            pFDescr           =  (FDESCR*)MemoryInstance.pPoolList[TmpPrgId][TmpHandle].pPool;
+            (*pFDescr).pLog   =  cDatalogOpen((*pFDescr).hFile);
+
+            if ((*pFDescr).pLog != NULL)
+            { // Log buffers are file memory of the program
+
+              cMemoryAccount(TmpPrgId,MEMORY_KIND_FILE,0,(GBINDEX)sizeof(DATALOG));
+              cDatalogAppend((*pFDescr).pLog,(UBYTE*)Buffer,(DATA32)Bytes);
+            }
+            else
+            { // No writer thread - write directly
+
+              DspStat =  cMemoryWriteFile(TmpPrgId,TmpHandle,(DATA32)Bytes,DEL_NONE,(DATA8*)Buffer);
+            }
   #ifdef DEBUG_C_MEMORY_LOG
             printf("LOG_OPEN  %d into file %s\n",TmpHandle,(char*)pFileName);
             printf("  header  %d file %d bytes\n",TmpHandle,Bytes);
@@ -2680,12 +3732,31 @@ void      cMemoryFile(void)
           }
         }
         else
-        { // Log to file
+        {
+          if ((cMemoryGetPointer(TmpPrgId,TmpHandle,(void**)&pFDescr) == OK) && (MemoryInstance.pPoolList[TmpPrgId][TmpHandle].Type == POOL_TYPE_FILE))
+          { // Log to file
 
 #ifdef DEBUG_C_MEMORY_LOG
-          printf("LOG_WRITE %d file %d bytes\n",TmpHandle,Bytes);
+            printf("LOG_WRITE %d file %d bytes\n",TmpHandle,Bytes);
+#endif
+            if ((*pFDescr).pLog != NULL)
+            {
+#ifdef ENABLE_LOG_COMPACT
+              cDatalogWriteCompact((*pFDescr).pLog,Time,Items,pValue);
+#else
+              cDatalogWrite((*pFDescr).pLog,Time,(UBYTE*)Buffer,(DATA32)Bytes);
 #endif
-          DspStat       =  cMemoryWriteFile(TmpPrgId,TmpHandle,(DATA32)Bytes,DEL_NONE,(DATA8*)Buffer);
+            }
+            else
+            {
+              DspStat   =  cMemoryWriteFile(TmpPrgId,TmpHandle,(DATA32)Bytes,DEL_NONE,(DATA8*)Buffer);
+            }
+          }
+          else
+          { // Not a log
+
+            LogErrorNumber(FILE_WRITE_ERROR);
+          }
         }
       }
       if (Error == OUT_OF_MEMORY)
@@ -2794,7 +3865,6 @@ void      cMemoryFile(void)
               if (DspStat == NOBREAK)
               {
                 DspStat   =  cMemoryCloseFile(TmpPrgId,TmpHandle2);
-                sync();
               }
             }
           }
@@ -2811,49 +3881,158 @@ void      cMemoryFile(void)
         }
         else
         {
+          if ((cMemoryGetPointer(TmpPrgId,TmpHandle,(void**)&pFDescr) == OK) && (MemoryInstance.pPoolList[TmpPrgId][TmpHandle].Type == POOL_TYPE_FILE))
+          { // Log to file
+
 #ifndef ENABLE_LOG_ASCII
-          Buffer[0]  =  0xFF;
-          Buffer[1]  =  0xFF;
-          Buffer[2]  =  0xFF;
-          Buffer[3]  =  0xFF;
-          Buffer[4]  =  0xFF;
-          Buffer[5]  =  0xFF;
-          Buffer[6]  =  0xFF;
-          Buffer[7]  =  0xFF;
-
-          Bytes      =  8;
+            Buffer[0]  =  0xFF;
+            Buffer[1]  =  0xFF;
+            Buffer[2]  =  0xFF;
+            Buffer[3]  =  0xFF;
+            Buffer[4]  =  0xFF;
+            Buffer[5]  =  0xFF;
+            Buffer[6]  =  0xFF;
+            Buffer[7]  =  0xFF;
+
+            Bytes      =  8;
 #else
-          Buffer[0]  =  'F';
-          Buffer[1]  =  'F';
-          Buffer[2]  =  'F';
-          Buffer[3]  =  'F';
-          Buffer[4]  =  'F';
-          Buffer[5]  =  'F';
-          Buffer[6]  =  'F';
-          Buffer[7]  =  'F';
-          Buffer[8]  =  '\r';
-          Buffer[9]  =  '\n';
-
-          Bytes      =  10;
+            Buffer[0]  =  'F';
+            Buffer[1]  =  'F';
+            Buffer[2]  =  'F';
+            Buffer[3]  =  'F';
+            Buffer[4]  =  'F';
+            Buffer[5]  =  'F';
+            Buffer[6]  =  'F';
+            Buffer[7]  =  'F';
+            Buffer[8]  =  '\r';
+            Buffer[9]  =  '\n';
+
+            Bytes      =  10;
 #endif
 
 #ifdef DEBUG_C_MEMORY_LOG
-          printf("LOG_WRITE %d file %d 0xFF\n",TmpHandle,Bytes);
+            printf("LOG_WRITE %d file %d 0xFF\n",TmpHandle,Bytes);
+#endif
+            if ((*pFDescr).pLog != NULL)
+            {
+#ifdef ENABLE_LOG_COMPACT
+              cDatalogWriteIndex((*pFDescr).pLog);
 #endif
-          DspStat       =  cMemoryWriteFile(TmpPrgId,TmpHandle,(DATA32)Bytes,DEL_NONE,(DATA8*)Buffer);
+              cDatalogEnd((*pFDescr).pLog,(UBYTE*)Buffer,(DATA32)Bytes);
+            }
+            else
+            {
+              DspStat   =  cMemoryWriteFile(TmpPrgId,TmpHandle,(DATA32)Bytes,DEL_NONE,(DATA8*)Buffer);
+            }
 
 #ifdef DEBUG_C_MEMORY_LOG
-          printf("LOG_CLOSE %d file\n",TmpHandle);
+            printf("LOG_CLOSE %d file\n",TmpHandle);
 #endif
-          DspStat       =  cMemoryCloseFile(TmpPrgId,TmpHandle);
+            DspStat     =  cMemoryCloseFile(TmpPrgId,TmpHandle);
+          }
+          else
+          { // Not a log
 
-          sync();
+            LogErrorNumber(FILE_CLOSE_ERROR);
+          }
+        }
+      }
+      DspStat       =  NOBREAK;
+    }
+    break;
+
+    case scFLUSH:
+    {
+      TmpHandle     =  *(DATA16*)PrimParPointer();
+
+      DspStat       =  cMemoryFlushFile(TmpPrgId,TmpHandle);
+    }
+    break;
+
+    case scGET_LOG_STATUS:
+    {
+      TmpHandle     =  *(DATA16*)PrimParPointer();
+
+      Samples       =  0;
+      Dropped       =  0;
+
+      if (cMemoryGetPointer(TmpPrgId,TmpHandle,(void**)&pFDescr) == OK)
+      {
+        if ((MemoryInstance.pPoolList[TmpPrgId][TmpHandle].Type == POOL_TYPE_FILE) && ((*pFDescr).pLog != NULL))
+        {
+          Samples   =  (*(*pFDescr).pLog).Samples;
+          Dropped   =  (*(*pFDescr).pLog).Dropped;
+        }
+      }
+      *(DATA32*)PrimParPointer()  =  Samples;
+      *(DATA32*)PrimParPointer()  =  Dropped;
+
+      DspStat       =  NOBREAK;
+    }
+    break;
+
+    case scSET_LOG_RING:
+    {
+      TmpHandle     =  *(DATA16*)PrimParPointer();
+      Samples       =  *(DATA32*)PrimParPointer();
+
+      Tmp           =  0;
+
+      if (cMemoryGetPointer(TmpPrgId,TmpHandle,(void**)&pFDescr) == OK)
+      {
+        if ((MemoryInstance.pPoolList[TmpPrgId][TmpHandle].Type == POOL_TYPE_FILE) && ((*pFDescr).pLog != NULL))
+        {
+          if (cDatalogSetRing((*pFDescr).pLog,(*pFDescr).Filename,Samples) == OK)
+          {
+            Tmp     =  1;
+          }
         }
       }
+      *(DATA8*)PrimParPointer()   =  Tmp;
+
       DspStat       =  NOBREAK;
     }
     break;
 
+    case scREAD_ARRAY:
+    {
+      TmpHandle     =  *(DATA16*)PrimParPointer();
+      TmpHandle2    =  *(HANDLER*)PrimParPointer();
+      Data32        =  *(DATA32*)PrimParPointer();
+      Elements      =  *(DATA32*)PrimParPointer();
+
+      DspStat       =  cMemoryReadArray(TmpPrgId,TmpHandle,TmpHandle2,Data32,Elements,&Elements);
+
+      *(DATA32*)PrimParPointer()  =  Elements;
+    }
+    break;
+
+    case scWRITE_ARRAY:
+    {
+      TmpHandle     =  *(DATA16*)PrimParPointer();
+      TmpHandle2    =  *(HANDLER*)PrimParPointer();
+      Data32        =  *(DATA32*)PrimParPointer();
+      Elements      =  *(DATA32*)PrimParPointer();
+
+      DspStat       =  cMemoryWriteArray(TmpPrgId,TmpHandle,TmpHandle2,Data32,Elements);
+    }
+    break;
+
+    case scREAD_TABLE:
+    {
+      TmpHandle     =  *(DATA16*)PrimParPointer();
+      Del           =  *(DATA8*)PrimParPointer();
+      Item          =  *(DATA8*)PrimParPointer();
+      Items         =  *(DATA8*)PrimParPointer();
+      TmpHandle2    =  *(HANDLER*)PrimParPointer();
+
+      DspStat       =  cMemoryReadTable(TmpPrgId,TmpHandle,Del,Item,Items,TmpHandle2,&Elements,&Data32);
+
+      *(DATA32*)PrimParPointer()  =  Elements;
+      *(DATA32*)PrimParPointer()  =  Data32;
+    }
+    break;
+
     case scGET_LOG_NAME:
     {
       Lng           = *(DATA8*)PrimParPointer();
@@ -2942,7 +4121,8 @@ void      cMemoryFile(void)
       {
         mkdir((char*)PathBuf,DIRPERMISSIONS);
         chmod((char*)PathBuf,DIRPERMISSIONS);
-        sync();
+        FindName(PathBuf,SourceBuf,NULL,NULL);
+        cMemoryFlushFolder(SourceBuf);
 
 #ifdef DEBUG_TRACE_FILENAME
         printf("c_memory  cMemoryFile: MAKE_FOLDER [%s]\n",PathBuf);
@@ -2988,8 +4168,7 @@ void      cMemoryFile(void)
 
           Size  =  cMemoryFindSize((char*)SourceBuf,&Files);
 
-          cMemoryGetUsage(NULL,&FreeRam,1);
-          if (((Size + (KB - 1)) / KB) < FreeRam)
+          if (cMemoryReserveSpace(Size * KB) == OK)
           {
             system(Buffer);
           }
@@ -3051,7 +4230,7 @@ void      cMemoryFile(void)
             ISize  =  FileStatus.st_size;
 
             // allocate memory to contain the whole file:
-            if (cMemoryAlloc(PrgNo,POOL_TYPE_MEMORY,(GBINDEX)ISize,(void**)&pImage,&TmpHandle) == OK)
+            if (cMemoryAlloc(PrgNo,POOL_TYPE_MEMORY,MEMORY_KIND_PROGRAM,(GBINDEX)ISize,(void**)&pImage,&TmpHandle) == OK)
             {
               if (ISize == read(hFile,pImage,ISize))
               {
@@ -3086,7 +4265,7 @@ void      cMemoryFile(void)
       DspStat     =  FAILBREAK;
       TmpHandle   = -1;
 
-      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,(GBINDEX)ISize,(void**)&pImage,&TmpHandle) == OK)
+      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,MEMORY_KIND_ARRAY,(GBINDEX)ISize,(void**)&pImage,&TmpHandle) == OK)
       {
         ImagePointer  =  (DATA32)pImage;
         DspStat       =  NOBREAK;
@@ -3329,6 +4508,14 @@ void      cMemoryFile(void)
  *    -   \return (HANDLER) HANDLE    - Array handle\n
  *
  *\n
+ *  - CMD = CREATE_MAPPED
+ *    -   \param  (DATA8)   TYPE      - Element type (DATA_8, DATA_16, DATA_32 or DATA_F)\n
+ *    -   \param  (DATA32)  ELEMENTS  - Number of elements\n
+ *    -   \return (HANDLER) HANDLE    - Array handle\n
+ *
+ *    Array is kept in a scratch file and only paged into RAM when used - for very big arrays\n
+ *
+ *\n
  *  - CMD = SET_SIZE
  *    -   \param  (HANDLER) HANDLE    - Array handle\n
  *    -   \return (DATA32)  ELEMENTS  - Total number of elements in array\n
@@ -3467,7 +4654,7 @@ void      cMemoryArray(void)
       ElementSize =  sizeof(DATA8);
       ISize       =  Elements * ElementSize + sizeof(DESCR);
 
-      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
+      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,MEMORY_KIND_STRING,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
       {
         (*(DESCR*)pTmp).Type          =  DATA_8;
         (*(DESCR*)pTmp).ElementSize   =  (DATA8)ElementSize;
@@ -3496,7 +4683,7 @@ void      cMemoryArray(void)
       ElementSize =  sizeof(DATA16);
       ISize       =  Elements * ElementSize + sizeof(DESCR);
 
-      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
+      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,MEMORY_KIND_ARRAY,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
       {
         (*(DESCR*)pTmp).Type          =  DATA_16;
         (*(DESCR*)pTmp).ElementSize   =  (DATA8)ElementSize;
@@ -3525,7 +4712,7 @@ void      cMemoryArray(void)
       ElementSize =  sizeof(DATA32);
       ISize       =  Elements * ElementSize + sizeof(DESCR);
 
-      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
+      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,MEMORY_KIND_ARRAY,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
       {
         (*(DESCR*)pTmp).Type          =  DATA_32;
         (*(DESCR*)pTmp).ElementSize   =  (DATA8)ElementSize;
@@ -3554,7 +4741,7 @@ void      cMemoryArray(void)
       ElementSize =  sizeof(DATAF);
       ISize       =  Elements * ElementSize + sizeof(DESCR);
 
-      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
+      if (cMemoryAlloc(TmpPrgId,POOL_TYPE_MEMORY,MEMORY_KIND_ARRAY,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
       {
         (*(DESCR*)pTmp).Type          =  DATA_F;
         (*(DESCR*)pTmp).ElementSize   =  (DATA8)ElementSize;
@@ -3577,6 +4764,74 @@ void      cMemoryArray(void)
     }
     break;
 
+    case scCREATE_MAPPED:
+    {
+      Data8       =  *(DATA8*)PrimParPointer();
+      Elements    =  *(DATA32*)PrimParPointer();
+      TmpHandle   =  -1;
+      DspStat     =  FAILBREAK;
+
+      switch (Data8)
+      {
+        case DATA_8 :
+        {
+          ElementSize  =  sizeof(DATA8);
+        }
+        break;
+
+        case DATA_16 :
+        {
+          ElementSize  =  sizeof(DATA16);
+        }
+        break;
+
+        case DATA_32 :
+        {
+          ElementSize  =  sizeof(DATA32);
+        }
+        break;
+
+        case DATA_F :
+        {
+          ElementSize  =  sizeof(DATAF);
+        }
+        break;
+
+        default :
+        {
+          ElementSize  =  0;
+        }
+        break;
+
+      }
+
+      if ((ElementSize) && (Elements >= 0) && (Elements <= ((MAX_ARRAY_SIZE - (DATA32)sizeof(DESCR)) / ElementSize)))
+      {
+        ISize       =  Elements * ElementSize + sizeof(DESCR);
+
+        if (cMemoryAllocMapped(TmpPrgId,(GBINDEX)ISize,(void**)&pTmp,&TmpHandle) == OK)
+        {
+          (*(DESCR*)pTmp).Type          =  Data8;
+          (*(DESCR*)pTmp).ElementSize   =  (DATA8)ElementSize;
+          (*(DESCR*)pTmp).Elements      =  Elements;
+
+          DspStat   =  NOBREAK;
+#ifdef DEBUG
+          printf("ARRAY CREATE_MAPPED H=%1u A=%8p t=%d s=%d\n",TmpHandle,pTmp,(*(DESCR*)pTmp).Type,ISize);
+#endif
+        }
+      }
+#ifdef DEBUG
+      if (DspStat != NOBREAK)
+      {
+        printf("ARRAY CREATE_MAPPED  error\n");
+      }
+#endif
+
+      *(HANDLER*)PrimParPointer()     =  (HANDLER)TmpHandle;
+    }
+    break;
+
     case scSET_SIZE:
     {
       TmpHandle   =  *(HANDLER*)PrimParPointer();
@@ -4378,7 +5633,7 @@ void      cMemoryUsage(void)
  *  <b>     opFILENAME (CMD, ....)  </b>
  *
  *- Memory filename entry\n
- *- Dispatch status unchanged
+ *- Dispatch status can change to BUSYBREAK (PACK and UNPACK)
  *
  *  \param  (DATA8)   CMD               - \ref memoryfilenamesubcode
  *
@@ -4421,12 +5676,12 @@ void      cMemoryUsage(void)
  *
  *\n
  *  - CMD = PACK
- *\n  Pack file or folder into "raf" container\n
+ *\n  Pack file or folder into "raf" container (runs in the background - instruction waits until done)\n
  *    -  \param  (DATA8)    FILENAME    - First character in file name (character string) "../folder/subfolder/name.ext"\n
  *
  *\n
  *  - CMD = UNPACK
- *\n  Unpack "raf" container\n
+ *\n  Unpack "raf" container (runs in the background - instruction waits until done)\n
  *    -  \param  (DATA8)    FILENAME    - First character in file name (character string) "../folder/subfolder/name"\n
  *
  *\n
@@ -4436,6 +5691,12 @@ void      cMemoryUsage(void)
  *    -  \return (DATA8)    FOLDERNAME  - First character in folder name (character string) "../folder/subfolder"\n
  *
  *\n
+ *  - CMD = GET_PACK_STATUS
+ *\n  Get progress of PACK or UNPACK running in another thread\n
+ *    -  \return (DATA8)    BUSY        - Pack or unpack running (0 = no, 1 = yes)\n
+ *    -  \return (DATA8)    PROGRESS    - Progress [%]\n
+ *
+ *\n
  *
  */
 /*! \brief  opFILENAME byte code
@@ -4453,6 +5714,8 @@ void      cMemoryFileName(void)
   char    Ext[MAX_FILENAME_SIZE];
   char    Buffer[2 * MAX_FILENAME_SIZE + 32];
   DATA8   Length;
+  DATA8   Busy;
+  DATA8   Progress;
   DATA8   *pFilename;
   DATA8   *pFolder;
   DATA8   *pName;
@@ -4464,8 +5727,11 @@ void      cMemoryFileName(void)
   DATA32  Lng;
   DATA32  Size;
   DATA32  Files;
+  IP      TmpIp;
+  DSPSTAT DspStat = NOBREAK;
 
   TmpPrgId      =  CurrentProgramId();
+  TmpIp         =  GetObjectIp();
   Cmd           =  *(DATA8*)PrimParPointer();
 
   switch (Cmd)
@@ -4603,9 +5869,9 @@ void      cMemoryFileName(void)
       // Split pFilename
       FindName((char*)pName,Folder,Name,Ext);
 
-      snprintf(Buffer,2 * MAX_FILENAME_SIZE + 32,"tar -cz -f %s%s%s -C %s %s%s &> /dev/null",Folder,Name,vmEXT_ARCHIVE,Folder,Name,Ext);
-      system(Buffer);
-      sync();
+      snprintf(Filename,MAX_FILENAME_SIZE,"%s%s%s",Folder,Name,vmEXT_ARCHIVE);
+      snprintf(Buffer,2 * MAX_FILENAME_SIZE + 32,"%s%s",Name,Ext);
+      DspStat  =  cArchiveRun(TmpPrgId,CallingObjectId(),ARCHIVE_PACK,Filename,Folder,Buffer);
     }
     break;
 
@@ -4616,9 +5882,8 @@ void      cMemoryFileName(void)
       // Split pFilename
       FindName((char*)pName,Folder,Name,Ext);
 
-      snprintf(Buffer,2 * MAX_FILENAME_SIZE + 32,"tar -xz -f %s%s%s -C %s &> /dev/null",Folder,Name,vmEXT_ARCHIVE,Folder);
-      system(Buffer);
-      sync();
+      snprintf(Filename,MAX_FILENAME_SIZE,"%s%s%s",Folder,Name,vmEXT_ARCHIVE);
+      DspStat  =  cArchiveRun(TmpPrgId,CallingObjectId(),ARCHIVE_UNPACK,Filename,Folder,Name);
     }
     break;
 
@@ -4658,7 +5923,22 @@ void      cMemoryFileName(void)
     }
     break;
 
+    case scGET_PACK_STATUS:
+    {
+      cArchiveGetStatus(&Busy,&Progress);
+      *(DATA8*)PrimParPointer()  =  Busy;
+      *(DATA8*)PrimParPointer()  =  Progress;
+    }
+    break;
+
+  }
+
+  if (DspStat == BUSYBREAK)
+  { // Rewind IP
+
+    SetObjectIp(TmpIp - 1);
   }
+  SetDispatchStatus(DspStat);
 }
 
 /*! \page cMemory
@@ -4691,7 +5971,7 @@ void      cMemoryFileMd5Sum(void)
 
   memset(pMd5Sum, 0, 16);
 
-  *pSuccess = md5_file((char*)pFileName, 0, (unsigned char *) pMd5Sum);
+  *pSuccess = cMd5CacheFile((char*)pFileName, (unsigned char *) pMd5Sum);
 }
 
 
@@ -23,6 +23,13 @@
 #define C_MEMORY_H_
 
 #include  "lms2012.h"
+#include  "c_datalog.h"
+#include  "c_dircache.h"
+#include  "c_md5cache.h"
+#include  "c_archive.h"
+#include  "c_imagecache.h"
+
+#include  <pthread.h>
 
 enum
 {
@@ -34,10 +41,13 @@ enum
 
 RESULT    ConstructFilename(PRGID PrgId,char *pFilename,char *pName,const char *pDefaultExt);
 DSPSTAT   cMemoryOpenFile(PRGID PrgId,DATA8 Access,char *pFileName,HANDLER *pHandle,DATA32 *pSize);
-RESULT    cMemoryAlloc(PRGID PrgId,DATA8 Type,GBINDEX Size,void **ppMemory,HANDLER *pHandle);
+RESULT    cMemoryAlloc(PRGID PrgId,DATA8 Type,DATA8 Kind,GBINDEX Size,void **ppMemory,HANDLER *pHandle);
 DSPSTAT   cMemoryReadFile(PRGID PrgId,HANDLER Handle,DATA32 Size,DATA8 Del,DATA8 *pDestination);
 void      cMemoryDeleteSubFolders(char *pFolderName);
 DSPSTAT   cMemoryWriteFile(PRGID PrgId,HANDLER Handle,DATA32 Size,DATA8 Del,DATA8 *pSource);
+DSPSTAT   cMemoryReadArray(PRGID PrgId,HANDLER Handle,HANDLER hArray,DATA32 Index,DATA32 Elements,DATA32 *pElements);
+DSPSTAT   cMemoryWriteArray(PRGID PrgId,HANDLER Handle,HANDLER hArray,DATA32 Index,DATA32 Elements);
+DSPSTAT   cMemoryReadTable(PRGID PrgId,HANDLER Handle,DATA8 Del,DATA8 First,DATA8 Columns,HANDLER hArray,DATA32 *pRows,DATA32 *pError);
 DSPSTAT   cMemoryGetFileHandle(PRGID PrgId,char *pFileName,HANDLER *pHandle,DATA8 *pOpenForWrite);
 void      cMemoryFilename(PRGID PrgId,char *pName,char *pExt,DATA8 Length,char *pResult);
 void      cMemoryFileMd5Sum(void);
@@ -62,6 +72,8 @@ DATA8     cMemoryGetCacheFiles(void);
 
 RESULT    cMemoryGetCacheName(DATA8 Item,DATA8 MaxLength,char *pFileName,char *pName,DATA8 *pType);
 
+int       cMemorySort(void *ppFirst,void *ppSecond);
+
 DATA8     cMemoryFindSubFolders(char *pFolderName);
 
 DATA8     cMemoryGetSubFolderName(DATA8 Item,DATA8 MaxLength,char *pFolderName,char *pSubFolderName);
@@ -76,10 +88,14 @@ RESULT    cMemoryGetImage(DATA8 *pText,DATA16 Size,UBYTE *pBmp);
 
 DSPSTAT   cMemoryCloseFile(PRGID PrgId,HANDLER Handle);
 
+DSPSTAT   cMemoryFlushFile(PRGID PrgId,HANDLER Handle);
+
 RESULT    cMemoryCheckOpenWrite(char *pFileName);
 
 RESULT    cMemoryCheckFilename(char *pFilename,char *pPath,char *pName,char *pExt);
 
+void      FindName(char *pSource,char *pPath,char *pName,char *pExt);
+
 RESULT    cMemoryGetMediaName(char *pChar,char *pName);
 
 
@@ -96,6 +112,8 @@ void      cMemoryArrayAppend(void);
 
 void*     cMemoryResize(PRGID PrgId,HANDLER Handle,DATA32 Elements);
 
+RESULT    cMemoryAllocMapped(PRGID PrgId,GBINDEX Size,void **ppMemory,HANDLER *pHandle);
+
 void      cMemoryFileName(void);
 
 
@@ -118,16 +136,45 @@ void      cMemoryCloseFolder(PRGID PrgId,HANDLER *pHandle);
 
 void      cMemoryGetUsage(DATA32 *pTotal,DATA32 *pFree,DATA8 Force);
 
+RESULT    cMemoryReserveSpace(DATA32 Bytes);
+
 void      cMemoryUsage(void);
 
+RESULT    cMemoryGetPoolUsage(PRGID PrgId,DATA8 Kind,DATA32 *pCurrent,DATA32 *pPeak);
+
 #define   POOL_TYPE_MEMORY    0
 #define   POOL_TYPE_FILE      1
+#define   POOL_TYPE_MAPPED    2
+
+// Kinds of pool allocations counted by PROGRAM_INFO GET_MEMORY_USAGE
+
+enum
+{
+  MEMORY_KIND_PROGRAM     = 0,                  //!< Program image, globals and locals
+  MEMORY_KIND_ARRAY       = 1,                  //!< Arrays (16, 32 bit and float) and pools
+  MEMORY_KIND_STRING      = 2,                  //!< 8 bit arrays
+  MEMORY_KIND_FILE        = 3,                  //!< File and folder handles including read and log buffers
+  MEMORY_KIND_IMAGE       = 4,                  //!< Icons and images
+  MEMORY_KIND_MAPPED      = 5,                  //!< Memory mapped arrays (not in RAM)
+
+  MEMORY_KINDS,
+  MEMORY_KIND_ALL         = MEMORY_KINDS        //!< All kinds in RAM (all but MEMORY_KIND_MAPPED)
+};
+
+typedef   struct
+{
+  DATA32  Current;                              // Bytes allocated now
+  DATA32  Peak;                                 // Most bytes allocated since program start
+}
+MEMORYUSAGE;
 
 typedef   struct
 {
   void    *pPool;
   GBINDEX Size;
   DATA8   Type;
+  DATA8   Kind;                                 // MEMORY_KIND_xxx
+  int     hFile;                                // Scratch file (POOL_TYPE_MAPPED only)
 }
 POOL;
 
@@ -149,10 +196,23 @@ typedef   struct
   int     hFile;
   DATA8   Access;
   char    Filename[vmFILENAMESIZE];
+  DATA8   Created;                              // File did not exist before open (folder needs flushing too)
+  DATA32  ReadPointer;                          // Next unread byte in read buffer
+  DATA32  ReadBytes;                            // Valid bytes in read buffer
+  UBYTE   ReadBuffer[FILE_READ_BUFFER_SIZE];
+  DATALOG *pLog;                                // Data log writer (NULL if written directly)
 }
 FDESCR;
 
 
+typedef   struct
+{
+  int     hFile;
+  char    Folder[vmFILENAMESIZE];
+}
+FLUSHITEM;
+
+
 typedef struct
 {
   //*****************************************************************************
@@ -162,11 +222,40 @@ typedef struct
   DATA32  SyncTime;
   DATA32  SyncTick;
 
+  DATA32  SpaceFree;                            // Free space at last file system query [KB]
+  DATA32  SpaceUsed;                            // Bytes written or reserved since last query
+
+#ifdef ENABLE_DEFERRED_FLUSH
+  pthread_t       FlushThread;
+  pthread_mutex_t FlushMutex;
+  pthread_cond_t  FlushCond;
+  FLUSHITEM       FlushQueue[FLUSH_QUEUE_SIZE];
+  DATA16          FlushIn;
+  DATA16          FlushOut;
+  DATA8           FlushRunning;
+#endif
+
   DATA8   PathList[MAX_PROGRAMS][vmPATHSIZE];
   POOL    pPoolList[MAX_PROGRAMS][MAX_HANDLES];
+  MEMORYUSAGE Usage[MAX_PROGRAMS][MEMORY_KINDS + 1];
 
   DATA8   Cache[CACHE_DEEPT + 1][vmFILENAMESIZE];
 
+  int     DirNotify;                            // inotify handle for directory cache
+  ULONG   DirCacheTime;
+  DIRCACHEITEM DirCache[DIRCACHE_FOLDERS];
+
+  MD5CACHEITEM Md5Cache[MD5CACHE_ENTRIES];
+  ULONG   Md5CacheTime;
+  DATA8   Md5CacheChanged;                      // Cache must be saved
+
+  ARCHIVE Archive;                              // Pack/unpack job
+
+  IMAGECACHEITEM ImageCache[IMAGECACHE_ENTRIES];
+  DATA32  ImageCacheBytes;                      // Bytes used by cached images
+  ULONG   ImageCacheTime;
+  UBYTE   *pImageScratch;                       // Last image that did not fit in the cache
+
 } MEMORY_GLOBALS;
 
 extern MEMORY_GLOBALS MemoryInstance;
@@ -3330,6 +3330,13 @@ void      Sleep(void)
  *    - \return (DATA8)     DATA   - Program name\n
  *
  *\n
+ *  - CMD = GET_MEMORY_USAGE
+ *    - \param  (DATA16)    PRGID  - Program slot number  (see \ref prgid)
+ *    - \param  (DATA8)     KIND   - Kind of allocation (MEMORY_KIND_xxx, MEMORY_KIND_ALL = all in RAM)
+ *    - \return (DATA32)    CURRENT - Bytes allocated now
+ *    - \return (DATA32)    PEAK   - Most bytes allocated since program was started\n
+ *
+ *\n
  */
 /*! \brief    opPROGRAM_INFO byte code
  *
@@ -3345,6 +3352,9 @@ void      ProgramInfo(void)
   DATA16  Instr;
   PRGID   PrgId;
   OBJID   ObjIndex;
+  DATA8   Kind;
+  DATA32  Current;
+  DATA32  Peak;
 
   Cmd             =  *(DATA8*)PrimParPointer();
   PrgId           =  *(PRGID*)PrimParPointer();
@@ -3414,6 +3424,15 @@ void      ProgramInfo(void)
     }
     break;
 
+    case scGET_MEMORY_USAGE:
+    {
+      Kind  =  *(DATA8*)PrimParPointer();
+      cMemoryGetPoolUsage(PrgId,Kind,&Current,&Peak);
+      *(DATA32*)PrimParPointer()              =  Current;
+      *(DATA32*)PrimParPointer()              =  Peak;
+    }
+    break;
+
     default :
     {
       SetDispatchStatus(FAILBREAK);
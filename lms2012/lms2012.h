@@ -179,11 +179,20 @@ typedef enum {
 #define   LOW_MEMORY            500                   //!< Low memory warning [KB]
 
 #define   LOGBUFFER_SIZE        1000                  //!< Min log buffer size
+#define   FILE_READ_BUFFER_SIZE 512                   //!< Read ahead buffer in every file handle opened for read
+#define   FLUSH_QUEUE_SIZE      16                    //!< Max number of closed files waiting to be flushed to storage
+#define   DATALOG_BUFFER_SIZE   16384                 //!< Size of each of the two buffers in a data log file (one disk write)
+#define   DATALOG_MAX_LATENCY   1000                  //!< [mS] Max time a logged sample waits in memory before it is written
 #define   DEVICE_LOGBUF_SIZE    300                   //!< Device log buffer size (black layer buffer)
 #define   MIN_LIVE_UPDATE_TIME  10                    //!< [mS] Min sample time when live update
+#define   SAMPLER_CHANNELS      8                     //!< Channels in the background input sampler
+#define   SAMPLER_RING_SIZE     2048                  //!< Samples buffered per sampler channel (must be a power of 2)
+#define   MIN_SAMPLER_PERIOD    250                   //!< [uS] Min background sampler period
+#define   FILTER_WINDOW_SIZE    16                    //!< Max samples in input filter window
 
 #define   MIN_IIC_REPEAT_TIME   10                    //!< [mS] Min IIC device repeat time
 #define   MAX_IIC_REPEAT_TIME   1000                  //!< [mS] Max IIC device repeat time
+#define   IIC_QUEUE_SIZE        8                     //!< IIC transactions kept per port (queued and done - must be a power of 2)
 
 #define   MAX_COMMAND_BYTECODES 64                    //!< Max number of byte codes in a debug terminal direct command
 #define   MAX_COMMAND_LOCALS    64                    //!< Max number of bytes allocated for direct command local variables
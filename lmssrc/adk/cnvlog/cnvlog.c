@@ -4,6 +4,134 @@
 #define   ULONG       unsigned int
 #define   UBYTE       unsigned char
 
+// Compact log format - see c_memory/c_datalog.h
+
+#define   DATALOG_BLOCK_MAGIC   0xFFC14C44
+#define   DATALOG_INDEX_MAGIC   0xFFC14944
+#define   DATALOG_BLOCK_HEADER  9
+#define   DATALOG_BLOCK_SIZE    2048
+#define   DATALOG_MAX_ITEMS     127
+
+
+ULONG     GetLong(UBYTE *pIn)
+{
+  return ((ULONG)pIn[0] | ((ULONG)pIn[1] << 8) | ((ULONG)pIn[2] << 16) | ((ULONG)pIn[3] << 24));
+}
+
+
+UBYTE*    GetDelta(UBYTE *pIn,UBYTE *pEnd,ULONG *pValue)
+{
+  ULONG   Zigzag = 0;
+  int     Shift = 0;
+
+  while ((pIn < pEnd) && (*pIn & 0x80) && (Shift < 28))
+  {
+    Zigzag |=  (ULONG)(*pIn & 0x7F) << Shift;
+    Shift  +=  7;
+    pIn++;
+  }
+  if (pIn < pEnd)
+  {
+    Zigzag |=  (ULONG)*pIn << Shift;
+    pIn++;
+  }
+  *pValue  +=  (Zigzag >> 1) ^ (0 - (Zigzag & 1));
+
+  return (pIn);
+}
+
+
+// Decode compact blocks - first block magic is already read
+// Returns 1 if the end signature was found
+
+int       DecodeCompact(FILE *pFileIn,FILE *pFileOut)
+{
+  UBYTE   Block[DATALOG_BLOCK_HEADER + DATALOG_BLOCK_SIZE];
+  ULONG   Values[DATALOG_MAX_ITEMS + 1];
+  char    Line[(DATALOG_MAX_ITEMS + 1) * 48];
+  float   Value;
+  UBYTE   *pIn;
+  UBYTE   *pEnd;
+  ULONG   Magic;
+  int     Bytes;
+  int     Records;
+  int     Items;
+  int     Item;
+  int     Length;
+
+  Magic  =  DATALOG_BLOCK_MAGIC;
+  while (Magic == DATALOG_BLOCK_MAGIC)
+  {
+    if (fread(&Block[4],1,DATALOG_BLOCK_HEADER - 4,pFileIn) != (DATALOG_BLOCK_HEADER - 4))
+    {
+      return (0);
+    }
+    Bytes    =  (int)Block[4] | ((int)Block[5] << 8);
+    Records  =  (int)Block[6] | ((int)Block[7] << 8);
+    Items    =  (int)Block[8];
+
+    if ((Bytes > DATALOG_BLOCK_SIZE) || (Items > DATALOG_MAX_ITEMS) || (fread(&Block[DATALOG_BLOCK_HEADER],1,Bytes,pFileIn) != Bytes))
+    {
+      return (0);
+    }
+
+    pIn   =  &Block[DATALOG_BLOCK_HEADER];
+    pEnd  =  &pIn[Bytes];
+    memset(Values,0,sizeof(Values));
+
+    while (Records--)
+    {
+      Length  =  0;
+      for (Item = 0;Item <= Items;Item++)
+      {
+        pIn  =  GetDelta(pIn,pEnd,&Values[Item]);
+        if (Item == 0)
+        {
+          Length +=  sprintf(&Line[Length],"%08u",Values[Item]);
+        }
+        else
+        {
+          memcpy(&Value,&Values[Item],sizeof(float));
+          Length +=  sprintf(&Line[Length],"\t%.1f",Value);
+        }
+      }
+      Line[Length++]  =  '\r';
+      Line[Length++]  =  '\n';
+      fwrite(Line,1,Length,pFileOut);
+    }
+
+    if (fread(Block,1,4,pFileIn) != 4)
+    {
+      return (0);
+    }
+    Magic  =  GetLong(Block);
+  }
+
+  if (Magic == DATALOG_INDEX_MAGIC)
+  { // Skip index
+
+    if (fread(Block,1,4,pFileIn) != 4)
+    {
+      return (0);
+    }
+    fseek(pFileIn,(long)GetLong(Block) * 8 + 8,SEEK_CUR);
+
+    if (fread(Block,1,4,pFileIn) != 4)
+    {
+      return (0);
+    }
+    Magic  =  GetLong(Block);
+  }
+
+  if ((Magic == 0xFFFFFFFF) && (fread(Block,1,4,pFileIn) == 4))
+  {
+    return (1);
+  }
+
+  return (0);
+}
+
+
 int       main(int argc,char *argv[])
 {
   FILE    *pFileIn;
@@ -27,6 +155,8 @@ int       main(int argc,char *argv[])
       if (pFileOut != NULL)
       {
         State  =  0;
+        Datas  =  0;
+        Data   =  0;
         while (fread(&Byte,1,1,pFileIn) == 1)
         {
           switch (State)
@@ -71,7 +201,16 @@ int       main(int argc,char *argv[])
               }
               if (++Bytes >= 4)
               {
-                if (Result != 0xFFFFFFFF)
+                if ((Data == 0) && (Result == DATALOG_BLOCK_MAGIC))
+                { // Compact log
+
+                  if (DecodeCompact(pFileIn,pFileOut))
+                  {
+                    fwrite("******************************************************************************************\r\n",92,1,pFileOut);
+                  }
+                  State  =  0;
+                }
+                else if (Result != 0xFFFFFFFF)
                 {
                   pData  =  (float*)&Result;
                   if (Data == 0)
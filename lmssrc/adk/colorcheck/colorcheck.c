@@ -0,0 +1,240 @@
+/*
+ *  Check NXT color sensor color (c_input/c_color.c) against the floating
+ *  point version it replaces
+ *
+ *  gcc -O2 -I<build>/lms2012 -I../../../lms2012 -I../../../c_input -o colorcheck colorcheck.c ../../../c_input/c_color.c
+ *
+ *  (<build>/lms2012 holds the generated bytecodes.h)
+ *
+ *  Every R, G and B value 0..COLOR_ALL_MAX with BLANK 0..COLOR_ALL_BLANK in
+ *  steps of COLOR_ALL_STEP, then COLOR_RUNS random values over the full
+ *  sensor range. Any difference is an error.
+ */
+
+#include  <stdio.h>
+#include  <string.h>
+
+#include  "c_color.h"
+
+#define   COLOR_ALL_MAX     255
+#define   COLOR_ALL_BLANK   200
+#define   COLOR_ALL_STEP    5
+#define   COLOR_RUNS        100000000
+#define   COLOR_RAW_MAX     1023
+
+
+DATAF     OldCalculateColor(COLORSTRUCT *pC)
+{
+  DATAF   Result ;
+
+
+  Result  =  DATAF_NAN;
+
+  // Color Sensor values has been calculated -
+  // now calculate the color and put it in Sensor value
+  if (((pC->SensorRaw[RED]) > (pC->SensorRaw[BLUE] )) &&
+      ((pC->SensorRaw[RED]) > (pC->SensorRaw[GREEN])))
+  {
+
+    // If all 3 colors are less than 65 OR (Less that 110 and bg less than 40)
+    if (((pC->SensorRaw[RED])   < 65) ||
+        (((pC->SensorRaw[BLANK]) < 40) && ((pC->SensorRaw[RED])  < 110)))
+    {
+      Result  =  (DATAF)BLACKCOLOR;
+    }
+    else
+    {
+      if (((((pC->SensorRaw[BLUE]) >> 2)  + ((pC->SensorRaw[BLUE]) >> 3) + (pC->SensorRaw[BLUE])) < (pC->SensorRaw[GREEN])) &&
+          ((((pC->SensorRaw[GREEN]) << 1)) > (pC->SensorRaw[RED])))
+      {
+        Result  =  (DATAF)YELLOWCOLOR;
+      }
+      else
+      {
+
+        if ((((pC->SensorRaw[GREEN]) << 1) - ((pC->SensorRaw[GREEN]) >> 2)) < (pC->SensorRaw[RED]))
+        {
+
+          Result  =  (DATAF)REDCOLOR;
+        }
+        else
+        {
+
+          if ((((pC->SensorRaw[BLUE]) < 70) ||
+              ((pC->SensorRaw[GREEN]) < 70)) ||
+             (((pC->SensorRaw[BLANK]) < 140) && ((pC->SensorRaw[RED]) < 140)))
+          {
+            Result  =  (DATAF)BLACKCOLOR;
+          }
+          else
+          {
+            Result  =  (DATAF)WHITECOLOR;
+          }
+        }
+      }
+    }
+  }
+  else
+  {
+
+    // Red is not the dominant color
+    if ((pC->SensorRaw[GREEN]) > (pC->SensorRaw[BLUE]))
+    {
+
+      // Green is the dominant color
+      // If all 3 colors are less than 40 OR (Less that 70 and bg less than 20)
+      if (((pC->SensorRaw[GREEN])  < 40) ||
+          (((pC->SensorRaw[BLANK]) < 30) && ((pC->SensorRaw[GREEN])  < 70)))
+      {
+        Result  =  (DATAF)BLACKCOLOR;
+      }
+      else
+      {
+        if ((((pC->SensorRaw[BLUE]) << 1)) < (pC->SensorRaw[RED]))
+        {
+          Result  =  (DATAF)YELLOWCOLOR;
+        }
+        else
+        {
+          if ((((pC->SensorRaw[RED]) + ((pC->SensorRaw[RED])>>2)) < (pC->SensorRaw[GREEN])) ||
+              (((pC->SensorRaw[BLUE]) + ((pC->SensorRaw[BLUE])>>2)) < (pC->SensorRaw[GREEN])))
+          {
+            Result  =  (DATAF)GREENCOLOR;
+          }
+          else
+          {
+            if ((((pC->SensorRaw[RED]) < 70) ||
+                ((pC->SensorRaw[BLUE]) < 70)) ||
+                (((pC->SensorRaw[BLANK]) < 140) && ((pC->SensorRaw[GREEN]) < 140)))
+            {
+              Result  =  (DATAF)BLACKCOLOR;
+            }
+            else
+            {
+              Result  =  (DATAF)WHITECOLOR;
+            }
+          }
+        }
+      }
+    }
+    else
+    {
+
+      // Blue is the most dominant color
+      // Colors can be blue, white or black
+      // If all 3 colors are less than 48 OR (Less that 85 and bg less than 25)
+      if (((pC->SensorRaw[BLUE])   < 48) ||
+          (((pC->SensorRaw[BLANK]) < 25) && ((pC->SensorRaw[BLUE])  < 85)))
+      {
+        Result  =  (DATAF)BLACKCOLOR;
+      }
+      else
+      {
+        if ((((((pC->SensorRaw[RED]) * 48) >> 5) < (pC->SensorRaw[BLUE])) &&
+            ((((pC->SensorRaw[GREEN]) * 48) >> 5) < (pC->SensorRaw[BLUE])))
+            ||
+            (((((pC->SensorRaw[RED])   * 58) >> 5) < (pC->SensorRaw[BLUE])) ||
+             ((((pC->SensorRaw[GREEN]) * 58) >> 5) < (pC->SensorRaw[BLUE]))))
+        {
+          Result  =  (DATAF)BLUECOLOR;
+        }
+        else
+        {
+
+          // Color is white or Black
+          if ((((pC->SensorRaw[RED])  < 60) ||
+              ((pC->SensorRaw[GREEN]) < 60)) ||
+             (((pC->SensorRaw[BLANK]) < 110) && ((pC->SensorRaw[BLUE]) < 120)))
+          {
+            Result  =  (DATAF)BLACKCOLOR;
+          }
+          else
+          {
+            if ((((pC->SensorRaw[RED])  + ((pC->SensorRaw[RED])   >> 3)) < (pC->SensorRaw[BLUE])) ||
+                (((pC->SensorRaw[GREEN]) + ((pC->SensorRaw[GREEN]) >> 3)) < (pC->SensorRaw[BLUE])))
+            {
+              Result  =  (DATAF)BLUECOLOR;
+            }
+            else
+            {
+              Result  =  (DATAF)WHITECOLOR;
+            }
+          }
+        }
+      }
+    }
+  }
+
+
+  return (Result);
+}
+
+
+long      CheckColor(COLORSTRUCT *pC,long *pErrors)
+{
+  DATAF   Old;
+  DATA8   New;
+
+  Old  =  OldCalculateColor(pC);
+  New  =  cColorCalculate(pC);
+  if ((DATAF)New != Old)
+  {
+    if (*pErrors < 10)
+    {
+      printf("R %u G %u B %u BLANK %u: old %g new %d\n",pC->SensorRaw[RED],pC->SensorRaw[GREEN],pC->SensorRaw[BLUE],pC->SensorRaw[BLANK],Old,New);
+    }
+    (*pErrors)++;
+  }
+
+  return (1);
+}
+
+
+int       main(void)
+{
+  COLORSTRUCT Color;
+  long    Errors = 0;
+  long    Cases = 0;
+  long    Run;
+  unsigned Seed = 1;
+  int     Red;
+  int     Green;
+  int     Blue;
+  int     Blank;
+
+  memset(&Color,0,sizeof(Color));
+
+  for (Blank = 0;Blank <= COLOR_ALL_BLANK;Blank += COLOR_ALL_STEP)
+  {
+    for (Red = 0;Red <= COLOR_ALL_MAX;Red++)
+    {
+      for (Green = 0;Green <= COLOR_ALL_MAX;Green++)
+      {
+        for (Blue = 0;Blue <= COLOR_ALL_MAX;Blue++)
+        {
+          Color.SensorRaw[RED]    =  (UWORD)Red;
+          Color.SensorRaw[GREEN]  =  (UWORD)Green;
+          Color.SensorRaw[BLUE]   =  (UWORD)Blue;
+          Color.SensorRaw[BLANK]  =  (UWORD)Blank;
+          Cases +=  CheckColor(&Color,&Errors);
+        }
+      }
+    }
+  }
+
+  for (Run = 0;Run < COLOR_RUNS;Run++)
+  {
+    Seed  =  Seed * 1103515245 + 12345;
+    Color.SensorRaw[RED]    =  (UWORD)((Seed >> 8) % (COLOR_RAW_MAX + 1));
+    Seed  =  Seed * 1103515245 + 12345;
+    Color.SensorRaw[GREEN]  =  (UWORD)((Seed >> 8) % (COLOR_RAW_MAX + 1));
+    Seed  =  Seed * 1103515245 + 12345;
+    Color.SensorRaw[BLUE]   =  (UWORD)((Seed >> 8) % (COLOR_RAW_MAX + 1));
+    Seed  =  Seed * 1103515245 + 12345;
+    Color.SensorRaw[BLANK]  =  (UWORD)((Seed >> 8) % (COLOR_RAW_MAX + 1));
+    Cases +=  CheckColor(&Color,&Errors);
+  }
+  printf("Color: %ld values, %ld errors\n",Cases,Errors);
+
+  return ((Errors) ? 1 : 0);
+}
@@ -0,0 +1,255 @@
+/*
+ *  Check integer percent and SI conversion (c_input/c_scale.c) against the
+ *  floating point formula it replaces
+ *
+ *  gcc -O2 -I../../../lms2012 -I../../../c_input -o scalecheck scalecheck.c ../../../c_input/c_scale.c -lm
+ *
+ *  Percent: every raw value in and around every raw range with a span up to
+ *  MAX_ALL_SPAN is checked for every percent limit pair, and every raw value
+ *  in every range with a span up to SCALE_MAX_SPAN for the percent limits
+ *  used by the type data. Any difference is an error.
+ *
+ *  SI: random ranges, limits and raw values. A difference of more than
+ *  SI_ULP ULP of the largest of |SiMin|, |SiMax| and the scaled raw
+ *  difference is an error. The distance of both results from the exact
+ *  value is shown.
+ */
+
+#include  <math.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+#include  "c_scale.h"
+
+#define   MAX_ALL_SPAN      24                // Span checked with all percent limits
+#define   SI_ULP            4
+#define   SI_RUNS           20000000
+
+
+static const int PctLimits[][2] =
+{
+  {    0,  100 },
+  { -100,  100 },
+  {    0,    0 },
+  {    0,    1 },
+  { -128,  127 },
+};
+
+
+DATA8     OldPct(DATAF Raw,DATAF Min,DATAF Max,DATAF PctMin,DATAF PctMax)
+{
+  DATAF   Pct;
+
+  Pct    =  (((Raw - Min) * (PctMax - PctMin)) / (Max - Min) + PctMin);
+
+  if (Pct > PctMax)
+  {
+    Pct  =  PctMax;
+  }
+  if (Pct < PctMin)
+  {
+    Pct  =  PctMin;
+  }
+
+  return ((DATA8)Pct);
+}
+
+
+DATAF     OldSi(DATAF Raw,DATAF Min,DATAF Max,DATAF SiMin,DATAF SiMax)
+{
+  return (((Raw - Min) * (SiMax - SiMin)) / (Max - Min) + SiMin);
+}
+
+
+long      CheckPctRange(SCALE *pScale,int Min,int Max,int PctMin,int PctMax,int Margin)
+{
+  long    Errors = 0;
+  int     Raw;
+  int     First;
+  int     Last;
+  DATA8   Old;
+  DATA8   New;
+
+  cScaleSetup(pScale,(DATAF)Min,(DATAF)Max,(DATAF)PctMin,(DATAF)PctMax,0.0f,1.0f);
+  if (!(*pScale).PctInt)
+  {
+    printf("Range %d..%d %d..%d%% not converted in integer\n",Min,Max,PctMin,PctMax);
+    Errors++;
+  }
+  First  =  ((Min < Max) ? Min : Max) - Margin;
+  Last   =  ((Min < Max) ? Max : Min) + Margin;
+  for (Raw = First;Raw <= Last;Raw++)
+  {
+    Old  =  OldPct((DATAF)Raw,(DATAF)Min,(DATAF)Max,(DATAF)PctMin,(DATAF)PctMax);
+    New  =  cScalePct(pScale,(DATAF)Raw);
+    if (Old != New)
+    {
+      if (Errors < 10)
+      {
+        printf("Raw %d range %d..%d %d..%d%%: old %d new %d\n",Raw,Min,Max,PctMin,PctMax,Old,New);
+      }
+      Errors++;
+    }
+  }
+
+  return (Errors);
+}
+
+
+long      CheckPct(void)
+{
+  SCALE   Scale;
+  long    Errors = 0;
+  long    Ranges = 0;
+  int     Span;
+  int     Min;
+  int     PctMin;
+  int     PctMax;
+  int     Limit;
+
+  // Small spans with every percent limit pair
+  for (Span = 1;Span <= MAX_ALL_SPAN;Span++)
+  {
+    for (PctMin = -128;PctMin <= 127;PctMin++)
+    {
+      for (PctMax = PctMin;PctMax <= 127;PctMax++)
+      {
+        for (Min = -3;Min <= 3;Min += 3)
+        {
+          Errors +=  CheckPctRange(&Scale,Min,Min + Span,PctMin,PctMax,2);
+          Errors +=  CheckPctRange(&Scale,Min + Span,Min,PctMin,PctMax,2);
+          Ranges +=  2;
+        }
+      }
+    }
+  }
+
+  // All spans with the percent limits used
+  for (Span = 1;Span <= SCALE_MAX_SPAN;Span++)
+  {
+    for (Limit = 0;Limit < (int)(sizeof(PctLimits) / sizeof(PctLimits[0]));Limit++)
+    {
+      Min  =  (Span & 1) ? 0 : -(Span / 2);
+      Errors +=  CheckPctRange(&Scale,Min,Min + Span,PctLimits[Limit][0],PctLimits[Limit][1],1);
+      Errors +=  CheckPctRange(&Scale,Min + Span,Min,PctLimits[Limit][0],PctLimits[Limit][1],1);
+      Ranges +=  2;
+    }
+  }
+  printf("Percent: %ld ranges, %ld errors\n",Ranges,Errors);
+
+  return (Errors);
+}
+
+
+DATAF     Ulp(DATAF Value)
+{
+  Value  =  fabsf(Value);
+
+  return (nextafterf(Value,INFINITY) - Value);
+}
+
+
+DATAF     RandomLimit(void)
+{
+  static const float Limits[] = { 0.0f, 1.0f, -1.0f, 100.0f, -100.0f, 2.5f, 5.0f, 250.0f, 360.0f, -90.0f, 90.0f, 0.1f, 1023.0f, 4095.0f, 2550.0f };
+  DATAF   Result;
+
+  if (rand() & 1)
+  {
+    Result  =  Limits[rand() % (int)(sizeof(Limits) / sizeof(Limits[0]))];
+  }
+  else
+  {
+    Result  =  ldexpf((DATAF)(rand() - RAND_MAX / 2) / (DATAF)RAND_MAX,(rand() % 40) - 20);
+  }
+
+  return (Result);
+}
+
+
+long      CheckSi(void)
+{
+  SCALE   Scale;
+  long    Errors = 0;
+  long    Run;
+  int     Min;
+  int     Max;
+  int     Raw;
+  DATAF   SiMin;
+  DATAF   SiMax;
+  DATAF   Old;
+  DATAF   New;
+  DATAF   Limit;
+  DATAF   WorstUlp = 0.0f;
+  DATAF   WorstOld = 0.0f;
+  DATAF   WorstNew = 0.0f;
+  long double Exact;
+
+  srand(1);
+  for (Run = 0;Run < SI_RUNS;Run++)
+  {
+    Min    =  (rand() % 4096) - ((rand() & 1) ? 2048 : 0);
+    Max    =  Min + (rand() % ((rand() & 1) ? 70000 : 1030)) - ((rand() & 3) ? 0 : 1030);
+    SiMin  =  RandomLimit();
+    SiMax  =  RandomLimit();
+    Raw    =  Min + (rand() % ((abs(Max - Min) * 2) + 3)) - abs(Max - Min) / 2 - 1;
+    if (Max == Min)
+    {
+      continue;
+    }
+
+    cScaleSetup(&Scale,(DATAF)Min,(DATAF)Max,0.0f,100.0f,SiMin,SiMax);
+    Old    =  OldSi((DATAF)Raw,(DATAF)Min,(DATAF)Max,SiMin,SiMax);
+    New    =  cScaleSi(&Scale,(DATAF)Raw);
+
+    Exact  =  ((long double)(Raw - Min) * ((long double)SiMax - (long double)SiMin)) / (long double)(Max - Min);
+    Limit  =  fabsf(SiMin);
+    if (fabsf(SiMax) > Limit)
+    {
+      Limit  =  fabsf(SiMax);
+    }
+    if (fabsl(Exact) > Limit)
+    {
+      Limit  =  (DATAF)fabsl(Exact);
+    }
+    Exact +=  (long double)SiMin;
+    if (Ulp(Limit) > 0.0f)
+    {
+      if ((fabsf(Old - New) / Ulp(Limit)) > WorstUlp)
+      {
+        WorstUlp  =  fabsf(Old - New) / Ulp(Limit);
+      }
+      if ((fabsl((long double)Old - Exact) / Ulp(Limit)) > WorstOld)
+      {
+        WorstOld  =  (DATAF)(fabsl((long double)Old - Exact) / Ulp(Limit));
+      }
+      if ((fabsl((long double)New - Exact) / Ulp(Limit)) > WorstNew)
+      {
+        WorstNew  =  (DATAF)(fabsl((long double)New - Exact) / Ulp(Limit));
+      }
+    }
+    if ((!Scale.SiInt) || (fabsf(Old - New) > (SI_ULP * Ulp(Limit))))
+    {
+      if (Errors < 10)
+      {
+        printf("Raw %d range %d..%d %g..%g: old %.9g new %.9g\n",Raw,Min,Max,SiMin,SiMax,Old,New);
+      }
+      Errors++;
+    }
+  }
+  printf("SI: %ld values, %ld errors, worst %.2f ULP (old %.2f ULP, new %.2f ULP from exact)\n",(long)SI_RUNS,Errors,WorstUlp,WorstOld,WorstNew);
+
+  return (Errors);
+}
+
+
+int       main(void)
+{
+  long    Errors;
+
+  Errors   =  CheckPct();
+  Errors  +=  CheckSi();
+
+  return ((Errors) ? 1 : 0);
+}